@@ -0,0 +1,389 @@
+/**
+ * @file: accuracy_stats.h
+ * @date: 10/16/2026
+ * @brief: Accuracy statistics of the Ublox receiver against the drone's position, taken as the reference. Each
+ *         receiver epoch is paired with the drone epoch nearest in UTC (time_align.h), and its error is the East,
+ *         North, Up vector from the drone to the receiver: the horizontal error is its length in the East-North
+ *         plane and the vertical error is Up. The epochs are summarized in one streaming pass into running moments
+ *         (mean, RMS) and quantile sketches (CEP50, CEP95, vertical 95%), overall and per 10 degree bin of the
+ *         elevation angle from the receiver to the drone. Nothing is kept per epoch, and two summaries are merged
+ *         exactly by adding them, so flights are combined into a campaign from their saved statistics files
+ *         without reading the flights again. parse_campaign.cc saves one per flight as "<SRT File>.stats", and
+ *         parse_ublox_csv.cc saves its run as "<input>.stats".
+ */
+
+#ifndef ACCURACY_STATS_H
+#define ACCURACY_STATS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "geodesy.h"
+#include "telemetry_store.h"
+#include "time_align.h"
+
+const double kSketchRelativeAccuracy = 0.01;   /// Every quantile is within 1% of a value that was added
+const double kSketchSmallestValue = 1e-6;       /// Errors below a micrometer are counted as zero
+const int kElevationBinCount = 9;               /// 10 degree bins from 0 to 90 degrees
+const int kElevationBinWidth = 10;
+
+class QuantileSketch{
+public:
+    QuantileSketch() : zeroCount(0), firstBucket(0) {}
+
+    void add(double value){
+        if (!(value > kSketchSmallestValue)){ /// Also catches NaN
+            zeroCount++;
+            return;
+        }
+        int bucket = static_cast<int>(std::ceil(std::log(value) * inverseLogGamma()));
+        grow(bucket);
+        counts[bucket - firstBucket]++;
+    }
+
+    void merge(const QuantileSketch &other){
+        zeroCount += other.zeroCount;
+        if (other.counts.empty()) return;
+        grow(other.firstBucket);
+        grow(other.firstBucket + static_cast<int>(other.counts.size()) - 1);
+        for (std::size_t i = 0; i < other.counts.size(); ++i) counts[other.firstBucket - firstBucket + i] += other.counts[i];
+    }
+
+    std::uint64_t count() const {
+        std::uint64_t total = zeroCount;
+        for (std::uint64_t bucketCount : counts) total += bucketCount;
+        return total;
+    }
+
+    double quantile(double q) const {
+        std::uint64_t total = count();
+        if (total == 0) return std::numeric_limits<double>::quiet_NaN();
+        std::uint64_t rank = static_cast<std::uint64_t>(q * (total - 1));
+        if (rank < zeroCount) return 0;
+        std::uint64_t seen = zeroCount;
+        for (std::size_t i = 0; i < counts.size(); ++i){
+            seen += counts[i];
+            if (seen > rank){ /// Midpoint of the bucket in relative terms, so its value is within the relative accuracy
+                double gamma = (1 + kSketchRelativeAccuracy) / (1 - kSketchRelativeAccuracy);
+                return 2 * std::pow(gamma, firstBucket + static_cast<int>(i)) / (gamma + 1);
+            }
+        }
+        return 0;
+    }
+
+    void write(std::ostream &outs) const { /// Only the buckets that hold values, as "bucket:count"
+        outs << zeroCount;
+        for (std::size_t i = 0; i < counts.size(); ++i){
+            if (counts[i] != 0) outs << ' ' << firstBucket + static_cast<int>(i) << ':' << counts[i];
+        }
+    }
+
+    bool read(std::istream &ins){
+        *this = QuantileSketch();
+        if (!(ins >> zeroCount)) return false;
+        int bucket;
+        char separator;
+        std::uint64_t bucketCount;
+        while (ins >> bucket >> separator >> bucketCount){
+            if (separator != ':' || bucket < -100000 || bucket > 100000) return false;
+            grow(bucket);
+            counts[bucket - firstBucket] += bucketCount;
+        }
+        return ins.eof();
+    }
+
+private:
+    static double inverseLogGamma(){
+        static const double value = 1 / std::log((1 + kSketchRelativeAccuracy) / (1 - kSketchRelativeAccuracy));
+        return value;
+    }
+
+    void grow(int bucket){ /// Extends the dense bucket range to cover bucket
+        if (counts.empty()){
+            firstBucket = bucket;
+            counts.assign(1, 0);
+        }
+        else if (bucket < firstBucket){
+            counts.insert(counts.begin(), static_cast<std::size_t>(firstBucket - bucket), 0);
+            firstBucket = bucket;
+        }
+        else if (bucket >= firstBucket + static_cast<int>(counts.size())) counts.resize(static_cast<std::size_t>(bucket - firstBucket + 1), 0);
+    }
+
+    std::uint64_t zeroCount;
+    int firstBucket;                    /// Bucket i holds values in (gamma^(i-1), gamma^i]
+    std::vector<std::uint64_t> counts;  /// Dense from firstBucket, a few hundred buckets span a millimeter to kilometers
+};
+/**
+ *  Class:      QuantileSketch
+ *              Logarithmic bucket sketch of non-negative values (DDSketch). Every value lands in the bucket of its
+ *              logarithm with base gamma = (1 + 0.01) / (1 - 0.01), so a quantile is reported within 1% of the true
+ *              value however many values are added, and two sketches merge exactly by adding their counts.
+ */
+
+struct RunningMoments{
+    std::uint64_t count = 0;
+    double mean = 0;
+    double sumOfSquaredDeviations = 0;  /// Welford's M2
+    double sumOfSquares = 0;
+    double minimum = std::numeric_limits<double>::infinity();
+    double maximum = -std::numeric_limits<double>::infinity();
+
+    void add(double value){
+        count++;
+        double delta = value - mean;
+        mean += delta / count;
+        sumOfSquaredDeviations += delta * (value - mean);
+        sumOfSquares += value * value;
+        minimum = std::fmin(minimum, value);
+        maximum = std::fmax(maximum, value);
+    }
+
+    void merge(const RunningMoments &other){ /// Chan's parallel update
+        if (other.count == 0) return;
+        std::uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        sumOfSquaredDeviations += other.sumOfSquaredDeviations + delta * delta * (static_cast<double>(count) * other.count / total);
+        mean += delta * other.count / total;
+        count = total;
+        sumOfSquares += other.sumOfSquares;
+        minimum = std::fmin(minimum, other.minimum);
+        maximum = std::fmax(maximum, other.maximum);
+    }
+
+    double rms() const { return count == 0 ? 0 : std::sqrt(sumOfSquares / count); }
+    double standardDeviation() const { return count < 2 ? 0 : std::sqrt(sumOfSquaredDeviations / (count - 1)); }
+};
+
+struct ErrorSummary{
+    RunningMoments moments;     /// Of the signed error
+    QuantileSketch magnitude;   /// Of its absolute value
+
+    void add(double error){
+        moments.add(error);
+        magnitude.add(std::fabs(error));
+    }
+    void merge(const ErrorSummary &other){
+        moments.merge(other.moments);
+        magnitude.merge(other.magnitude);
+    }
+};
+
+struct AccuracyBin{
+    ErrorSummary horizontal;
+    ErrorSummary vertical;
+};
+
+struct AccuracyStatistics{
+    AccuracyBin all;
+    AccuracyBin elevation[kElevationBinCount];  /// Epochs below the horizon are counted in the first bin
+
+    void add(double east, double north, double up, double elevationAngle){
+        double horizontal = std::sqrt(east * east + north * north);
+        int bin = static_cast<int>(elevationAngle / kElevationBinWidth);
+        bin = bin < 0 ? 0 : (bin >= kElevationBinCount ? kElevationBinCount - 1 : bin);
+        all.horizontal.add(horizontal);
+        all.vertical.add(up);
+        elevation[bin].horizontal.add(horizontal);
+        elevation[bin].vertical.add(up);
+    }
+
+    void merge(const AccuracyStatistics &other){
+        all.horizontal.merge(other.all.horizontal);
+        all.vertical.merge(other.all.vertical);
+        for (int bin = 0; bin < kElevationBinCount; ++bin){
+            elevation[bin].horizontal.merge(other.elevation[bin].horizontal);
+            elevation[bin].vertical.merge(other.elevation[bin].vertical);
+        }
+    }
+
+    std::uint64_t count() const { return all.horizontal.moments.count; }
+};
+/**
+ *  Struct:     AccuracyStatistics
+ *              Horizontal and vertical error summaries of a flight or a campaign, overall and per elevation bin
+ */
+
+inline void writeErrorSummary(std::ostream &outs, const char *name, int bin, const ErrorSummary &summary){
+    const RunningMoments &moments = summary.moments;
+    outs << name << ' ' << bin << ' ' << moments.count << ' ' << moments.mean << ' ' << moments.sumOfSquaredDeviations << ' '
+         << moments.sumOfSquares << ' ';
+    if (moments.count == 0) outs << "0 0 "; /// An empty summary has infinite bounds, which istream cannot read back
+    else outs << moments.minimum << ' ' << moments.maximum << ' ';
+    summary.magnitude.write(outs);
+    outs << '\n';
+}
+
+inline bool writeAccuracyStatistics(const AccuracyStatistics &statistics, const std::string &fileName){
+    std::string temporaryFileName = fileName + ".tmp";
+    std::ofstream outs(temporaryFileName);
+    outs << std::setprecision(17);
+    outs << "# accuracy statistics 1: summary bin count mean m2 sum-of-squares min max zero-count bucket:count..." << '\n';
+    for (int bin = -1; bin < kElevationBinCount; ++bin){ /// Bin -1 is every epoch
+        const AccuracyBin &summary = bin < 0 ? statistics.all : statistics.elevation[bin];
+        writeErrorSummary(outs, "horizontal", bin, summary.horizontal);
+        writeErrorSummary(outs, "vertical", bin, summary.vertical);
+    }
+    outs.close();
+    if (outs.fail() || std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0){
+        std::remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+/**
+ *  Function:   writeAccuracyStatistics
+ *              Saves the moments and sketches of every summary as text, so they can be merged later
+ *
+ *  @return false if the file could not be written
+ */
+
+inline bool readAccuracyStatistics(AccuracyStatistics &statistics, const std::string &fileName){
+    std::ifstream ins(fileName);
+    if (ins.fail()) return false;
+    statistics = AccuracyStatistics();
+    std::string line;
+    int summaries = 0;
+    while (getline(ins, line)){
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        int bin;
+        if (!(fields >> name >> bin) || bin < -1 || bin >= kElevationBinCount || (name != "horizontal" && name != "vertical")) return false;
+        AccuracyBin &summary = bin < 0 ? statistics.all : statistics.elevation[bin];
+        ErrorSummary &error = name == "horizontal" ? summary.horizontal : summary.vertical;
+        RunningMoments &moments = error.moments;
+        if (!(fields >> moments.count >> moments.mean >> moments.sumOfSquaredDeviations >> moments.sumOfSquares
+                     >> moments.minimum >> moments.maximum) || !error.magnitude.read(fields)) return false;
+        if (moments.count == 0) moments = RunningMoments();
+        summaries++;
+    }
+    return summaries == 2 * (kElevationBinCount + 1);
+}
+/**
+ *  Function:   readAccuracyStatistics
+ *              Reads a file written by writeAccuracyStatistics
+ *
+ *  @return false if the file is missing or is not a complete statistics file
+ */
+
+inline bool writeAccuracySummary(const AccuracyStatistics &statistics, const std::string &fileName){
+    std::ofstream outs(fileName);
+    if (outs.fail()) return false;
+    outs << "Elevation, Epochs, Horizontal Mean, Horizontal RMS, CEP50, CEP95, Horizontal Max, "
+            "Vertical Mean, Vertical Std Dev, Vertical RMS, Vertical 50%, Vertical 95%" << '\n';
+    outs << std::setprecision(3) << std::fixed;
+    for (int bin = -1; bin < kElevationBinCount; ++bin){
+        const AccuracyBin &summary = bin < 0 ? statistics.all : statistics.elevation[bin];
+        const RunningMoments &horizontal = summary.horizontal.moments, &vertical = summary.vertical.moments;
+        if (bin < 0) outs << "All";
+        else outs << bin * kElevationBinWidth << "-" << (bin + 1) * kElevationBinWidth;
+        outs << ", " << horizontal.count;
+        if (horizontal.count == 0){
+            outs << ", , , , , , , , , ," << '\n';
+            continue;
+        }
+        outs << ", " << horizontal.mean << ", " << horizontal.rms() << ", " << summary.horizontal.magnitude.quantile(0.5)
+             << ", " << summary.horizontal.magnitude.quantile(0.95) << ", " << horizontal.maximum << ", " << vertical.mean
+             << ", " << vertical.standardDeviation() << ", " << vertical.rms() << ", " << summary.vertical.magnitude.quantile(0.5)
+             << ", " << summary.vertical.magnitude.quantile(0.95) << '\n';
+    }
+    outs.close();
+    return !outs.fail();
+}
+/**
+ *  Function:   writeAccuracySummary
+ *              Writes one CSV row per elevation bin, plus an "All" row, with the errors in meters. CEP50 and CEP95
+ *              are the 50th and 95th percentiles of the horizontal error, within 1% (QuantileSketch).
+ *
+ *  @return false if the file could not be written
+ */
+
+template <class ReceiverSource, class DroneSource>
+long long accumulateAccuracy(ReceiverSource nextReceiver, DroneSource nextDrone, std::int64_t tolerance, AccuracyStatistics &statistics){
+    ScopedStageTimer timer("accuracy statistics");
+    std::uint64_t receiverEpochs = 0;
+    double receiverLatitude[kGeodesyBatchSize], receiverLongitude[kGeodesyBatchSize], receiverAltitude[kGeodesyBatchSize];
+    double droneLatitude[kGeodesyBatchSize], droneLongitude[kGeodesyBatchSize], droneAltitude[kGeodesyBatchSize];
+    double receiverX[kGeodesyBatchSize], receiverY[kGeodesyBatchSize], receiverZ[kGeodesyBatchSize];
+    double droneX[kGeodesyBatchSize], droneY[kGeodesyBatchSize], droneZ[kGeodesyBatchSize];
+    double east[kGeodesyBatchSize], north[kGeodesyBatchSize], up[kGeodesyBatchSize];
+    double heading[kGeodesyBatchSize], elevation[kGeodesyBatchSize], slantDistance[kGeodesyBatchSize];
+    std::size_t pending = 0;
+    auto flush = [&](){
+        llhToEcef(receiverLatitude, receiverLongitude, receiverAltitude, receiverX, receiverY, receiverZ, pending);
+        llhToEcef(droneLatitude, droneLongitude, droneAltitude, droneX, droneY, droneZ, pending);
+        /// The receiver is the origin of the look angles, and the drone the origin of the error
+        ecefToEnu(receiverX, receiverY, receiverZ, receiverLatitude, receiverLongitude, droneX, droneY, droneZ, east, north, up, pending);
+        lookAnglesFromEnu(east, north, up, heading, elevation, slantDistance, pending);
+        ecefToEnu(droneX, droneY, droneZ, droneLatitude, droneLongitude, receiverX, receiverY, receiverZ, east, north, up, pending);
+        for (std::size_t i = 0; i < pending; ++i) statistics.add(east[i], north[i], up[i], elevation[i]);
+        pending = 0;
+    };
+    TimeAligner<AlignedEpoch> aligner(tolerance, [&](const AlignedEpoch &epoch, const AlignedEpoch *match){
+        if (match == nullptr) return;
+        receiverLatitude[pending] = epoch.latitude;
+        receiverLongitude[pending] = epoch.longitude;
+        receiverAltitude[pending] = epoch.altitude;
+        droneLatitude[pending] = match->latitude;
+        droneLongitude[pending] = match->longitude;
+        droneAltitude[pending] = match->altitude;
+        if (++pending == kGeodesyBatchSize) flush();
+    });
+    TelemetryRecord entry;
+    auto toEpoch = [&](AlignedEpoch &epoch){
+        epoch.time = entry.time;
+        epoch.index = 0;
+        epoch.latitude = entry.latitude;
+        epoch.longitude = entry.longitude;
+        epoch.altitude = entry.altitude;
+        return true;
+    };
+    mergeJoinByTime<AlignedEpoch>(
+        [&](AlignedEpoch &epoch){ return nextReceiver(entry) && ++receiverEpochs && toEpoch(epoch); },
+        [&](AlignedEpoch &epoch){ return nextDrone(entry) && toEpoch(epoch); }, aligner);
+    flush();
+    timer.count(receiverEpochs);
+    return aligner.unmatchedCount();
+}
+/**
+ *  Function:   accumulateAccuracy
+ *              Pairs every receiver epoch with the nearest drone epoch in UTC and adds its error to the statistics.
+ *              Both platforms are streamed and the pairs are converted in batches of kGeodesyBatchSize, so memory
+ *              does not grow with the flight.
+ *
+ *  @param nextReceiver - callable bool(TelemetryRecord &) that writes the next receiver epoch in UTC, or returns false at the end
+ *  @param nextDrone - callable bool(TelemetryRecord &) that writes the next drone epoch in UTC, or returns false at the end
+ *  @param tolerance - largest time difference in microseconds that still pairs two epochs
+ *  @param statistics - summaries the errors are added to
+ *  @return number of receiver epochs without a drone epoch within the tolerance
+ */
+
+inline long long accumulateAccuracy(const TelemetryStore &receiver, const TelemetryStore &drone, std::int64_t tolerance,
+                                    AccuracyStatistics &statistics){
+    std::size_t nextReceiver = 0, nextDrone = 0;
+    return accumulateAccuracy(
+        [&](TelemetryRecord &entry){
+            if (nextReceiver == receiver.size()) return false;
+            entry = receiver.record(nextReceiver++);
+            return true;
+        },
+        [&](TelemetryRecord &entry){
+            if (nextDrone == drone.size()) return false;
+            entry = drone.record(nextDrone++);
+            return true;
+        }, tolerance, statistics);
+}
+/**
+ *  Function:   accumulateAccuracy
+ *              Same as above for two stores that are already in memory, both with UTC times
+ */
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file: bench_stages.cc
+ * @date: 10/16/2026
+ * @brief: This program times each stage of the tools on its own, so a change that slows one of them shows up in its
+ * own number instead of in a whole run: SRT parse, one second decimation, drone CSV write, u-center CSV parse,
+ * geometry (pairing every frame with a receiver epoch and computing its look angles), and KML write. The inputs are
+ * a synthetic flight made in memory (synthetic_flight.h), or a real SRT File and u-center CSV File when they are
+ * given. Every stage is run --repeat times and the fastest run is reported with its records per second and, for
+ * stages that read or write text, bytes per second. Output files go to the system's temporary folder and are
+ * removed at the end, so nothing but the compiler and a Linux box is needed.
+ * With --csv the results are printed as CSV rows, which can be appended to a log to follow throughput over time.
+ * Usage: bench_stages [--repeat count] [-j threads] [--csv] [--seconds seconds] [--frame-rate Hz] [--receiver-rate Hz]
+ * [--layout mavic2|phantom4|position-first] [--columns minimal|full] [--seed number] [SRT File u-center CSV File]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include "mapped_file.h"
+#include "telemetry_store.h"
+#include "srt_parser.h"
+#include "drone_csv.h"
+#include "ublox_csv.h"
+#include "time_align.h"
+#include "kml_writer.h"
+#include "synthetic_flight.h"
+using namespace std;
+namespace fs = std::filesystem;
+
+struct StageResult{
+    string name;
+    double seconds;         /// Fastest run
+    size_t records;
+    size_t bytes;           /// Text read or written, or 0 for stages that only work in memory
+};
+
+template <class Stage>
+StageResult timeStage(const string &name, int repeat, Stage runStage){
+    StageResult result{name, 0, 0, 0};
+    for (int run = 0; run < repeat; ++run){
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        runStage(result.records, result.bytes);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (run == 0 || seconds < result.seconds) result.seconds = seconds;
+    }
+    return result;
+}
+/**
+ *  Function:   timeStage
+ *              Runs a stage repeat times and keeps the fastest run, which is the least disturbed by the rest of
+ *              the machine
+ *
+ *  @param name - name printed for the stage
+ *  @param repeat - number of runs
+ *  @param runStage - callable that runs the stage once and sets the record and byte counts it handled
+ *  @return time and counts of the stage
+ */
+
+void printResults(const vector<StageResult> &results, bool csv);
+/**
+ *  Function:   printResults
+ *              Prints one line per stage, as a table or as CSV rows
+ */
+
+int main(int argc, char *argv[]){
+    SyntheticFlightOptions flightOptions;
+    flightOptions.seconds = 3600;
+    int repeat = 5;
+    unsigned threadCount = 1;
+    bool csv = false;
+    vector<string> inputFileNames;
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if (parseSyntheticFlightOption(i, argc, argv, flightOptions)) continue;
+        if (argument == "--repeat" && i + 1 < argc) repeat = max(1, atoi(argv[++i]));
+        else if (argument == "-j" && i + 1 < argc) threadCount = static_cast<unsigned>(atoi(argv[++i]));
+        else if (argument == "--csv") csv = true;
+        else if (argument[0] != '-' && inputFileNames.size() < 2) inputFileNames.push_back(argument);
+        else {
+            cout << "Usage: bench_stages [--repeat count] [-j threads] [--csv] [--seconds seconds] [--frame-rate Hz] [--receiver-rate Hz] [--layout mavic2|phantom4|position-first] [--columns minimal|full] [--seed number] [srt_file ublox_csv]" << endl;
+            exit(0);
+        }
+    }
+    if (inputFileNames.size() == 1){
+        cout << "Give both the SRT File and the u-center CSV File, or neither." << endl;
+        exit(0);
+    }
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    string generatedSrt, generatedUblox;
+    MappedFile srtFile, ubloxFile;
+    const char *srtBegin, *srtEnd, *ubloxBegin, *ubloxEnd;
+    if (inputFileNames.empty()){
+        generateSyntheticSrt(flightOptions, generatedSrt);
+        generateSyntheticUbloxCsv(flightOptions, generatedUblox);
+        srtBegin = generatedSrt.data();
+        srtEnd = srtBegin + generatedSrt.size();
+        ubloxBegin = generatedUblox.data();
+        ubloxEnd = ubloxBegin + generatedUblox.size();
+    }
+    else {
+        srtFile.open(inputFileNames[0]);
+        ubloxFile.open(inputFileNames[1]);
+        if (srtFile.fail() || ubloxFile.fail()){
+            cout << "Error opening the input files." << endl;
+            exit(0);
+        }
+        srtBegin = srtFile.begin();
+        srtEnd = srtFile.end();
+        ubloxBegin = ubloxFile.begin();
+        ubloxEnd = ubloxFile.end();
+    }
+    fs::path csvFile = fs::temp_directory_path() / ("bench_stages " + to_string(getpid()) + " CSV.csv");
+    fs::path kmlFile = fs::temp_directory_path() / ("bench_stages " + to_string(getpid()) + ".kml");
+
+    TelemetryStore droneData, droneDataPerSecond, receiverData;
+    vector<StageResult> results;
+    results.push_back(timeStage(threadCount > 1 ? "SRT parse -j " + to_string(threadCount) : "SRT parse", repeat, [&](size_t &records, size_t &bytes){
+        droneData.clear();
+        if (threadCount > 1) loadSrtParallel(droneData, srtBegin, srtEnd, threadCount);
+        else loadSrt(droneData, srtBegin, srtEnd);
+        records = droneData.size();
+        bytes = srtEnd - srtBegin;
+    }));
+    if (droneData.empty()){
+        cout << "The SRT File has no telemetry entries." << endl;
+        exit(0);
+    }
+    results.push_back(timeStage("1 s decimation", repeat, [&](size_t &records, size_t &){
+        droneDataPerSecond.clear();
+        decimateToSeconds(droneDataPerSecond, droneData);
+        records = droneData.size();
+    }));
+    results.push_back(timeStage("drone CSV write", repeat, [&](size_t &records, size_t &bytes){
+        if (!writeDroneCsv(droneData, csvFile.string())){
+            cout << "Error writing " << csvFile.string() << "." << endl;
+            exit(0);
+        }
+        records = droneData.size();
+        bytes = fs::file_size(csvFile);
+    }));
+    results.push_back(timeStage("u-center CSV parse", repeat, [&](size_t &records, size_t &bytes){
+        receiverData.clear();
+        if (loadUbloxCsv(receiverData, ubloxBegin, ubloxEnd) < 0){
+            cout << "The u-center CSV File is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+            exit(0);
+        }
+        records = receiverData.size();
+        bytes = ubloxEnd - ubloxBegin;
+    }));
+    AlignmentOptions alignmentOptions;
+    applyClockOffset(droneData, alignmentOptions.droneClockOffset);
+    results.push_back(timeStage("geometry", repeat, [&](size_t &records, size_t &){
+        size_t next = 0;
+        alignLookAngles(droneData, [&](TelemetryRecord &entry){
+            if (next == receiverData.size()) return false;
+            entry = receiverData.record(next++);
+            return true;
+        }, true, alignmentOptions.tolerance);
+        records = droneData.size();
+    }));
+    results.push_back(timeStage("KML write", repeat, [&](size_t &records, size_t &bytes){
+        KmlWriter outs;
+        outs.open(kmlFile.string(), false);
+        if (outs.fail() || !writeKmlDocument(droneData, outs, kDroneTrackFormat)){
+            cout << "Error writing " << kmlFile.string() << "." << endl;
+            exit(0);
+        }
+        records = droneData.size();
+        bytes = fs::file_size(kmlFile);
+    }));
+    error_code ignored;
+    fs::remove(csvFile, ignored);
+    fs::remove(kmlFile, ignored);
+
+    if (!csv){
+        cout << (inputFileNames.empty() ? "Synthetic flight: " : inputFileNames[0] + " and " + inputFileNames[1] + ": ")
+             << droneData.size() << " frames, " << receiverData.size() << " receiver epochs, best of " << repeat << " runs" << endl;
+    }
+    printResults(results, csv);
+    return EXIT_SUCCESS;
+}
+
+void printResults(const vector<StageResult> &results, bool csv){
+    if (csv) cout << "Stage, Seconds, Records, Records per Second, Bytes, MB per Second" << endl;
+    else cout << left << setw(22) << "Stage" << right << setw(12) << "ms" << setw(12) << "Records" << setw(16) << "Records/s"
+              << setw(14) << "MB/s" << endl;
+    for (const StageResult &result : results){
+        double recordRate = result.seconds > 0 ? result.records / result.seconds : 0;
+        double byteRate = result.seconds > 0 ? result.bytes / result.seconds / 1e6 : 0;
+        if (csv){
+            cout << fixed << setprecision(6) << result.name << ", " << result.seconds << ", " << result.records << ", "
+                 << setprecision(0) << recordRate << ", " << result.bytes << ", " << setprecision(3) << byteRate << endl;
+            continue;
+        }
+        cout << left << setw(22) << result.name << right << fixed << setprecision(3) << setw(12) << result.seconds * 1000
+             << setw(12) << result.records << setprecision(0) << setw(16) << recordRate;
+        if (result.bytes > 0) cout << setprecision(1) << setw(14) << byteRate << endl;
+        else cout << setw(14) << "-" << endl;
+    }
+}
@@ -0,0 +1,257 @@
+/**
+ * @file: campaign_query.cc
+ * @date: 10/16/2026
+ * @brief: This program searches every flight of a campaign by place and time: the drone frames and receiver epochs
+ * within a distance of a point, or the ones nearest a point, optionally inside a UTC window and an altitude band.
+ * It reads "Campaign Index.catalog", which parse_campaign.cc writes with a spatial index segment per SRT File and
+ * receiver file (spatial_index.h), skips the segments whose time span or bounding box cannot hold a match, and
+ * memory maps the segments that are left. Each segment is a packed R-tree, so a query descends only into the
+ * nodes whose bounding box and time span can hold a match, and a query over millions of epochs takes
+ * milliseconds. A time of day without a date is taken on the day of each flight, so "14:00:00 14:10:00" means
+ * that window on every flight.
+ * Queries are given after the catalog or, when there are none, read from standard input one per line:
+ *     within <latitude> <longitude> <meters> [<first UTC> <last UTC>]
+ *     nearest <latitude> <longitude> [<count>] [<first UTC> <last UTC>]
+ * Times are hh:mm:ss.ffffff or yyyy-mm-ddThh:mm:ss.ffffffZ, and count defaults to 1. Results are written as CSV
+ * rows to standard output, or to the file given with -o, and each row starts with the number of the query it
+ * answers. Matches of within are in flight and time order, and those of nearest by distance.
+ * --drone and --receiver search only that platform, and --altitude keeps the epochs between two altitudes in meters.
+ * --metrics <file> writes the time and counts of each stage and the peak memory of the run as JSON (run_metrics.h).
+ * Usage: campaign_query [--drone | --receiver] [--altitude min max] [--metrics file] [-o output file]
+ * <campaign folder or catalog> [query ...]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include "telemetry_store.h"
+#include "frame_index.h"
+#include "spatial_index.h"
+#include "run_metrics.h"
+using namespace std;
+namespace fs = std::filesystem;
+
+const char kCampaignQueryHeader[] = "Query, Segment, Platform, Frame, Date, Time, Latitude, Longitude, Altitude, Distance\n";
+
+class CampaignSegments{
+public:
+    CampaignSegments(vector<SpatialCatalogEntry> entries) : entries(std::move(entries)), indexes(this->entries.size()) {}
+
+    size_t size() const { return entries.size(); }
+    const SpatialCatalogEntry &entry(size_t segment) const { return entries[segment]; }
+
+    const SpatialIndex *index(size_t segment){ /// Opens a segment the first time a query reaches it
+        if (!indexes[segment]){
+            indexes[segment].reset(new SpatialIndex);
+            if (!indexes[segment]->open(entries[segment].path))
+                cerr << "Error opening " << entries[segment].path << "; run parse_campaign again." << endl;
+            else countRunMetric("segments opened", 1);
+        }
+        return indexes[segment].get();
+    }
+
+private:
+    vector<SpatialCatalogEntry> entries;
+    vector<unique_ptr<SpatialIndex>> indexes;
+};
+/**
+ *  Class:      CampaignSegments
+ *              The catalog's segments, each mapped on first use and kept open for the queries that follow
+ */
+
+struct QueryOptions{
+    bool drone = true;
+    bool receiver = true;
+    double minAltitude = -numeric_limits<double>::infinity();
+    double maxAltitude = numeric_limits<double>::infinity();
+};
+
+void readCatalog(vector<SpatialCatalogEntry> &entries, const string &campaignName);
+/**
+ *  Function:   readCatalog
+ *              Reads the catalog of a campaign folder, or a catalog named directly
+ *
+ *  @param entries - vector that will be written with one entry per segment
+ *  @param campaignName - campaign folder or catalog file
+ */
+
+bool runQuery(CampaignSegments &segments, const QueryOptions &options, ostream &outs, long long queryNumber, const string &query);
+/**
+ *  Function:   runQuery
+ *              Answers one "within" or "nearest" query and writes its rows
+ *
+ *  @param segments - segments of the campaign
+ *  @param options - platforms and altitude band searched
+ *  @param outs - stream the rows are written to
+ *  @param queryNumber - number written at the start of each of the query's rows
+ *  @param query - text of the query
+ *  @return false if the query could not be read
+ */
+
+int main(int argc, char *argv[]){
+    string campaignName;
+    string outputFileName;
+    vector<string> queries;
+    QueryOptions options;
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if (argument == "--drone") options.receiver = false;
+        else if (argument == "--receiver") options.drone = false;
+        else if (argument == "--altitude" && i + 2 < argc){
+            options.minAltitude = atof(argv[++i]);
+            options.maxAltitude = atof(argv[++i]);
+        }
+        else if (argument == "-o" && i + 1 < argc) outputFileName = argv[++i];
+        else if (parseMetricsOption(i, argc, argv)) continue;
+        else if (argument == "within" || argument == "nearest"){
+            string query = argument;
+            while (i + 1 < argc && string(argv[i + 1]) != "within" && string(argv[i + 1]) != "nearest") query += string(" ") + argv[++i];
+            queries.push_back(query);
+        }
+        else if (campaignName.empty() && argument[0] != '-') campaignName = argument;
+        else {
+            cerr << "Usage: campaign_query [--drone | --receiver] [--altitude min max] [--metrics file] [-o output file] <campaign folder or catalog> [query ...]" << endl;
+            exit(0);
+        }
+    }
+    if (!options.drone && !options.receiver){
+        cerr << "Give --drone or --receiver, not both." << endl;
+        exit(0);
+    }
+    if (campaignName.empty()){
+        cerr << "Enter name of campaign folder or catalog: ";
+        cin >> campaignName;
+        cin.ignore();
+    }
+    vector<SpatialCatalogEntry> entries;
+    readCatalog(entries, campaignName);
+    CampaignSegments segments(std::move(entries));
+
+    ofstream outputFileStream;
+    if (!outputFileName.empty()){
+        outputFileStream.open(outputFileName);
+        if (outputFileStream.fail()){
+            cerr << "Error opening output file." << endl;
+            exit(0);
+        }
+    }
+    ostream &outs = outputFileName.empty() ? cout : outputFileStream;
+    outs << setprecision(6) << fixed << kCampaignQueryHeader;
+    ScopedStageTimer timer("queries");
+    long long queryCount = 0, failedQueries = 0;
+    if (!queries.empty()){
+        for (const string &query : queries) failedQueries += !runQuery(segments, options, outs, ++queryCount, query);
+    }
+    else {
+        string query;
+        while (getline(cin, query)){
+            if (query.empty() || query[0] == '#') continue;
+            failedQueries += !runQuery(segments, options, outs, ++queryCount, query);
+        }
+    }
+    outs.flush();
+    timer.count(queryCount);
+    countRunMetric("failed queries", failedQueries);
+    if (failedQueries > 0) cerr << failedQueries << " of " << queryCount << " queries were malformed." << endl;
+    if (outs.fail()){
+        cerr << "Error writing the output file." << endl;
+        exit(0);
+    }
+    return 0;
+}
+
+void readCatalog(vector<SpatialCatalogEntry> &entries, const string &campaignName){
+    error_code error;
+    fs::path catalogFile = fs::is_directory(campaignName, error) ? fs::path(campaignName) / kSpatialCatalogName : fs::path(campaignName);
+    if (!fs::is_regular_file(catalogFile, error)){
+        cerr << "Error opening " << catalogFile.string() << "; run parse_campaign on the campaign first." << endl;
+        exit(0);
+    }
+    if (!readSpatialCatalog(catalogFile.string(), entries)){
+        cerr << catalogFile.string() << " is not a campaign index catalog." << endl;
+        exit(0);
+    }
+}
+
+/// Reads a whole field as a number
+static bool parseNumber(const string &text, double &value){
+    return !text.empty() && from_chars(text.data(), text.data() + text.size(), value).ptr == text.data() + text.size();
+}
+
+bool runQuery(CampaignSegments &segments, const QueryOptions &options, ostream &outs, long long queryNumber, const string &query){
+    istringstream fields(query);
+    string kind, latitude, longitude, field;
+    vector<string> rest;
+    fields >> kind >> latitude >> longitude;
+    while (fields >> field) rest.push_back(field);
+    SpatialQuery search;
+    search.minAltitude = options.minAltitude;
+    search.maxAltitude = options.maxAltitude;
+    if (!parseNumber(latitude, search.latitude) || !parseNumber(longitude, search.longitude)) return false;
+    double wanted = 1;
+    if (kind == "within"){
+        if (rest.empty() || !parseNumber(rest[0], search.radius) || search.radius < 0) return false;
+        rest.erase(rest.begin());
+    }
+    else if (kind == "nearest"){
+        if (rest.size() % 2 == 1 && (!parseNumber(rest[0], wanted) || wanted < 1)) return false;
+        if (rest.size() % 2 == 1) rest.erase(rest.begin());
+    }
+    else return false;
+    if (rest.size() != 0 && rest.size() != 2) return false;
+    int64_t time;
+    if (rest.size() == 2 && (!parseUtcTime(rest[0], 0, time) || !parseUtcTime(rest[1], 0, time))) return false;
+
+    vector<SpatialMatch> matches;
+    vector<pair<double, uint32_t>> order; /// Segments that can hold a match, nearest bounding box first
+    for (size_t segment = 0; segment < segments.size(); ++segment){
+        const SpatialIndexHeader &header = segments.entry(segment).header;
+        bool drone = static_cast<SpatialPlatform>(header.platform) == SpatialPlatform::Drone;
+        if ((drone && !options.drone) || (!drone && !options.receiver)) continue;
+        double distance = spatialBoundsDistance(header, search.latitude, search.longitude);
+        if (distance <= search.radius) order.push_back(make_pair(distance, static_cast<uint32_t>(segment)));
+    }
+    sort(order.begin(), order.end());
+    for (const pair<double, uint32_t> &candidate : order){
+        if (kind == "nearest" && matches.size() == static_cast<size_t>(wanted) && matches.back().distance <= candidate.first) break;
+        const SpatialIndexHeader &header = segments.entry(candidate.second).header;
+        if (rest.size() == 2){ /// A bare time of day is on the day of this flight
+            parseUtcTime(rest[0], header.minTime, search.begin);
+            parseUtcTime(rest[1], header.minTime, search.end);
+        }
+        if (search.begin > header.maxTime || search.end < header.minTime) continue;
+        const SpatialIndex *index = segments.index(candidate.second);
+        if (index->empty()) continue;
+        if (kind == "within") index->within(search, candidate.second, matches);
+        else index->nearest(search, static_cast<size_t>(wanted), candidate.second, matches);
+    }
+    if (kind == "within"){
+        sort(matches.begin(), matches.end(), [&](const SpatialMatch &a, const SpatialMatch &b){
+            if (a.segment != b.segment) return a.segment < b.segment;
+            return segments.index(a.segment)->time()[a.row] < segments.index(b.segment)->time()[b.row];
+        });
+    }
+    for (const SpatialMatch &match : matches){
+        const SpatialIndex &index = *segments.index(match.segment);
+        const SpatialCatalogEntry &entry = segments.entry(match.segment);
+        string source = entry.indexFileName.substr(0, entry.indexFileName.size() - (entry.indexFileName.size() >= 8 ? 8 : 0)); /// Without ".spatial"
+        char date[16], clock[16];
+        *formatDate(index.time()[match.row], date) = '\0';
+        *formatTimeOfDay(index.time()[match.row], 6, clock) = '\0';
+        outs << queryNumber << ", \"" << source << "\", " << spatialPlatformName(static_cast<SpatialPlatform>(entry.header.platform))
+             << ", " << index.frame()[match.row] << ", " << date << ", " << clock << ", " << setprecision(8) << index.latitude()[match.row]
+             << ", " << index.longitude()[match.row] << ", " << setprecision(3) << index.altitude()[match.row] << ", "
+             << match.distance << '\n';
+    }
+    countRunMetric("matches", static_cast<long long>(matches.size()));
+    return true;
+}
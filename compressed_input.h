@@ -0,0 +1,319 @@
+/**
+ * @file: compressed_input.h
+ * @date: 10/16/2026
+ * @brief: Decoding of gzip and zstd compressed inputs, so archived SRT Files, u-center CSV Files, and UBX logs are
+ *         read as they are instead of being decompressed to disk first. A file is recognized by its magic bytes,
+ *         not its name. InputDecoder inflates the mapped file into the caller's buffer a piece at a time.
+ *         BackgroundDecoder runs it on its own thread into an anonymous mapping that is reserved for the whole
+ *         output up front, so the decoded bytes never move and a parser can read the part that is done while the
+ *         rest is still being decoded. Only pages that are written take memory. gzip needs zlib (-lz, as for the
+ *         KMZ output of kml_writer.h) and zstd needs zstd.h and -lzstd; without them such files fail to open.
+ *         A stream that is truncated or corrupt keeps what was decoded before the damage, like a truncated text
+ *         file, and a warning is printed.
+ */
+
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include "run_metrics.h"
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define COMPRESSED_INPUT_HAS_ZLIB 1
+#endif
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define COMPRESSED_INPUT_HAS_ZSTD 1
+#endif
+
+const std::size_t kDecodeStep = 1 << 20;            /// Bytes decoded between two hand-offs to the parser
+const std::size_t kDecodeLead = 32 << 20;           /// Bytes decoded ahead of a reader that releases what it has read
+const std::uint64_t kDeflateMaxRatio = 1032;        /// Largest expansion deflate allows
+const std::uint64_t kZstdMaxRatio = 32768;          /// Reservation bound per compressed byte when a zstd frame does not give its size
+const std::uint64_t kMaxDecodeReservation = std::uint64_t(1) << 44;
+
+enum class InputCompression { None, Gzip, Zstd };
+
+inline InputCompression detectCompression(const char *begin, std::size_t length){
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(begin);
+    if (length >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) return InputCompression::Gzip;
+    if (length >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) return InputCompression::Zstd;
+    return InputCompression::None;
+}
+/**
+ *  Function:   detectCompression
+ *              Tells a gzip member (1f 8b) or a zstd frame (28 b5 2f fd) from plain text or a UBX log by its first bytes
+ */
+
+inline const char *compressionName(InputCompression kind){ return kind == InputCompression::Gzip ? "gzip" : "zstd"; }
+
+class InputDecoder{
+public:
+    InputDecoder() : kind(InputCompression::None), input(nullptr), inputLength(0), opened(false), finished(false), failed(false) {}
+    ~InputDecoder(){ close(); }
+    InputDecoder(const InputDecoder &) = delete;
+    InputDecoder &operator=(const InputDecoder &) = delete;
+
+    bool open(InputCompression compression, const char *begin, std::size_t length){
+        close();
+        kind = compression;
+        input = begin;
+        inputLength = length;
+        finished = failed = false;
+        if (kind == InputCompression::Gzip){
+#ifdef COMPRESSED_INPUT_HAS_ZLIB
+            std::memset(&gzip, 0, sizeof(gzip));
+            opened = inflateInit2(&gzip, 15 + 16) == Z_OK; /// 15 bit window, gzip header and trailer
+#endif
+        }
+        else if (kind == InputCompression::Zstd){
+#ifdef COMPRESSED_INPUT_HAS_ZSTD
+            zstd = ZSTD_createDStream();
+            opened = zstd != nullptr && !ZSTD_isError(ZSTD_initDStream(zstd));
+            zstdInput = ZSTD_inBuffer{begin, length, 0};
+            zstdPending = 1;
+#endif
+        }
+        return opened;
+    }
+
+    std::size_t decode(char *output, std::size_t capacity){
+        if (!opened || finished || failed) return 0;
+#ifdef COMPRESSED_INPUT_HAS_ZLIB
+        if (kind == InputCompression::Gzip){
+            gzip.next_out = reinterpret_cast<Bytef *>(output);
+            gzip.avail_out = static_cast<uInt>(std::min<std::size_t>(capacity, 1u << 30));
+            std::size_t room = gzip.avail_out;
+            while (gzip.avail_out > 0){
+                std::size_t position = gzip.next_in == nullptr ? 0 : reinterpret_cast<const char *>(gzip.next_in) - input;
+                if (gzip.avail_in == 0){
+                    if (position == inputLength){ /// The member has not ended
+                        failed = true;
+                        break;
+                    }
+                    gzip.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input + position));
+                    gzip.avail_in = static_cast<uInt>(std::min<std::size_t>(inputLength - position, 1u << 30));
+                }
+                int result = inflate(&gzip, Z_NO_FLUSH);
+                if (result == Z_STREAM_END){
+                    position = reinterpret_cast<const char *>(gzip.next_in) - input;
+                    if (detectCompression(input + position, inputLength - position) != InputCompression::Gzip){
+                        finished = true; /// Trailing padding after the last member is ignored, as gzip does
+                        break;
+                    }
+                    inflateReset(&gzip); /// Concatenated members decode as one stream
+                }
+                else if (result != Z_OK){
+                    failed = true;
+                    break;
+                }
+            }
+            return room - gzip.avail_out;
+        }
+#endif
+#ifdef COMPRESSED_INPUT_HAS_ZSTD
+        if (kind == InputCompression::Zstd){
+            ZSTD_outBuffer out = {output, capacity, 0};
+            while (out.pos < out.size){
+                if (zstdInput.pos == zstdInput.size && zstdPending == 0){
+                    finished = true;
+                    break;
+                }
+                std::size_t inputBefore = zstdInput.pos, outputBefore = out.pos;
+                std::size_t result = ZSTD_decompressStream(zstd, &out, &zstdInput);
+                if (ZSTD_isError(result) || (zstdInput.pos == inputBefore && out.pos == outputBefore)){
+                    failed = true; /// A corrupt frame, or one that ends before it is complete
+                    break;
+                }
+                zstdPending = result; /// 0 once a frame is complete and flushed; concatenated frames follow on
+            }
+            return out.pos;
+        }
+#endif
+        (void)output;
+        (void)capacity;
+        return 0;
+    }
+
+    bool done() const { return finished; }
+    bool fail() const { return failed; }
+
+    void close(){
+        if (!opened) return;
+#ifdef COMPRESSED_INPUT_HAS_ZLIB
+        if (kind == InputCompression::Gzip) inflateEnd(&gzip);
+#endif
+#ifdef COMPRESSED_INPUT_HAS_ZSTD
+        if (kind == InputCompression::Zstd) ZSTD_freeDStream(zstd);
+#endif
+        opened = false;
+    }
+
+private:
+    InputCompression kind;
+    const char *input;
+    std::size_t inputLength;
+    bool opened;
+    bool finished;
+    bool failed;
+#ifdef COMPRESSED_INPUT_HAS_ZLIB
+    z_stream gzip;
+#endif
+#ifdef COMPRESSED_INPUT_HAS_ZSTD
+    ZSTD_DStream *zstd = nullptr;
+    ZSTD_inBuffer zstdInput;
+    std::size_t zstdPending = 0;
+#endif
+};
+/**
+ *  Class:      InputDecoder
+ *              Decodes a compressed file held in memory, front to back. decode writes up to capacity bytes and
+ *              returns how many it wrote; it returns less only once the stream has ended (done) or turned out to
+ *              be truncated or corrupt (fail).
+ */
+
+class BackgroundDecoder{
+public:
+    BackgroundDecoder() : output(nullptr), capacity(0), decoded(0), released(0), requested(0), bounded(false), complete(false),
+                          failed(false), stopping(false) {}
+    ~BackgroundDecoder(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true; /// A file closed before it was read to the end is not decoded further
+            room.notify_all();
+        }
+        if (worker.joinable()) worker.join();
+        if (output != nullptr) munmap(output, capacity);
+    }
+    BackgroundDecoder(const BackgroundDecoder &) = delete;
+    BackgroundDecoder &operator=(const BackgroundDecoder &) = delete;
+
+    bool start(InputCompression kind, const char *input, std::size_t length, const std::string &fileName){
+        if (!decoder.open(kind, input, length)){
+            std::fprintf(stderr, "%s is %s compressed, and this program was built without %s.\n", fileName.c_str(),
+                         compressionName(kind), kind == InputCompression::Gzip ? "zlib" : "zstd (zstd.h and -lzstd)");
+            return false;
+        }
+        std::uint64_t reservation = static_cast<std::uint64_t>(length) * kDeflateMaxRatio;
+#ifdef COMPRESSED_INPUT_HAS_ZSTD
+        if (kind == InputCompression::Zstd){
+            unsigned long long frameSize = ZSTD_getFrameContentSize(input, length);
+            bool known = frameSize != ZSTD_CONTENTSIZE_UNKNOWN && frameSize != ZSTD_CONTENTSIZE_ERROR
+                      && ZSTD_findFrameCompressedSize(input, length) == length; /// A single frame that gives its size
+            reservation = known ? frameSize : static_cast<std::uint64_t>(length) * kZstdMaxRatio;
+        }
+#endif
+        reservation = std::min(reservation + kDecodeStep, kMaxDecodeReservation);
+        while (output == nullptr && reservation >= kDecodeStep){ /// Address space only; pages are taken as they are written
+            void *mapping = mmap(nullptr, reservation, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mapping != MAP_FAILED){
+                output = static_cast<char *>(mapping);
+                capacity = reservation;
+            }
+            else reservation /= 2;
+        }
+        if (output == nullptr) return false;
+        name = fileName;
+        kindName = kind == InputCompression::Gzip ? "gzip decode" : "zstd decode";
+        worker = std::thread([this](){ run(); });
+        return true;
+    }
+
+    std::size_t waitForBytes(std::size_t wanted, bool *finished = nullptr) const {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wanted > requested){ /// The decoder goes past its lead rather than keep a reader waiting
+            requested = wanted;
+            room.notify_all();
+        }
+        progress.wait(lock, [&](){ return complete || decoded >= wanted; });
+        if (finished != nullptr) *finished = complete;
+        return decoded;
+    }
+
+    std::size_t wait() const { return waitForBytes(capacity); }
+
+    void release(std::size_t upTo){ /// From the first call on, decoding stays at most kDecodeLead ahead of upTo
+        std::lock_guard<std::mutex> lock(mutex);
+        released = std::max(released, upTo);
+        bounded = true;
+        room.notify_all();
+    }
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return complete;
+    }
+
+    bool fail() const { /// True once decoding has stopped at a truncated or corrupt part
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    const char *data() const { return output; }
+
+private:
+    void run(){
+        std::size_t total = 0;
+        while (!decoder.done() && !decoder.fail() && !stopping){
+            std::size_t piece = std::min(kDecodeStep, capacity - total);
+            if (piece == 0) break;
+            {
+                ScopedStageTimer timer(kindName); /// Each piece is timed, so the time the decoder waits is left out
+                piece = decoder.decode(output + total, piece);
+                timer.count(0, piece);
+            }
+            total += piece;
+            std::unique_lock<std::mutex> lock(mutex);
+            decoded = total;
+            progress.notify_all();
+            room.wait(lock, [&](){ return !bounded || stopping || decoded < released + kDecodeLead || decoded < requested; });
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = !decoder.done();
+        if (failed && !stopping){
+            std::fprintf(stderr, "Warning: %s is truncated or corrupt after %zu decompressed bytes; the rest is skipped.\n",
+                         name.c_str(), total);
+            countRunMetric("corrupt compressed inputs", 1);
+        }
+        decoder.close();
+        complete = true;
+        progress.notify_all();
+    }
+
+    InputDecoder decoder;
+    char *output;
+    std::size_t capacity;
+    std::size_t decoded;        /// Guarded by mutex, like the members up to failed
+    std::size_t released;
+    mutable std::size_t requested;
+    bool bounded;
+    bool complete;
+    bool failed;
+    std::string name;
+    const char *kindName;
+    std::atomic<bool> stopping;
+    std::thread worker;
+    mutable std::mutex mutex;
+    mutable std::condition_variable progress;
+    mutable std::condition_variable room;
+};
+/**
+ *  Class:      BackgroundDecoder
+ *              Decodes a compressed file on its own thread into memory reserved for the whole output. waitForBytes
+ *              blocks until at least wanted bytes are decoded, or decoding has ended, and returns the bytes
+ *              decoded, with finished set when that is all of them; the bytes before that count stay where they
+ *              are and are not written again. A reader that streams through the file calls release with what it
+ *              has finished, which keeps the decoder, and the memory it writes, within kDecodeLead of the reader.
+ */
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * @file: drone_csv.h
+ * @date: 10/16/2026
+ * @brief: Reader for the CSV Files written by parse_srt.cc ("TimeCode, Frame, DiffTime, Date, Time, Latitude,
+ *         Longitude, Altitude"). Rows are decoded in place from the input buffer into a telemetry store, and
+ *         written back with the same formatting through a buffered writer.
+ */
+
+#ifndef DRONE_CSV_H
+#define DRONE_CSV_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "telemetry_store.h"
+#include "pipeline.h"
+#include "run_metrics.h"
+
+const int kDroneCsvColumns = 8;
+const std::size_t kDroneCsvRowMaxLength = 192;
+const char kDroneCsvHeader[] = "TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude\n";
+
+inline bool decodeDroneCsvRow(std::string_view line, TelemetryRecord &entry){
+    std::string_view fields[kDroneCsvColumns];
+    int column = 0;
+    std::size_t fieldStart = 0;
+    for (std::size_t i = 0; i <= line.size(); ++i){
+        if (i < line.size() && line[i] != ',') continue;
+        if (column == kDroneCsvColumns) return false;
+        std::string_view field = line.substr(fieldStart, i - fieldStart);
+        while (!field.empty() && (field.front() == ' ')) field.remove_prefix(1);
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\r')) field.remove_suffix(1);
+        fields[column++] = field;
+        fieldStart = i + 1;
+    }
+    if (column != kDroneCsvColumns) return false;
+    std::int64_t timeOfDay;
+    std::string_view date = fields[3];
+    if (!parseTimeOfDay(fields[0], entry.timecode) || !parseTimeOfDay(fields[4], timeOfDay)) return false;
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') return false;
+    int year, month, day;
+    if (std::from_chars(date.data(), date.data() + 4, year).ptr != date.data() + 4) return false;
+    if (std::from_chars(date.data() + 5, date.data() + 7, month).ptr != date.data() + 7) return false;
+    if (std::from_chars(date.data() + 8, date.data() + 10, day).ptr != date.data() + 10) return false;
+    entry.time = daysFromCivil(year, month, day) * kMicrosecondsPerDay + timeOfDay;
+    std::int64_t *integers[] = {&entry.frame, &entry.diffTime};
+    for (int i = 0; i < 2; ++i){
+        std::string_view field = fields[i + 1];
+        if (std::from_chars(field.data(), field.data() + field.size(), *integers[i]).ptr != field.data() + field.size()) return false;
+    }
+    double *values[] = {&entry.latitude, &entry.longitude, &entry.altitude};
+    for (int i = 0; i < 3; ++i){
+        std::string_view field = fields[i + 5];
+        if (std::from_chars(field.data(), field.data() + field.size(), *values[i]).ptr != field.data() + field.size()) return false;
+    }
+    return true;
+}
+/**
+ *  Function:   decodeDroneCsvRow
+ *              Decodes one row of a parse_srt.cc CSV File
+ *
+ *  @param line - row without its line break
+ *  @param entry - record that will be written with the row's values
+ *  @return false if the row does not have eight valid fields
+ */
+
+class DroneCsvReader{
+public:
+    DroneCsvReader(const char *begin, const char *end) : position(begin), end(end), headerLine(true), malformedCount(0) {}
+
+    bool next(TelemetryRecord &entry){
+        while (position < end){
+            const char *lineEnd = static_cast<const char *>(std::memchr(position, '\n', end - position));
+            if (lineEnd == nullptr) lineEnd = end;
+            std::string_view line(position, lineEnd - position);
+            position = lineEnd + (lineEnd < end);
+            if (headerLine){ /// The title entries are "TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude"
+                headerLine = false;
+                if (line.substr(0, 8) == "TimeCode") continue;
+            }
+            if (line.empty() || line == "\r") continue;
+            if (decodeDroneCsvRow(line, entry)) return true;
+            malformedCount++;
+        }
+        return false;
+    }
+
+    long long malformedRecords() const { return malformedCount; }
+
+private:
+    const char *position;
+    const char *end;
+    bool headerLine;
+    long long malformedCount;
+};
+/**
+ *  Class:      DroneCsvReader
+ *              Reads a parse_srt.cc CSV File held in memory one row at a time, for callers that stream the rows
+ *              instead of loading them into a store
+ */
+
+inline long long loadDroneCsv(TelemetryStore &store, const char *begin, const char *end, long long *malformedRecords = nullptr){
+    TelemetryRecord entry;
+    long long recordCount = 0;
+    store.reserve(store.size() + (end - begin) / 80); /// A row is about 85 characters long
+    DroneCsvReader reader(begin, end);
+    while (reader.next(entry)){
+        store.append(entry);
+        recordCount++;
+    }
+    if (malformedRecords != nullptr) *malformedRecords = reader.malformedRecords();
+    return recordCount;
+}
+/**
+ *  Function:   loadDroneCsv
+ *              Appends every row of a parse_srt.cc CSV File (per frame or Epic-by-Epic) to a telemetry store
+ *
+ *  @param store - store that will be appended to
+ *  @param begin - first byte of the file
+ *  @param end - one past the last byte of the file
+ *  @param malformedRecords - optional count of rows that were skipped
+ *  @return number of rows appended
+ */
+
+inline char *formatDroneCsvRow(const TelemetryRecord &entry, char *buffer){
+    buffer = formatTimeOfDay(entry.timecode, 3, buffer);
+    *buffer++ = ','; *buffer++ = ' ';
+    buffer = std::to_chars(buffer, buffer + 24, entry.frame).ptr;
+    *buffer++ = ','; *buffer++ = ' ';
+    buffer = std::to_chars(buffer, buffer + 24, entry.diffTime).ptr;
+    *buffer++ = ','; *buffer++ = ' ';
+    buffer = formatDate(entry.time, buffer);
+    *buffer++ = ','; *buffer++ = ' ';
+    buffer = formatTimeOfDay(entry.time, 6, buffer);
+    const double values[] = {entry.latitude, entry.longitude, entry.altitude};
+    for (double value : values){
+        *buffer++ = ','; *buffer++ = ' ';
+        buffer = std::to_chars(buffer, buffer + 40, value, std::chars_format::fixed, 6).ptr;
+    }
+    *buffer++ = '\n';
+    return buffer;
+}
+/**
+ *  Function:   formatDroneCsvRow
+ *              Formats one entry as "TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude" with six
+ *              decimals, followed by a line break
+ *
+ *  @param entry - entry to write
+ *  @param buffer - at least kDroneCsvRowMaxLength characters
+ *  @return one past the last character written
+ */
+
+inline bool writeDroneCsv(const TelemetryStore &data, const std::string &fileName){
+    ScopedStageTimer timer("drone CSV write");
+    BufferedFileWriter outs;
+    outs.open(fileName);
+    if (outs.fail()) return false;
+    outs.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    for (std::size_t i = 0; i < data.size(); ++i){
+        outs.commit(formatDroneCsvRow(data.record(i), outs.reserve(kDroneCsvRowMaxLength)));
+    }
+    outs.close();
+    timer.count(data.size(), outs.bytesWritten());
+    return !outs.fail();
+}
+/**
+ *  Function:   writeDroneCsv
+ *              Writes a store as a parse_srt.cc CSV File
+ *
+ *  @return false if the file could not be written
+ */
+
+struct OneSecondDecimator{
+    std::size_t index = 0;
+    int previousSecond = 0;
+
+    template <class EntryHandler>
+    void push(const TelemetryRecord &entry, EntryHandler keepEntry){
+        int second = secondOfMinute(entry.time);
+        if (index > 0){
+            if((second == 0) && ((previousSecond == 59) || index == 1)){
+                keepEntry();
+            }
+            if ((second > previousSecond) || ((second == 59) && (previousSecond == 58))){
+                keepEntry();
+            }
+        }
+        previousSecond = second;
+        index++;
+    }
+};
+/**
+ *  Struct:     OneSecondDecimator
+ *              Picks the first entry of each second from entries pushed one at a time, which is how the
+ *              Epic-by-Epic file is built. Only the previous entry's second is remembered, so it also works while
+ *              an SRT File is being streamed.
+ */
+
+inline void decimateToSeconds(TelemetryStore &data, const TelemetryStore &sourceData){
+    ScopedStageTimer timer("decimation");
+    timer.count(sourceData.size());
+    OneSecondDecimator decimator;
+    for (std::size_t i = 0; i < sourceData.size(); ++i){
+        decimator.push(sourceData.record(i), [&](){ data.append(sourceData, i); });
+    }
+}
+/**
+ *  Function:   decimateToSeconds
+ *              Appends the first entry of each second of sourceData to data
+ */
+
+#endif
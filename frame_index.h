@@ -0,0 +1,363 @@
+/**
+ * @file: frame_index.h
+ * @date: 10/16/2026
+ * @brief: Persistent index of the frames of one SRT File, so a video frame, a video timecode, or a UTC time is
+ *         turned into a drone position and receiver geometry with a binary search instead of a scan of the CSV
+ *         Files. The index is written next to the SRT File as "<SRT File>.index": a header that ties it to the
+ *         SRT File (size, modification time, content hash) and to the receiver and clock options it was built
+ *         with, followed by fixed-width little-endian columns sorted by frame number, each starting on a 64 byte
+ *         boundary. Besides the drone's columns it stores the receiver position interpolated at every frame
+ *         (NaN where no receiver epoch is within the tolerance) and the row orders by timecode and by time, so a
+ *         lookup by any of the three keys is O(log n) on the memory mapped file without loading it.
+ */
+
+#ifndef FRAME_INDEX_H
+#define FRAME_INDEX_H
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+#include "pipeline.h"
+#include "telemetry_store.h"
+#include "telemetry_cache.h"
+
+const char kFrameIndexMagic[8] = {'O', 'U', 'F', 'R', 'M', 'I', 'D', 'X'};
+const std::uint32_t kFrameIndexVersion = 1;
+const std::size_t kFrameIndexColumnAlignment = 64;
+
+struct FrameIndexHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t recordCount;
+    std::uint64_t sourceSize;           /// Bytes of the SRT File
+    std::int64_t sourceModifiedTime;    /// Nanoseconds since 1970-01-01
+    std::uint64_t sourceHash;           /// hashTelemetrySource of the SRT File
+    std::uint64_t receiverKey;          /// frameIndexReceiverKey of the receiver file and clock options
+};
+
+static_assert(sizeof(FrameIndexHeader) == 56, "Index layout must not be padded");
+
+/// Stored columns in file order, all sorted by frame; changing this list needs a new kFrameIndexVersion
+enum FrameIndexColumn{
+    kFrameIndexFrame, kFrameIndexTimecode, kFrameIndexTime, kFrameIndexLatitude, kFrameIndexLongitude, kFrameIndexAltitude,
+    kFrameIndexReceiverLatitude, kFrameIndexReceiverLongitude, kFrameIndexReceiverAltitude,
+    kFrameIndexTimecodeOrder, kFrameIndexTimeOrder, kFrameIndexColumnCount
+};
+
+inline std::string frameIndexName(const std::string &sourceFileName){ return sourceFileName + ".index"; }
+
+inline std::uint64_t frameIndexColumnOffset(std::uint64_t recordCount, int column){
+    std::uint64_t columnBytes = (recordCount * 8 + kFrameIndexColumnAlignment - 1) / kFrameIndexColumnAlignment * kFrameIndexColumnAlignment;
+    return kFrameIndexColumnAlignment + column * columnBytes; /// The header fits in the first 64 bytes
+}
+
+inline std::uint64_t frameIndexReceiverKey(const char *receiverBegin, std::size_t receiverLength,
+                                           std::int64_t droneClockOffset, std::int64_t tolerance){
+    std::uint64_t values[3] = {receiverLength == 0 ? 0 : hashTelemetrySource(receiverBegin, receiverLength),
+                               static_cast<std::uint64_t>(droneClockOffset), static_cast<std::uint64_t>(tolerance)};
+    return hashTelemetrySource(reinterpret_cast<const char *>(values), sizeof(values));
+}
+/**
+ *  Function:   frameIndexReceiverKey
+ *              Hash of everything besides the SRT File that the stored columns depend on: the receiver file's
+ *              content and the clock offset and tolerance used to place its epochs on the frames
+ *
+ *  @param receiverBegin - first byte of the u-center CSV File or UBX log, or nullptr when there is none
+ *  @param receiverLength - bytes of the receiver file, 0 when there is none
+ */
+
+struct FramePosition{
+    std::size_t left = 0;       /// Row at or before the key
+    std::size_t right = 0;      /// Row at or after the key (equal to left on an exact hit)
+    double fraction = 0;        /// Position of the key between left and right from 0 to 1
+    bool found = false;         /// False when the key is outside the indexed frames
+};
+
+class FrameIndex{
+public:
+    FrameIndex() : count(0) {}
+    FrameIndex(const FrameIndex &) = delete;
+    FrameIndex &operator=(const FrameIndex &) = delete;
+
+    bool open(const std::string &indexFileName){
+        file.open(indexFileName);
+        count = 0;
+        if (file.fail() || file.size() < sizeof(FrameIndexHeader)) return false;
+        std::memcpy(&header, file.begin(), sizeof(header));
+        if (std::memcmp(header.magic, kFrameIndexMagic, sizeof(header.magic)) != 0 || header.version != kFrameIndexVersion
+            || header.recordCount > file.size() / 8
+            || file.size() < frameIndexColumnOffset(header.recordCount, kFrameIndexColumnCount)) return false;
+        count = static_cast<std::size_t>(header.recordCount);
+        return true;
+    }
+
+    bool current(const std::string &sourceFileName, const MappedFile &source, std::uint64_t receiverKey) const {
+        if (header.sourceSize != source.size() || header.receiverKey != receiverKey) return false;
+        return header.sourceModifiedTime == fileModifiedTime(sourceFileName)
+            || header.sourceHash == hashTelemetrySource(source.begin(), source.size());
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const std::int64_t *frame() const { return integerColumn(kFrameIndexFrame); }
+    const std::int64_t *timecode() const { return integerColumn(kFrameIndexTimecode); }
+    const std::int64_t *time() const { return integerColumn(kFrameIndexTime); }
+    const double *latitude() const { return doubleColumn(kFrameIndexLatitude); }
+    const double *longitude() const { return doubleColumn(kFrameIndexLongitude); }
+    const double *altitude() const { return doubleColumn(kFrameIndexAltitude); }
+    const double *receiverLatitude() const { return doubleColumn(kFrameIndexReceiverLatitude); }
+    const double *receiverLongitude() const { return doubleColumn(kFrameIndexReceiverLongitude); }
+    const double *receiverAltitude() const { return doubleColumn(kFrameIndexReceiverAltitude); }
+    const std::int64_t *timecodeOrder() const { return integerColumn(kFrameIndexTimecodeOrder); }
+    const std::int64_t *timeOrder() const { return integerColumn(kFrameIndexTimeOrder); }
+
+    FramePosition locateFrame(double key) const { return locate(frame(), nullptr, key); }
+    FramePosition locateTimecode(std::int64_t key) const { return locate(timecode(), timecodeOrder(), static_cast<double>(key)); }
+    FramePosition locateTime(std::int64_t key) const { return locate(time(), timeOrder(), static_cast<double>(key)); }
+
+    void frameRange(std::int64_t first, std::int64_t last, std::vector<std::size_t> &rows) const {
+        const std::int64_t *keys = frame();
+        std::size_t begin = std::lower_bound(keys, keys + count, first) - keys;
+        std::size_t end = std::upper_bound(keys, keys + count, last) - keys;
+        rows.clear();
+        for (std::size_t row = begin; row < end; ++row) rows.push_back(row);
+    }
+    void timecodeRange(std::int64_t first, std::int64_t last, std::vector<std::size_t> &rows) const {
+        orderedRange(timecode(), timecodeOrder(), first, last, rows);
+    }
+    void timeRange(std::int64_t first, std::int64_t last, std::vector<std::size_t> &rows) const {
+        orderedRange(time(), timeOrder(), first, last, rows);
+    }
+
+    bool sample(const FramePosition &position, TelemetryRecord &drone, TelemetryRecord &receiver) const {
+        std::size_t left = position.left, right = position.right;
+        double t = position.fraction;
+        auto blend = [&](const double *column){ return column[left] + t * (column[right] - column[left]); };
+        drone = TelemetryRecord();
+        drone.frame = frame()[t < 0.5 ? left : right]; /// The nearest frame, as resampleTelemetry reports it
+        drone.timecode = timecode()[left] + static_cast<std::int64_t>(std::llround(t * (timecode()[right] - timecode()[left])));
+        drone.time = time()[left] + static_cast<std::int64_t>(std::llround(t * (time()[right] - time()[left])));
+        drone.latitude = blend(latitude());
+        drone.longitude = blend(longitude());
+        drone.altitude = blend(altitude());
+        receiver = TelemetryRecord();
+        receiver.time = drone.time;
+        receiver.latitude = blend(receiverLatitude());
+        receiver.longitude = blend(receiverLongitude());
+        receiver.altitude = blend(receiverAltitude());
+        return !std::isnan(receiver.latitude); /// NaN at either end means no receiver epoch was close enough
+    }
+
+private:
+    const std::int64_t *integerColumn(int column) const {
+        return reinterpret_cast<const std::int64_t *>(file.begin() + frameIndexColumnOffset(header.recordCount, column));
+    }
+    const double *doubleColumn(int column) const {
+        return reinterpret_cast<const double *>(file.begin() + frameIndexColumnOffset(header.recordCount, column));
+    }
+
+    /// Binary search of a key column, directly or through a row order when the column is not in frame order
+    FramePosition locate(const std::int64_t *keys, const std::int64_t *order, double key) const {
+        FramePosition position;
+        if (count == 0) return position;
+        auto keyAt = [&](std::size_t rank){ return static_cast<double>(keys[order == nullptr ? rank : order[rank]]); };
+        std::size_t low = 0, high = count;
+        while (low < high){
+            std::size_t middle = low + (high - low) / 2;
+            if (keyAt(middle) < key) low = middle + 1;
+            else high = middle;
+        }
+        if (low == count || (low == 0 && keyAt(0) > key)) return position;
+        std::size_t rightRank = low, leftRank = keyAt(low) == key ? low : low - 1;
+        position.left = order == nullptr ? leftRank : static_cast<std::size_t>(order[leftRank]);
+        position.right = order == nullptr ? rightRank : static_cast<std::size_t>(order[rightRank]);
+        double span = keyAt(rightRank) - keyAt(leftRank);
+        position.fraction = span > 0 ? (key - keyAt(leftRank)) / span : 0;
+        if (leftRank == rightRank) position.right = position.left;
+        position.found = true;
+        return position;
+    }
+
+    void orderedRange(const std::int64_t *keys, const std::int64_t *order, std::int64_t first, std::int64_t last,
+                      std::vector<std::size_t> &rows) const {
+        const std::int64_t *orderEnd = order + count;
+        const std::int64_t *begin = std::partition_point(order, orderEnd, [&](std::int64_t row){ return keys[row] < first; });
+        const std::int64_t *end = std::partition_point(begin, orderEnd, [&](std::int64_t row){ return keys[row] <= last; });
+        rows.assign(begin, end);
+    }
+
+    MappedFile file;
+    FrameIndexHeader header;
+    std::size_t count;
+};
+/**
+ *  Class:      FrameIndex
+ *              Read side of "<SRT File>.index". The columns are read in place from the mapping. locateFrame,
+ *              locateTimecode, and locateTime find the two frames around a key by binary search, sample
+ *              interpolates the drone and receiver positions between them, and the range functions list the rows
+ *              whose key falls within [first, last] in the order of that key.
+ */
+
+inline void interpolateReceiverAtFrames(const TelemetryStore &drone, const std::int64_t *timeOrder, const TelemetryStore &receiver,
+                                        std::int64_t droneClockOffset, std::int64_t tolerance,
+                                        std::vector<double> &latitude, std::vector<double> &longitude, std::vector<double> &altitude){
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    latitude.assign(drone.size(), missing);
+    longitude.assign(drone.size(), missing);
+    altitude.assign(drone.size(), missing);
+    std::size_t receiverCount = receiver.size();
+    if (receiverCount == 0) return;
+    const std::int64_t *times = receiver.time.data();
+    std::size_t k = 0;
+    for (std::size_t rank = 0; rank < drone.size(); ++rank){ /// Frames in time order, so the receiver is walked once
+        std::size_t row = static_cast<std::size_t>(timeOrder[rank]);
+        std::int64_t time = drone.time[row] + droneClockOffset;
+        while (k + 1 < receiverCount && times[k + 1] <= time) k++;
+        bool bracketed = times[k] <= time && k + 1 < receiverCount;
+        std::int64_t before = times[k] <= time ? time - times[k] : times[k] - time;
+        std::int64_t after = bracketed ? times[k + 1] - time : before;
+        if (std::min(before, after) > tolerance) continue;
+        if (!bracketed){
+            latitude[row] = receiver.latitude[k]; longitude[row] = receiver.longitude[k]; altitude[row] = receiver.altitude[k];
+            continue;
+        }
+        double t = static_cast<double>(before) / static_cast<double>(times[k + 1] - times[k]);
+        latitude[row] = receiver.latitude[k] + t * (receiver.latitude[k + 1] - receiver.latitude[k]);
+        longitude[row] = receiver.longitude[k] + t * (receiver.longitude[k + 1] - receiver.longitude[k]);
+        altitude[row] = receiver.altitude[k] + t * (receiver.altitude[k + 1] - receiver.altitude[k]);
+    }
+}
+/**
+ *  Function:   interpolateReceiverAtFrames
+ *              Interpolates the receiver position linearly at the UTC time of every frame. A frame whose nearest
+ *              receiver epoch is further away than the tolerance gets NaN, and a frame before the first or after
+ *              the last receiver epoch takes that epoch's position.
+ *
+ *  @param drone - frames sorted by frame number, times in the drone's clock
+ *  @param timeOrder - rows of drone in time order
+ *  @param receiver - receiver epochs with ascending UTC times
+ *  @param droneClockOffset - added to drone times to get UTC
+ *  @param tolerance - largest time in microseconds from a frame to its nearest receiver epoch
+ *  @param latitude, longitude, altitude - written with one receiver position per frame
+ */
+
+inline bool writeFrameIndex(TelemetryStore drone, const TelemetryStore &receiver, const std::string &sourceFileName,
+                            const MappedFile &source, std::uint64_t receiverKey, std::int64_t droneClockOffset, std::int64_t tolerance){
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    return false; /// The columns are stored little-endian
+#endif
+    ScopedStageTimer timer("frame index write");
+    timer.count(drone.size());
+    std::size_t count = drone.size();
+    std::vector<std::size_t> rows(count);
+    std::iota(rows.begin(), rows.end(), 0);
+    if (!std::is_sorted(drone.frame.begin(), drone.frame.end())){ /// SRT Files are in frame order, so this is rare
+        std::stable_sort(rows.begin(), rows.end(), [&](std::size_t a, std::size_t b){ return drone.frame[a] < drone.frame[b]; });
+        TelemetryStore sorted;
+        sorted.reserve(count);
+        for (std::size_t row : rows) sorted.append(drone, row);
+        drone = std::move(sorted);
+    }
+    std::vector<std::int64_t> timecodeOrder(count), timeOrder(count);
+    std::iota(timecodeOrder.begin(), timecodeOrder.end(), 0);
+    std::iota(timeOrder.begin(), timeOrder.end(), 0);
+    std::stable_sort(timecodeOrder.begin(), timecodeOrder.end(), [&](std::int64_t a, std::int64_t b){ return drone.timecode[a] < drone.timecode[b]; });
+    std::stable_sort(timeOrder.begin(), timeOrder.end(), [&](std::int64_t a, std::int64_t b){ return drone.time[a] < drone.time[b]; });
+    std::vector<double> receiverLatitude, receiverLongitude, receiverAltitude;
+    interpolateReceiverAtFrames(drone, timeOrder.data(), receiver, droneClockOffset, tolerance,
+                                receiverLatitude, receiverLongitude, receiverAltitude);
+    std::vector<std::int64_t> utcTime(drone.time);
+    for (std::int64_t &time : utcTime) time += droneClockOffset;
+
+    FrameIndexHeader header = {};
+    std::memcpy(header.magic, kFrameIndexMagic, sizeof(header.magic));
+    header.version = kFrameIndexVersion;
+    header.recordCount = count;
+    header.sourceSize = source.size();
+    header.sourceModifiedTime = fileModifiedTime(sourceFileName);
+    header.sourceHash = hashTelemetrySource(source.begin(), source.size());
+    header.receiverKey = receiverKey;
+    const void *columns[kFrameIndexColumnCount] = {drone.frame.data(), drone.timecode.data(), utcTime.data(),
+                                                   drone.latitude.data(), drone.longitude.data(), drone.altitude.data(),
+                                                   receiverLatitude.data(), receiverLongitude.data(), receiverAltitude.data(),
+                                                   timecodeOrder.data(), timeOrder.data()};
+
+    std::string indexFileName = frameIndexName(sourceFileName);
+    std::string temporaryFileName = indexFileName + ".tmp"; /// Renamed into place, so a reader never sees half an index
+    BufferedFileWriter outs;
+    outs.open(temporaryFileName);
+    if (outs.fail()) return false;
+    const char padding[kFrameIndexColumnAlignment] = {};
+    outs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::uint64_t written = sizeof(header);
+    for (int column = 0; column < kFrameIndexColumnCount; ++column){
+        std::uint64_t start = frameIndexColumnOffset(count, column);
+        outs.write(padding, start - written);
+        outs.write(static_cast<const char *>(columns[column]), count * 8);
+        written = start + count * 8;
+    }
+    outs.write(padding, frameIndexColumnOffset(count, kFrameIndexColumnCount) - written);
+    outs.close();
+    if (outs.fail() || std::rename(temporaryFileName.c_str(), indexFileName.c_str()) != 0){
+        std::remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+/**
+ *  Function:   writeFrameIndex
+ *              Sorts the frames by frame number and writes "<SRT File>.index" with their UTC times, the receiver
+ *              position at each frame, and the row orders by timecode and by time
+ *
+ *  @param drone - frames as parsed, times in the drone's clock
+ *  @param receiver - receiver epochs with UTC times, or an empty store
+ *  @param sourceFileName - name of the SRT File
+ *  @param source - the same file, memory mapped, for its size and content hash
+ *  @param receiverKey - frameIndexReceiverKey of the receiver file and options
+ *  @param droneClockOffset - added to drone times to get UTC
+ *  @param tolerance - largest time in microseconds from a frame to the receiver epoch it is placed with
+ *  @return false if the index could not be written
+ */
+
+inline bool parseUtcTime(std::string_view text, std::int64_t flightStart, std::int64_t &time){
+    std::int64_t timeOfDay;
+    if (text.size() >= 11 && text[4] == '-' && text[7] == '-' && text[10] == 'T'){
+        int year, month, day;
+        if (std::from_chars(text.data(), text.data() + 4, year).ptr != text.data() + 4
+            || std::from_chars(text.data() + 5, text.data() + 7, month).ptr != text.data() + 7
+            || std::from_chars(text.data() + 8, text.data() + 10, day).ptr != text.data() + 10) return false;
+        std::string_view clock = text.substr(11);
+        if (!clock.empty() && clock.back() == 'Z') clock.remove_suffix(1);
+        if (!parseTimeOfDay(clock, timeOfDay)) return false;
+        time = daysFromCivil(year, month, day) * kMicrosecondsPerDay + timeOfDay;
+        return true;
+    }
+    if (!text.empty() && text.back() == 'Z') text.remove_suffix(1);
+    if (!parseTimeOfDay(text, timeOfDay)) return false;
+    time = floorDivide(flightStart, kMicrosecondsPerDay) * kMicrosecondsPerDay + timeOfDay;
+    if (time < flightStart - kMicrosecondsPerDay / 2) time += kMicrosecondsPerDay; /// A flight that runs past midnight
+    return true;
+}
+/**
+ *  Function:   parseUtcTime
+ *              Reads "yyyy-mm-ddThh:mm:ss.ffffffZ" or a bare time of day, which is taken on the day of the flight
+ *
+ *  @param text - field to read
+ *  @param flightStart - UTC time of the first frame in microseconds since 1970-01-01
+ *  @param time - written with the microseconds since 1970-01-01
+ *  @return false if the field is not a time
+ */
+
+#endif
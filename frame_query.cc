@@ -0,0 +1,279 @@
+/**
+ * @file: frame_query.cc
+ * @date: 10/16/2026
+ * @brief: This program answers lookups into the footage of a DJI drone: for a video frame, a video timecode, or a
+ * UTC time it prints the drone position interpolated between the two frames around it and, when a receiver file is
+ * given, the heading, elevation angle, and slant distance from the Ublox receiver. A range of frames, timecodes, or
+ * times prints every frame inside it. Lookups use "<SRT File>.index" (frame_index.h), which is built on the first
+ * run and rebuilt whenever the SRT File, the receiver file, or the clock options change, so each lookup is a binary
+ * search on the memory mapped index instead of a pass over the CSV Files.
+ * Queries are given after the SRT File or, when there are none, read from standard input one per line:
+ *     frame <number> [<last number>]
+ *     timecode <hh:mm:ss,fff> [<last timecode>]
+ *     utc <hh:mm:ss.ffffff or yyyy-mm-ddThh:mm:ss.ffffffZ> [<last time>]
+ * Results are written as CSV rows to standard output, or to the file given with -o, and each row starts with the
+ * number of the query it answers.
+ * --metrics <file> writes the time and counts of each stage and the peak memory of the run as JSON (run_metrics.h).
+ * Usage: frame_query [--receiver <u-center CSV File or UBX log>] [--utc-offset hours] [--leap-seconds seconds]
+ * [--tolerance seconds] [--no-cache] [--metrics file] [-o output file] <SRT File> [query ...]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cmath>
+#include "mapped_file.h"
+#include "telemetry_store.h"
+#include "telemetry_cache.h"
+#include "ubx_parser.h"
+#include "time_align.h"
+#include "geodesy.h"
+#include "frame_index.h"
+#include "run_metrics.h"
+using namespace std;
+
+const size_t kQueryBatchSize = 4096;
+const char kFrameQueryHeader[] = "Query, Frame, TimeCode, Date, Time, Latitude, Longitude, Altitude, Heading, Elevation Angle, Slant Distance\n";
+
+class QueryWriter{
+public:
+    QueryWriter(const FrameIndex &index, ostream &outs) : index(index), outs(outs), unmatched(0) {}
+
+    void add(long long query, const FramePosition &position){ /// Queues one interpolated sample
+        TelemetryRecord drone, receiver;
+        bool matched = index.sample(position, drone, receiver);
+        queries.push_back(query);
+        hasReceiver.push_back(matched);
+        droneData.append(drone);
+        receiverData.append(receiver);
+        if (droneData.size() == kQueryBatchSize) flush();
+    }
+
+    void addRows(long long query, const vector<size_t> &rows){ /// Queues indexed frames as they are
+        for (size_t row : rows){
+            FramePosition position;
+            position.left = position.right = row;
+            position.found = true;
+            add(query, position);
+        }
+    }
+
+    void flush(){ /// Look angles are computed for the whole batch at once
+        computeLookAngles(receiverData, droneData, droneData);
+        for (size_t i = 0; i < droneData.size(); ++i){
+            if (!hasReceiver[i]){ /// Unmatched frames keep zeros, as in the other tools
+                droneData.heading[i] = droneData.elevationAngle[i] = droneData.slantDistance[i] = 0;
+                unmatched++;
+            }
+            char timecode[16], date[16], time[16];
+            *formatTimeOfDay(droneData.timecode[i], 3, timecode) = '\0';
+            *formatDate(droneData.time[i], date) = '\0';
+            *formatTimeOfDay(droneData.time[i], 6, time) = '\0';
+            outs << queries[i] << ", " << droneData.frame[i] << ", " << timecode << ", " << date << ", " << time << ", "
+                 << droneData.latitude[i] << ", " << droneData.longitude[i] << ", " << droneData.altitude[i] << ", "
+                 << droneData.heading[i] << ", " << droneData.elevationAngle[i] << ", " << droneData.slantDistance[i] << '\n';
+        }
+        queries.clear();
+        hasReceiver.clear();
+        droneData.clear();
+        receiverData.clear();
+    }
+
+    long long unmatchedCount() const { return unmatched; }
+
+private:
+    const FrameIndex &index;
+    ostream &outs;
+    vector<long long> queries;
+    vector<bool> hasReceiver;
+    TelemetryStore droneData;
+    TelemetryStore receiverData;
+    long long unmatched;
+};
+/**
+ *  Class:      QueryWriter
+ *              Collects the samples of the queries and writes them in batches, so the geodesy.h chain runs over
+ *              contiguous arrays instead of once per row
+ */
+
+void openFrameIndex(FrameIndex &index, string inputFileName, string receiverFileName, const AlignmentOptions &options, bool useCache);
+/**
+ *  Function:   openFrameIndex
+ *              Opens "<SRT File>.index", building it first if it is missing or was built from a different SRT File,
+ *              receiver file, or clock options
+ *
+ *  @param index - index that will be opened
+ *  @param inputFileName - name of the SRT File
+ *  @param receiverFileName - u-center CSV File or UBX log of the receiver, or empty
+ *  @param options - drone clock offset and the tolerance used to place receiver epochs on the frames
+ *  @param useCache - whether the parsed SRT and receiver files are read from and written to telemetry_cache.h caches
+ */
+
+bool runQuery(const FrameIndex &index, QueryWriter &writer, long long queryNumber, string query);
+/**
+ *  Function:   runQuery
+ *              Looks up one "frame", "timecode", or "utc" query and queues its rows
+ *
+ *  @param index - opened index
+ *  @param writer - writer that receives the samples
+ *  @param queryNumber - number written at the start of each of the query's rows
+ *  @param query - text of the query
+ *  @return false if the query could not be read or lies outside the indexed frames
+ */
+
+int main(int argc, char *argv[]){
+    cout << setprecision(6) << fixed;
+    string inputFileName;
+    string receiverFileName;
+    string outputFileName;
+    vector<string> queries;
+    AlignmentOptions options;
+    bool useCache = true;
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if (argument == "--receiver" && i + 1 < argc) receiverFileName = argv[++i];
+        else if (argument == "-o" && i + 1 < argc) outputFileName = argv[++i];
+        else if (argument == "--no-cache") useCache = false;
+        else if (parseAlignmentOption(i, argc, argv, options)) continue;
+        else if (parseMetricsOption(i, argc, argv)) continue;
+        else if (inputFileName.empty() && argument[0] != '-') inputFileName = argument;
+        else if ((argument == "frame" || argument == "timecode" || argument == "utc") && i + 1 < argc){
+            string query = argument + " " + argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-' && string(argv[i + 1]) != "frame" && string(argv[i + 1]) != "timecode"
+                && string(argv[i + 1]) != "utc") query += string(" ") + argv[++i];
+            queries.push_back(query);
+        }
+        else {
+            cerr << "Usage: frame_query [--receiver <u-center CSV File or UBX log>] [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--no-cache] [--metrics file] [-o output file] <SRT File> [query ...]" << endl;
+            exit(0);
+        }
+    }
+    if (inputFileName.empty()){
+        cerr << "Enter name of input file: ";
+        cin >> inputFileName;
+        cin.ignore();
+    }
+    FrameIndex index;
+    openFrameIndex(index, inputFileName, receiverFileName, options, useCache);
+
+    ofstream outputFileStream;
+    if (!outputFileName.empty()){
+        outputFileStream.open(outputFileName);
+        if (outputFileStream.fail()){
+            cerr << "Error opening output file." << endl;
+            exit(0);
+        }
+    }
+    ostream &outs = outputFileName.empty() ? cout : outputFileStream;
+    outs << setprecision(6) << fixed << kFrameQueryHeader;
+    QueryWriter writer(index, outs);
+    ScopedStageTimer timer("queries");
+    long long queryCount = 0, failedQueries = 0;
+    if (!queries.empty()){
+        for (const string &query : queries) failedQueries += !runQuery(index, writer, ++queryCount, query);
+    }
+    else {
+        string query;
+        while (getline(cin, query)){
+            if (query.empty() || query[0] == '#') continue;
+            failedQueries += !runQuery(index, writer, ++queryCount, query);
+        }
+    }
+    writer.flush();
+    outs.flush();
+    timer.count(queryCount);
+    countRunMetric("failed queries", failedQueries);
+    if (failedQueries > 0) cerr << failedQueries << " of " << queryCount << " queries were malformed or outside the flight." << endl;
+    if (writer.unmatchedCount() > 0 && !receiverFileName.empty())
+        cerr << writer.unmatchedCount() << " rows have no Ublox epoch within the tolerance." << endl;
+    if (outs.fail()){
+        cerr << "Error writing the output file." << endl;
+        exit(0);
+    }
+    return 0;
+}
+
+void openFrameIndex(FrameIndex &index, string inputFileName, string receiverFileName, const AlignmentOptions &options, bool useCache){
+    MappedFile inputFile, receiverFile;
+    inputFile.open(inputFileName);
+    if (inputFile.fail()){
+        cerr << "Error opening the input file." << endl;
+        exit(0);
+    }
+    if (!receiverFileName.empty()){
+        receiverFile.open(receiverFileName);
+        if (receiverFile.fail()){
+            cerr << "Error opening the receiver file." << endl;
+            exit(0);
+        }
+    }
+    uint64_t receiverKey = frameIndexReceiverKey(receiverFile.begin(), receiverFile.size(), options.droneClockOffset, options.tolerance);
+    if (index.open(frameIndexName(inputFileName)) && index.current(inputFileName, inputFile, receiverKey)) return;
+
+    TelemetryStore droneData, receiverData;
+    loadTelemetryFile(droneData, inputFileName, inputFile, TelemetrySource::Srt, useCache);
+    if (!receiverFileName.empty()){
+        TelemetrySource receiverKind = isUbxFile(receiverFileName, receiverFile.streamBegin(), receiverFile.waitForBytes(2))
+                                     ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv;
+        if (loadTelemetryFile(receiverData, receiverFileName, receiverFile, receiverKind, useCache) < 0){
+            cerr << "The receiver file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+            exit(0);
+        }
+    }
+    if (!writeFrameIndex(droneData, receiverData, inputFileName, inputFile, receiverKey, options.droneClockOffset, options.tolerance)
+        || !index.open(frameIndexName(inputFileName))){
+        cerr << "Error writing the index file." << endl;
+        exit(0);
+    }
+}
+
+bool runQuery(const FrameIndex &index, QueryWriter &writer, long long queryNumber, string query){
+    istringstream fields(query);
+    string kind, first, last;
+    fields >> kind >> first >> last;
+    bool range = !last.empty();
+    if (last.empty()) last = first;
+    vector<size_t> rows;
+    if (kind == "frame"){
+        double firstFrame, lastFrame;
+        if (from_chars(first.data(), first.data() + first.size(), firstFrame).ptr != first.data() + first.size()
+            || from_chars(last.data(), last.data() + last.size(), lastFrame).ptr != last.data() + last.size()) return false;
+        if (!range){
+            FramePosition position = index.locateFrame(firstFrame);
+            if (position.found) writer.add(queryNumber, position);
+            return position.found;
+        }
+        index.frameRange(static_cast<int64_t>(ceil(firstFrame)), static_cast<int64_t>(floor(lastFrame)), rows);
+    }
+    else if (kind == "timecode"){
+        int64_t firstTimecode, lastTimecode;
+        if (!parseTimeOfDay(first, firstTimecode) || !parseTimeOfDay(last, lastTimecode)) return false;
+        if (!range){
+            FramePosition position = index.locateTimecode(firstTimecode);
+            if (position.found) writer.add(queryNumber, position);
+            return position.found;
+        }
+        index.timecodeRange(firstTimecode, lastTimecode, rows);
+    }
+    else if (kind == "utc"){
+        if (index.empty()) return false;
+        int64_t flightStart = index.time()[index.timeOrder()[0]];
+        int64_t firstTime, lastTime;
+        if (!parseUtcTime(first, flightStart, firstTime) || !parseUtcTime(last, flightStart, lastTime)) return false;
+        if (!range){
+            FramePosition position = index.locateTime(firstTime);
+            if (position.found) writer.add(queryNumber, position);
+            return position.found;
+        }
+        index.timeRange(firstTime, lastTime, rows);
+    }
+    else return false;
+    writer.addRows(queryNumber, rows);
+    return !rows.empty();
+}
@@ -0,0 +1,64 @@
+/**
+ * @file: generate_flight.cc
+ * @date: 10/16/2026
+ * @brief: This program writes a synthetic flight (synthetic_flight.h): "<name>.SRT", as a DJI drone would write
+ * next to its video, and "<name>.csv", as u-center would export from the Ublox receiver. The files are the same
+ * for the same options when built with the same compiler and libm, so they can stand in for real flights when the
+ * parsers are profiled or compared across changes, and they can be run through parse_srt, parse_drone_csv, and
+ * parse_ublox_csv with the default clock options.
+ * Usage: generate_flight [--seconds seconds] [--frame-rate Hz] [--receiver-rate Hz] [--layout mavic2|phantom4|position-first]
+ * [--columns minimal|full] [--seed number] [name]. The name defaults to "Synthetic Flight".
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include "synthetic_flight.h"
+using namespace std;
+
+bool writeTextFile(const string &fileName, const string &text);
+/**
+ *  Function:   writeTextFile
+ *              Writes a string to a file
+ *
+ *  @return false if the file could not be written
+ */
+
+int main(int argc, char *argv[]){
+    SyntheticFlightOptions options;
+    string flightName = "Synthetic Flight";
+    for (int i = 1; i < argc; ++i){
+        if (parseSyntheticFlightOption(i, argc, argv, options)) continue;
+        if (argv[i][0] == '-' || flightName != "Synthetic Flight"){
+            cout << "Usage: generate_flight [--seconds seconds] [--frame-rate Hz] [--receiver-rate Hz] [--layout mavic2|phantom4|position-first] [--columns minimal|full] [--seed number] [name]" << endl;
+            exit(0);
+        }
+        flightName = argv[i];
+    }
+    if (options.seconds <= 0 || options.frameRate <= 0 || options.receiverRate <= 0){
+        cout << "The flight length and rates must be positive." << endl;
+        exit(0);
+    }
+    string text;
+    generateSyntheticSrt(options, text);
+    if (!writeTextFile(flightName + ".SRT", text)){
+        cout << "Error writing the SRT File." << endl;
+        exit(0);
+    }
+    cout << flightName << ".SRT: " << static_cast<long long>(options.seconds * options.frameRate) << " frames, " << text.size() << " bytes" << endl;
+    generateSyntheticUbloxCsv(options, text);
+    if (!writeTextFile(flightName + ".csv", text)){
+        cout << "Error writing the u-center CSV File." << endl;
+        exit(0);
+    }
+    cout << flightName << ".csv: " << static_cast<long long>(options.seconds * options.receiverRate) << " epochs, " << text.size() << " bytes" << endl;
+    return EXIT_SUCCESS;
+}
+
+bool writeTextFile(const string &fileName, const string &text){
+    ofstream outs(fileName, ios::binary);
+    outs.write(text.data(), text.size());
+    outs.close();
+    return !outs.fail();
+}
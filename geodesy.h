@@ -0,0 +1,139 @@
+/**
+ * @file: geodesy.h
+ * @date: 10/16/2026
+ * @brief: Native replacement for the geometry in calculations.m. Converts Latitude, Longitude, and
+ *         Altitude/Height (LLH) to ECEF, calculates ENU of the drone with respect to the Ublox receiver,
+ *         and derives the slant distance, heading, and elevation angle for each epoch.
+ *         All functions work on contiguous arrays of epochs. The arrays are walked in fixed size batches
+ *         so the intermediate ECEF/ENU values stay in cache and the inner loops have no branches,
+ *         which lets the compiler vectorize them.
+ */
+
+#ifndef GEODESY_H
+#define GEODESY_H
+
+#include <cmath>
+#include <cstddef>
+#include "telemetry_store.h"
+
+const double kWgs84SemiMajorAxis = 6378137.0;                     /// WGS-84 semi-major axis in meters
+const double kWgs84Flattening = 1.0 / 298.257223563;              /// WGS-84 flattening
+const double kWgs84EccentricitySquared = kWgs84Flattening * (2.0 - kWgs84Flattening);
+const double kDegreesToRadians = M_PI / 180.0;
+const double kRadiansToDegrees = 180.0 / M_PI;
+const std::size_t kGeodesyBatchSize = 256;                          /// Epochs processed per batch
+
+inline void llhToEcef(const double *latitude, const double *longitude, const double *altitude,
+                      double *x, double *y, double *z, std::size_t count){
+    for (std::size_t i = 0; i < count; ++i){
+        double phi = latitude[i] * kDegreesToRadians;
+        double lambda = longitude[i] * kDegreesToRadians;
+        double sinPhi = std::sin(phi);
+        double cosPhi = std::cos(phi);
+        double primeVertical = kWgs84SemiMajorAxis / std::sqrt(1.0 - kWgs84EccentricitySquared * sinPhi * sinPhi);
+        x[i] = (primeVertical + altitude[i]) * cosPhi * std::cos(lambda);
+        y[i] = (primeVertical + altitude[i]) * cosPhi * std::sin(lambda);
+        z[i] = (primeVertical * (1.0 - kWgs84EccentricitySquared) + altitude[i]) * sinPhi;
+    }
+}
+/**
+ *  Function:   llhToEcef
+ *              Converts geodetic coordinates to Earth-Centered Earth-Fixed coordinates (llh2ec in MATLAB)
+ *
+ *  @param latitude, longitude - arrays of angles in degrees
+ *  @param altitude - array of heights above the ellipsoid in meters
+ *  @param x, y, z - arrays that will be written with the ECEF coordinates in meters
+ *  @param count - number of epochs in every array
+ */
+
+inline void ecefToEnu(const double *originX, const double *originY, const double *originZ,
+                      const double *originLatitude, const double *originLongitude,
+                      const double *targetX, const double *targetY, const double *targetZ,
+                      double *east, double *north, double *up, std::size_t count){
+    for (std::size_t i = 0; i < count; ++i){
+        double phi = originLatitude[i] * kDegreesToRadians;
+        double lambda = originLongitude[i] * kDegreesToRadians;
+        double sinPhi = std::sin(phi), cosPhi = std::cos(phi);
+        double sinLambda = std::sin(lambda), cosLambda = std::cos(lambda);
+        double dx = targetX[i] - originX[i];
+        double dy = targetY[i] - originY[i];
+        double dz = targetZ[i] - originZ[i];
+        east[i] = -sinLambda * dx + cosLambda * dy;
+        north[i] = -sinPhi * cosLambda * dx - sinPhi * sinLambda * dy + cosPhi * dz;
+        up[i] = cosPhi * cosLambda * dx + cosPhi * sinLambda * dy + sinPhi * dz;
+    }
+}
+/**
+ *  Function:   ecefToEnu
+ *              Calculates the East, North, Up vector from the origin to the target (ec2enu in MATLAB)
+ *
+ *  @param originX, originY, originZ - ECEF coordinates of the origin (Ublox receiver)
+ *  @param originLatitude, originLongitude - geodetic angles of the origin in degrees, used for the rotation
+ *  @param targetX, targetY, targetZ - ECEF coordinates of the target (drone)
+ *  @param east, north, up - arrays that will be written with the ENU vector in meters
+ *  @param count - number of epochs in every array
+ */
+
+inline void lookAnglesFromEnu(const double *east, const double *north, const double *up,
+                              double *heading, double *elevation, double *slantDistance, std::size_t count){
+    for (std::size_t i = 0; i < count; ++i){
+        double horizontal = std::sqrt(east[i] * east[i] + north[i] * north[i]);
+        double azimuth = std::atan2(east[i], north[i]) * kRadiansToDegrees;
+        heading[i] = azimuth + 360.0 * (azimuth < 0.0); /// Wraps the heading to [0, 360) without a branch
+        elevation[i] = std::atan2(up[i], horizontal) * kRadiansToDegrees;
+        slantDistance[i] = std::sqrt(horizontal * horizontal + up[i] * up[i]);
+    }
+}
+/**
+ *  Function:   lookAnglesFromEnu
+ *              Calculates heading (azimuth clockwise from true north), elevation angle, and slant distance
+ *
+ *  @param east, north, up - ENU vector from the origin to the target in meters
+ *  @param heading - array that will be written with the heading in degrees
+ *  @param elevation - array that will be written with the elevation angle above the horizon in degrees
+ *  @param slantDistance - array that will be written with the straight line distance in meters
+ *  @param count - number of epochs in every array
+ */
+
+inline void computeLookAngles(const double *originLatitude, const double *originLongitude, const double *originAltitude,
+                              const double *targetLatitude, const double *targetLongitude, const double *targetAltitude,
+                              double *heading, double *elevation, double *slantDistance, std::size_t count){
+    double originX[kGeodesyBatchSize], originY[kGeodesyBatchSize], originZ[kGeodesyBatchSize];
+    double targetX[kGeodesyBatchSize], targetY[kGeodesyBatchSize], targetZ[kGeodesyBatchSize];
+    double east[kGeodesyBatchSize], north[kGeodesyBatchSize], up[kGeodesyBatchSize];
+    for (std::size_t start = 0; start < count; start += kGeodesyBatchSize){
+        std::size_t n = (count - start < kGeodesyBatchSize) ? count - start : kGeodesyBatchSize;
+        llhToEcef(originLatitude + start, originLongitude + start, originAltitude + start, originX, originY, originZ, n);
+        llhToEcef(targetLatitude + start, targetLongitude + start, targetAltitude + start, targetX, targetY, targetZ, n);
+        ecefToEnu(originX, originY, originZ, originLatitude + start, originLongitude + start,
+                  targetX, targetY, targetZ, east, north, up, n);
+        lookAnglesFromEnu(east, north, up, heading + start, elevation + start, slantDistance + start, n);
+    }
+}
+/**
+ *  Function:   computeLookAngles
+ *              Runs the whole calculations.m chain for paired epochs: LLH -> ECEF -> ENU -> look angles
+ *
+ *  @param originLatitude, originLongitude, originAltitude - Ublox receiver positions (degrees, meters)
+ *  @param targetLatitude, targetLongitude, targetAltitude - drone positions (degrees, meters)
+ *  @param heading, elevation, slantDistance - arrays that will be written with the results
+ *  @param count - number of paired epochs
+ */
+
+inline void computeLookAngles(const TelemetryStore &receiver, const TelemetryStore &drone, TelemetryStore &output){
+    std::size_t count = receiver.size() < drone.size() ? receiver.size() : drone.size();
+    if (output.size() < count) count = output.size();
+    computeLookAngles(receiver.latitude.data(), receiver.longitude.data(), receiver.altitude.data(),
+                      drone.latitude.data(), drone.longitude.data(), drone.altitude.data(),
+                      output.heading.data(), output.elevationAngle.data(), output.slantDistance.data(), count);
+}
+/**
+ *  Function:   computeLookAngles
+ *              Fills the heading, elevation angle, and slant distance columns of output for epochs paired by index
+ *
+ *  @param receiver - Ublox receiver epochs
+ *  @param drone - drone epochs
+ *  @param output - store whose geometry columns are written (usually receiver or drone)
+ */
+
+#endif
@@ -0,0 +1,394 @@
+/**
+ * @file: kml_writer.h
+ * @date: 10/16/2026
+ * @brief: KML writers for the drone ("Observation Platform") and Ublox ("Test Platform") tracks, shared by
+ *         parse_drone_csv.cc, parse_ublox_csv.cc, and parse_campaign.cc. Each track is a gx:Track Placemark with
+ *         a LookAt over the first epoch and the styles Google Earth uses for the movie and track icons.
+ *         KmlWriter formats numbers and timestamps straight into a 1 MB buffer, so writing a track makes no
+ *         allocation per epoch and no flush per line. The buffer goes either to a .kml file or through zlib's
+ *         deflate into a .kmz file (a zip archive holding doc.kml). Programs that include this file are
+ *         linked with -lz; without zlib.h only plain KML can be written.
+ */
+
+#ifndef KML_WRITER_H
+#define KML_WRITER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "telemetry_store.h"
+#include "pipeline.h"
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define KML_WRITER_HAS_ZLIB 1
+#endif
+
+const std::size_t kKmlBufferSize = 1 << 20;
+const std::size_t kKmlMaxFieldLength = 64;  /// Longest number or timestamp written in one call
+
+class KmlWriter{
+public:
+    KmlWriter() : buffer(kKmlBufferSize), used(0), opened(false), kmz(false), failed(false), crc(0), uncompressedSize(0), compressedSize(0) {}
+    ~KmlWriter(){ close(); }
+    KmlWriter(const KmlWriter &) = delete;
+    KmlWriter &operator=(const KmlWriter &) = delete;
+
+    void open(const std::string &fileName, bool compress){
+        close();
+        file.open(fileName);
+        failed = file.fail();
+        opened = !failed;
+        kmz = compress;
+        used = 0;
+        if (failed || !kmz) return;
+#ifdef KML_WRITER_HAS_ZLIB
+        std::memset(&deflateStream, 0, sizeof(deflateStream));
+        if (deflateInit2(&deflateStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+            failed = true;
+            return;
+        }
+        crc = crc32(0, nullptr, 0);
+        uncompressedSize = compressedSize = 0;
+        writeZipLocalHeader();
+#else
+        failed = true; /// KMZ output needs zlib
+#endif
+    }
+
+    void openAt(const std::string &fileName, off_t offset){ /// Plain KML only, for appending before a document's closing tags
+        close();
+        file.openAt(fileName, offset);
+        failed = file.fail();
+        opened = !failed;
+        kmz = false;
+        used = 0;
+    }
+
+    bool fail() const { return failed; }
+
+    void write(std::string_view text){
+        while (!text.empty()){
+            if (used == buffer.size()) flush();
+            std::size_t count = std::min(buffer.size() - used, text.size());
+            std::memcpy(buffer.data() + used, text.data(), count);
+            used += count;
+            text.remove_prefix(count);
+        }
+    }
+
+    void writeFixed(double value, int decimals){ /// Like an ostream with setprecision(decimals) and fixed
+        char *position = reserve();
+        used = std::to_chars(position, position + kKmlMaxFieldLength, value, std::chars_format::fixed, decimals).ptr - buffer.data();
+    }
+
+    void writeGeneral(double value){ /// Like an ostream with its default format, six significant digits
+        char *position = reserve();
+        used = std::to_chars(position, position + kKmlMaxFieldLength, value, std::chars_format::general, 6).ptr - buffer.data();
+    }
+
+    void writeTimestamp(std::int64_t time, int decimals){
+        used = formatIsoTimestamp(time, decimals, reserve()) - buffer.data();
+    }
+
+    bool close(){
+        if (!opened) return !failed;
+        opened = false;
+        flush();
+#ifdef KML_WRITER_HAS_ZLIB
+        if (kmz){
+            deflateChunk(Z_FINISH);
+            deflateEnd(&deflateStream);
+            writeZipTrailer();
+        }
+#endif
+        file.close();
+        failed = failed || file.fail();
+        return !failed;
+    }
+
+private:
+    char *reserve(){
+        if (buffer.size() - used < kKmlMaxFieldLength) flush();
+        return buffer.data() + used;
+    }
+
+    void flush(){
+        if (!kmz) file.write(buffer.data(), used);
+#ifdef KML_WRITER_HAS_ZLIB
+        else if (used > 0){
+            crc = crc32(crc, reinterpret_cast<const Bytef *>(buffer.data()), static_cast<uInt>(used));
+            uncompressedSize += used;
+            deflateStream.next_in = reinterpret_cast<Bytef *>(buffer.data());
+            deflateStream.avail_in = static_cast<uInt>(used);
+            deflateChunk(Z_NO_FLUSH);
+        }
+#endif
+        used = 0;
+    }
+
+#ifdef KML_WRITER_HAS_ZLIB
+    void deflateChunk(int mode){
+        unsigned char output[1 << 16];
+        while (true){
+            deflateStream.next_out = output;
+            deflateStream.avail_out = sizeof(output);
+            int result = deflate(&deflateStream, mode);
+            std::size_t produced = sizeof(output) - deflateStream.avail_out;
+            file.write(reinterpret_cast<const char *>(output), produced);
+            compressedSize += produced;
+            if (result == Z_STREAM_ERROR){
+                failed = true;
+                return;
+            }
+            if (mode == Z_FINISH ? result == Z_STREAM_END : deflateStream.avail_out != 0) return;
+        }
+    }
+
+    void writeLittleEndian(std::uint32_t value, int bytes){
+        char field[4];
+        for (int i = 0; i < bytes; ++i) field[i] = static_cast<char>(value >> (8 * i));
+        file.write(field, bytes);
+    }
+
+    /// Entry header with bit 3 set, so the CRC and sizes follow the data in a data descriptor
+    void writeZipLocalHeader(){
+        writeLittleEndian(0x04034b50, 4);
+        writeLittleEndian(20, 2); writeLittleEndian(0x0008, 2); writeLittleEndian(8, 2);
+        writeLittleEndian(0, 2); writeLittleEndian(0x21, 2);    /// 1980-01-01 00:00
+        writeLittleEndian(0, 4); writeLittleEndian(0, 4); writeLittleEndian(0, 4);
+        writeLittleEndian(sizeof(kEntryName) - 1, 2); writeLittleEndian(0, 2);
+        file.write(kEntryName, sizeof(kEntryName) - 1);
+    }
+
+    void writeZipTrailer(){
+        if (uncompressedSize > 0xffffffffu || compressedSize > 0xffffffffu) failed = true; /// Needs zip64
+        std::uint32_t entrySize = static_cast<std::uint32_t>(compressedSize);
+        writeLittleEndian(0x08074b50, 4);
+        writeLittleEndian(static_cast<std::uint32_t>(crc), 4);
+        writeLittleEndian(entrySize, 4); writeLittleEndian(static_cast<std::uint32_t>(uncompressedSize), 4);
+        std::uint32_t centralDirectoryOffset = 30 + (sizeof(kEntryName) - 1) + entrySize + 16;
+        writeLittleEndian(0x02014b50, 4);
+        writeLittleEndian(20, 2); writeLittleEndian(20, 2); writeLittleEndian(0x0008, 2); writeLittleEndian(8, 2);
+        writeLittleEndian(0, 2); writeLittleEndian(0x21, 2);
+        writeLittleEndian(static_cast<std::uint32_t>(crc), 4);
+        writeLittleEndian(entrySize, 4); writeLittleEndian(static_cast<std::uint32_t>(uncompressedSize), 4);
+        writeLittleEndian(sizeof(kEntryName) - 1, 2); writeLittleEndian(0, 2); writeLittleEndian(0, 2);
+        writeLittleEndian(0, 2); writeLittleEndian(0, 2); writeLittleEndian(0, 4); writeLittleEndian(0, 4);
+        file.write(kEntryName, sizeof(kEntryName) - 1);
+        std::uint32_t centralDirectorySize = 46 + (sizeof(kEntryName) - 1);
+        writeLittleEndian(0x06054b50, 4);
+        writeLittleEndian(0, 2); writeLittleEndian(0, 2); writeLittleEndian(1, 2); writeLittleEndian(1, 2);
+        writeLittleEndian(centralDirectorySize, 4); writeLittleEndian(centralDirectoryOffset, 4);
+        writeLittleEndian(0, 2);
+    }
+
+    static constexpr char kEntryName[] = "doc.kml";
+    z_stream deflateStream;
+#endif
+
+    BufferedFileWriter file;
+    std::vector<char> buffer;
+    std::size_t used;
+    bool opened;
+    bool kmz;
+    bool failed;
+    unsigned long crc;
+    std::uint64_t uncompressedSize;
+    std::uint64_t compressedSize;
+};
+/**
+ *  Class:      KmlWriter
+ *              Buffered output for a KML document, written as plain KML or as a KMZ archive. close returns false
+ *              if any part of the file could not be written.
+ */
+
+/// Movie icon styles of the drone track
+const char kDroneKmlStyles[] =
+    "    <Style id=\"sh_movies\">\n"
+    "        <IconStyle>\n"
+    "            <scale>1.4</scale>\n"
+    "            <Icon><href>http://earth.google.com/images/kml/shapes/movies.png</href></Icon>\n"
+    "hotSpot x=\"0.5\" y =\"0\" xunits=\"fraction\" yunits=\"fraction\"/>\n"
+    "        </IconStyle>\n"
+    "      <LineStyle><color>ff0880fd</color><width>4</width></LineStyle>\n"
+    "    </Style>\n"
+    "    <StyleMap id = \"msn_movies\">\n"
+    "        <Pair>\n"
+    "            <key>normal</key> <styleUrl>#sn_movies</styleUrl>\n"
+    "        </Pair>\n"
+    "        <Pair>\n"
+    "            <key>highlight</key> <styleUrl>#sh_movies</styleUrl>\n"
+    "        </Pair>\n"
+    "    </StyleMap>\n"
+    "    <Style id=\"sn_movies\">\n"
+    "        <IconStyle>\n"
+    "            <scale>1.2</scale>\n"
+    "            <Icon><href>http://earth.google.com/images/kml/shapes/movies.png</href></Icon>\n"
+    "            <hotSpot x=\"0.5\" y =\"0\" xunits=\"fraction\" yunits=\"fraction\"/>\n"
+    "        </IconStyle>\n"
+    "      <LineStyle><color>ff0880fd</color><width>4</width></LineStyle>\n"
+    "    </Style>\n";
+
+/// Track and multitrack styles of the Ublox track
+const char kUbloxKmlStyles[] =
+    "    <Style id=\"track_n\">\n"
+    "        <IconStyle>\n"
+    "            <scale>.5</scale>\n"
+    "            <Icon><href>http://earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon>\n"
+    "        </IconStyle>\n"
+    "      <LabelStyle><scale>0</scale></LabelStyle>\n"
+    "    </Style>\n"
+    "    <Style id=\"track_h\">\n"
+    "        <IconStyle>\n"
+    "            <scale>1.2</scale>\n"
+    "            <Icon><href>http://earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon>\n"
+    "        </IconStyle>\n"
+    "    </Style>\n"
+    "    <StyleMap id = \"track\">\n"
+    "        <Pair>\n"
+    "            <key>normal</key> <styleUrl>#track_n</styleUrl>\n"
+    "        </Pair>\n"
+    "        <Pair>\n"
+    "            <key>highlight</key> <styleUrl>#track_h</styleUrl>\n"
+    "        </Pair>\n"
+    "    </StyleMap>\n"
+    "    <!-- Normal Multitrack Style -->\n"
+    "    <Style id=\"multiTrack_n\">\n"
+    "        <IconStyle><scale>1.2</scale><Icon><href>http://earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon></IconStyle>\n"
+    "        <LineStyle><color>ff00ff00</color><width>6</width></LineStyle>\n"
+    "    </Style>\n"
+    "    <!-- Highlighted Multitrack Style -->\n"
+    "    <Style id=\"multiTrack_n\">\n"
+    "        <IconStyle><scale>1.2</scale><Icon><href>http://earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon></IconStyle>\n"
+    "        <LineStyle><color>99ffac59</color><width>8</width></LineStyle>\n"
+    "    </Style>\n"
+    "    <StyleMap id = \"multitrack\">\n"
+    "        <Pair>\n"
+    "            <key>normal</key> <styleUrl>#multitrack_n</styleUrl>\n"
+    "        </Pair>\n"
+    "        <Pair>\n"
+    "            <key>highlight</key> <styleUrl>#multitrack_h</styleUrl>\n"
+    "        </Pair>\n"
+    "    </StyleMap>\n";
+
+struct KmlTrackFormat{
+    const char *name;           /// Name of the platform's Placemark
+    const char *styles;         /// Style elements the Placemark refers to
+    const char *placemarkOpen;  /// Placemark text before the gx:Track
+    int timeDecimals;           /// Fractional second digits of <when>
+    int coordinateDecimals;     /// Decimals of longitude and latitude in <gx:coord>
+    int altitudeDecimals;       /// Decimals of altitude in <gx:coord>
+    const char *anglesOpen;     /// Text before the heading in <gx:angles>
+    const char *anglesClose;    /// Text after the elevation angle in <gx:angles>
+};
+
+const KmlTrackFormat kDroneTrackFormat = {
+    "Observation Platform", kDroneKmlStyles,
+    "    <Placemark>\n"
+    "        <name>Observation Platform</name>\n"
+    "        <Snippet></Snippet>\n"
+    "        <styleUrl>#msn_movies</styleUrl>\n"
+    "        <gx:balloonVisibility>0</gx:balloonVisibility>",
+    6, 6, 6, "            <gx:angles> ", " 0 </gx:angles>\n"};
+const KmlTrackFormat kUbloxTrackFormat = {
+    "Test Platform", kUbloxKmlStyles,
+    "    <Placemark>\n"
+    "        <name>Test Platform</name>\n"
+    "        <Snippet></Snippet>\n"
+    "        <styleUrl>#multiTrack</styleUrl>\n"
+    "        <gx:balloonVisibility>0</gx:balloonVisibility>\n",
+    3, 8, 3, "            <gx:angles>", " 0.0</gx:angles>\n"}; /// u-center exports 8 decimals for Lat/Lon and 3 for Alt
+
+inline void writeKmlTrack(KmlWriter &outs, const TelemetryStore &data, std::size_t first, std::size_t last,
+                          const KmlTrackFormat &format){
+    outs.write("        <gx:Track>\n");
+    for (std::size_t i = first; i < last; ++i){
+        outs.write("            <when>");
+        outs.writeTimestamp(data.time[i], format.timeDecimals);
+        outs.write("</when>\n");
+    }
+    for (std::size_t i = first; i < last; ++i){
+        outs.write("            <gx:coord>");
+        outs.writeFixed(data.longitude[i], format.coordinateDecimals);
+        outs.write(" ");
+        outs.writeFixed(data.latitude[i], format.coordinateDecimals);
+        outs.write(" ");
+        outs.writeFixed(data.altitude[i], format.altitudeDecimals);
+        outs.write("</gx:coord>\n");
+    }
+    for (std::size_t i = first; i < last; ++i){
+        outs.write(format.anglesOpen);
+        outs.writeFixed(data.heading[i], 6);
+        outs.write(" ");
+        outs.writeFixed(data.elevationAngle[i], 6);
+        outs.write(format.anglesClose);
+    }
+    outs.write("        </gx:Track>\n");
+}
+/**
+ *  Function:   writeKmlTrack
+ *              Writes epochs [first, last) of a store as a gx:Track: every <when>, then every <gx:coord>, then every
+ *              <gx:angles>, each section walking one or two columns of the store
+ */
+
+inline void writeKmlLookAt(KmlWriter &outs, const TelemetryStore &data, const KmlTrackFormat &format){
+    outs.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<kml xmlns= \"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+               "    <LookAt>\n        <gx:TimeSpan>\n            <begin>");
+    outs.writeTimestamp(data.time.front(), format.timeDecimals);
+    outs.write("</begin>\n            <end>");
+    outs.writeTimestamp(data.time.back(), format.timeDecimals);
+    outs.write("</end>\n        </gx:TimeSpan>\n            <longitude>");
+    outs.writeFixed(data.longitude[0], format.coordinateDecimals);
+    outs.write("</longitude>\n            <latitude>");
+    outs.writeFixed(data.latitude[0], format.coordinateDecimals);
+    outs.write("</latitude>\n            <tilt>"); /// This is the tilt angle - https://developers.google.com/kml/documentation/cameras
+    outs.writeGeneral(data.elevationAngle[0]);
+    outs.write("</tilt>\n            <heading>");
+    outs.writeGeneral(data.heading[0]);
+    outs.write("</heading>\n            <range>");
+    outs.writeGeneral(data.slantDistance[0]);
+    outs.write("</range>\n    </LookAt>\n");
+}
+/**
+ *  Function:   writeKmlLookAt
+ *              Writes the XML declaration, the kml element, and a LookAt over the first epoch spanning the whole track
+ */
+
+inline bool writeKmlDocument(const TelemetryStore &data, KmlWriter &outs, const KmlTrackFormat &format){
+    writeKmlLookAt(outs, data, format);
+    outs.write(format.styles);
+    outs.write(format.placemarkOpen);
+    writeKmlTrack(outs, data, 0, data.size(), format);
+    outs.write("        </Placemark>\n</kml>");
+    return outs.close();
+}
+/**
+ *  Function:   writeKmlDocument
+ *              Writes a whole track as one gx:Track Placemark with times, positions, and the look angles
+ *
+ *  @param data - epochs with UTC times and computed geometry
+ *  @param outs - opened writer, which is closed when the document is complete
+ *  @param format - kDroneTrackFormat ("Observation Platform") or kUbloxTrackFormat ("Test Platform")
+ *  @return false if the file could not be written
+ */
+
+/// Relative href of a file next to the document that links to it, with the spaces of "KML File for ..." escaped
+inline std::string kmlHref(std::string_view fileName){
+    std::string href;
+    for (char character : fileName){
+        if (character == ' ') href += "%20";
+        else href += character;
+    }
+    return href;
+}
+
+inline bool writeDroneKml(const TelemetryStore &data, KmlWriter &outs){ return writeKmlDocument(data, outs, kDroneTrackFormat); }
+inline bool writeUbloxKml(const TelemetryStore &data, KmlWriter &outs){ return writeKmlDocument(data, outs, kUbloxTrackFormat); }
+
+#endif
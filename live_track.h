@@ -0,0 +1,437 @@
+/**
+ * @file: live_track.h
+ * @date: 10/16/2026
+ * @brief: Follow mode for a telemetry file that is still being recorded, so a flight test can be watched in Google
+ *         Earth while it is flown. LiveTelemetryFeed tails the file with inotify (or a short poll where inotify is
+ *         not available) and parses only the records that have been completed since the last read; a record that
+ *         is still being written waits in a small buffer. LiveKmlPublisher turns the new epochs into track chunks:
+ *         "<base>.kml" is opened once in Google Earth and links "<base> track.kml", which holds the flight so far,
+ *         and "<base> update.kml", which Google Earth reloads every refresh interval. Every chunk is appended to
+ *         the track file and sent in a NetworkLinkControl Update that creates it in the loaded track, so an epoch
+ *         is on screen within about one refresh interval of reaching the disk. The update file repeats the chunks
+ *         of the last kLiveUpdateWindow seconds, so a viewer that skips a reload still receives them. Each is
+ *         deleted by its id before it is created again, so a chunk the viewer already has is not shown twice.
+ */
+
+#ifndef LIVE_TRACK_H
+#define LIVE_TRACK_H
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "telemetry_store.h"
+#include "telemetry_cache.h"
+#include "time_align.h"
+#include "kml_writer.h"
+#if __has_include(<sys/inotify.h>)
+#include <sys/inotify.h>
+#define LIVE_TRACK_HAS_INOTIFY 1
+#endif
+
+const double kLiveDefaultRefresh = 0.5;         /// Seconds between reloads of the update file by Google Earth
+const double kLiveUpdateWindow = 10.0;          /// Seconds of chunks repeated in every update file
+const int kLivePollMilliseconds = 50;           /// Longest sleep between size checks without inotify
+const int kLiveIdleWaitMilliseconds = 250;      /// Longest wait for the file to grow before checking for a stop
+const char kLiveTrackClose[] = "    </Folder>\n</Document>\n</kml>";
+
+struct LiveOptions{
+    bool follow = false;                        /// Keeps reading the input file as it grows
+    double refreshSeconds = kLiveDefaultRefresh;
+    double idleSeconds = 0;                     /// Stops following once the file has not grown for this long, 0 never
+};
+
+inline bool parseLiveOption(int &argumentIndex, int argc, char *argv[], LiveOptions &options){
+    std::string argument = argv[argumentIndex];
+    if (argument == "--follow"){
+        options.follow = true;
+        return true;
+    }
+    if (argumentIndex + 1 >= argc) return false;
+    double value = std::atof(argv[argumentIndex + 1]);
+    if (argument == "--refresh") options.refreshSeconds = value > 0 ? value : kLiveDefaultRefresh;
+    else if (argument == "--idle") options.idleSeconds = value;
+    else return false;
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseLiveOption
+ *              Reads "--follow", "--refresh seconds", or "--idle seconds" from the command line
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not a follow mode option
+ */
+
+inline volatile std::sig_atomic_t liveStopRequested = 0;
+
+inline void requestLiveStop(int){ liveStopRequested = 1; }
+
+class FileFollower{
+public:
+    FileFollower() : fileDescriptor(-1), notifyDescriptor(-1), offset(0) {}
+    ~FileFollower(){ close(); }
+    FileFollower(const FileFollower &) = delete;
+    FileFollower &operator=(const FileFollower &) = delete;
+
+    void open(const std::string &fileName){
+        close();
+        fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+        offset = 0;
+#ifdef LIVE_TRACK_HAS_INOTIFY
+        if (fileDescriptor < 0) return;
+        notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notifyDescriptor >= 0 && inotify_add_watch(notifyDescriptor, fileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0){
+            ::close(notifyDescriptor);
+            notifyDescriptor = -1; /// Falls back to polling the size
+        }
+#endif
+    }
+
+    bool fail() const { return fileDescriptor < 0; }
+    std::uint64_t bytesRead() const { return offset; }
+
+    bool readAppended(std::vector<char> &buffer){
+        struct stat fileStatus;
+        if (fstat(fileDescriptor, &fileStatus) != 0 || static_cast<std::uint64_t>(fileStatus.st_size) < offset) return false;
+        std::size_t available = static_cast<std::size_t>(fileStatus.st_size - offset);
+        std::size_t start = buffer.size();
+        buffer.resize(start + available);
+        std::size_t received = 0;
+        while (received < available){
+            ssize_t result = pread(fileDescriptor, buffer.data() + start + received, available - received, offset + received);
+            if (result <= 0) break;
+            received += static_cast<std::size_t>(result);
+        }
+        buffer.resize(start + received);
+        offset += received;
+        return true;
+    }
+
+    void wait(int timeoutMilliseconds){
+        if (notifyDescriptor < 0){
+            usleep(static_cast<useconds_t>(std::min(timeoutMilliseconds, kLivePollMilliseconds)) * 1000);
+            return;
+        }
+        struct pollfd descriptor = {notifyDescriptor, POLLIN, 0};
+        if (::poll(&descriptor, 1, timeoutMilliseconds) <= 0) return; /// Timed out, or interrupted by a stop signal
+        char events[4096];
+        while (::read(notifyDescriptor, events, sizeof(events)) > 0) {} /// Only the wake up matters, not the events
+    }
+
+    void close(){
+        if (notifyDescriptor >= 0) ::close(notifyDescriptor);
+        if (fileDescriptor >= 0) ::close(fileDescriptor);
+        notifyDescriptor = fileDescriptor = -1;
+    }
+
+private:
+    int fileDescriptor;
+    int notifyDescriptor;
+    std::uint64_t offset;   /// Bytes of the file read so far
+};
+/**
+ *  Class:      FileFollower
+ *              Reads a file that another program appends to. readAppended adds the bytes written since the last
+ *              call to a buffer and returns false if the file has been truncated; wait blocks until the file is
+ *              written to or the timeout passes.
+ */
+
+class LiveTelemetryFeed{
+public:
+    LiveTelemetryFeed() : kind(TelemetrySource::Srt), headerLength(0), malformedCount(0), truncatedFile(false), invalidHeader(false) {}
+
+    void open(const std::string &fileName, TelemetrySource sourceKind){
+        follower.open(fileName);
+        kind = sourceKind;
+        pending.clear();
+        headerLength = 0;
+        malformedCount = 0;
+        truncatedFile = false;
+        invalidHeader = false;
+    }
+
+    bool fail() const { return follower.fail(); }
+
+    long long poll(TelemetryStore &data){
+        if (!follower.readAppended(pending)){
+            truncatedFile = true;
+            return -1;
+        }
+        if (kind == TelemetrySource::UbloxCsv && headerLength == 0){ /// The header stays at the front for loadUbloxCsv
+            if (pending.size() < 2) return 0;
+            if (isUbxFile(std::string(), pending.data(), pending.size())){ /// A UBX log not named .ubx, told by its sync bytes
+                kind = TelemetrySource::Ubx;
+                return parsePending(data, false);
+            }
+            const char *headerEnd = static_cast<const char *>(std::memchr(pending.data(), '\n', pending.size()));
+            if (headerEnd == nullptr) return 0;
+            headerLength = headerEnd + 1 - pending.data();
+            invalidHeader = UbloxCsvReader(pending.data(), pending.data() + headerLength).fail();
+            if (invalidHeader) return -1;
+        }
+        return parsePending(data, false);
+    }
+
+    long long finish(TelemetryStore &data){
+        if (invalidHeader || (kind == TelemetrySource::UbloxCsv && headerLength == 0)) return 0;
+        return parsePending(data, true);
+    }
+
+    void wait(int timeoutMilliseconds){ follower.wait(timeoutMilliseconds); }
+    std::uint64_t bytesRead() const { return follower.bytesRead(); }
+    TelemetrySource source() const { return kind; }
+    bool truncated() const { return truncatedFile; }
+    bool missingColumns() const { return invalidHeader; }
+    long long malformedRecords() const { return malformedCount; }
+
+private:
+    long long parsePending(TelemetryStore &data, bool lastRecordComplete){
+        const char *rows = pending.data() + headerLength;
+        std::size_t rowBytes = pending.size() - headerLength;
+        std::size_t before = data.size(), complete = rowBytes;
+        if (lastRecordComplete) loadTelemetryRange(data, kind, pending.data(), rows, rows + rowBytes, 1, malformedCount);
+        else complete = loadCompleteRecords(data, kind, pending.data(), rows, rows + rowBytes, 1, malformedCount);
+        pending.erase(pending.begin() + headerLength, pending.begin() + headerLength + complete);
+        return static_cast<long long>(data.size() - before);
+    }
+
+    FileFollower follower;
+    TelemetrySource kind;
+    std::vector<char> pending;  /// The u-center header line, then the bytes of a record that is not complete yet
+    std::size_t headerLength;
+    long long malformedCount;
+    bool truncatedFile;
+    bool invalidHeader;
+};
+/**
+ *  Class:      LiveTelemetryFeed
+ *              Parses a growing SRT, drone CSV, or u-center CSV File into a store as its records are completed.
+ *              poll appends the records completed since the last call and returns how many there were, or -1 if
+ *              the u-center header is missing a required column or the file was truncated (missingColumns and
+ *              truncated tell which). finish parses the last record once the file is known to be complete.
+ *              A file opened as a u-center CSV File that starts with UBX sync bytes is parsed as a UBX log, which
+ *              source then reports.
+ */
+
+inline long long alignLiveEpochs(TelemetryStore &data, std::size_t first, const TelemetryStore &other, bool dataIsDrone,
+                                 std::int64_t tolerance){
+    if (first >= data.size() || other.empty()) return static_cast<long long>(data.size() - std::min(first, data.size()));
+    TelemetryStore epochs;
+    epochs.reserve(data.size() - first);
+    for (std::size_t i = first; i < data.size(); ++i) epochs.append(data, i);
+    std::size_t next = std::lower_bound(other.time.begin(), other.time.end(), data.time[first] - tolerance) - other.time.begin();
+    std::int64_t lastTime = data.time.back() + tolerance;
+    long long unmatched = alignLookAngles(epochs, [&](TelemetryRecord &entry){
+        if (next == other.size() || other.time[next] > lastTime) return false; /// Later epochs cannot match
+        entry = other.record(next++);
+        return true;
+    }, dataIsDrone, tolerance);
+    std::copy(epochs.heading.begin(), epochs.heading.end(), data.heading.begin() + first);
+    std::copy(epochs.elevationAngle.begin(), epochs.elevationAngle.end(), data.elevationAngle.begin() + first);
+    std::copy(epochs.slantDistance.begin(), epochs.slantDistance.end(), data.slantDistance.begin() + first);
+    return unmatched;
+}
+/**
+ *  Function:   alignLiveEpochs
+ *              Fills the look angles of the epochs from first on, matched by time against the other platform, so
+ *              only the new epochs of a live track are computed. Both stores must be in UTC and in time order.
+ *
+ *  @param other - every epoch of the other platform
+ *  @param dataIsDrone - true when data holds the drone and other the Ublox receiver
+ *  @return number of new epochs without a match within the tolerance
+ */
+
+class LiveKmlPublisher{
+public:
+    LiveKmlPublisher(const std::string &fileBase, const KmlTrackFormat &format, double refreshSeconds)
+        : rootFileName(fileBase + ".kml"), trackFileName(fileBase + " track.kml"), updateFileName(fileBase + " update.kml"),
+          format(format), refreshSeconds(refreshSeconds), publishedCount(0), chunkCount(0), trackTail(0) {}
+
+    bool pending(const TelemetryStore &data) const { return data.size() > publishedCount; }
+    const std::string &fileName() const { return rootFileName; }
+
+    bool publish(const TelemetryStore &data){
+        if (!pending(data)) return true;
+        Chunk chunk = {publishedCount > 0 ? publishedCount - 1 : 0, data.size(), chunkCount++, std::chrono::steady_clock::now()};
+        publishedCount = data.size(); /// A chunk starts at the last epoch of the one before, so the line has no gaps
+        if (chunk.id == 0) return writeStart(data, chunk);
+        KmlWriter outs;
+        outs.openAt(trackFileName, static_cast<off_t>(trackTail));
+        if (outs.fail()) return false;
+        writeChunk(outs, data, chunk); /// Overwrites the closing tags and writes them again after the chunk
+        outs.write(kLiveTrackClose);
+        if (!outs.close() || !findTrackTail()) return false;
+        window.push_back(chunk);
+        while (window.size() > 1 && chunk.published - window.front().published > std::chrono::duration<double>(kLiveUpdateWindow))
+            window.pop_front();
+        return writeUpdate(data);
+    }
+
+private:
+    struct Chunk{
+        std::size_t first;
+        std::size_t last;
+        std::size_t id;
+        std::chrono::steady_clock::time_point published;
+    };
+
+    bool writeStart(const TelemetryStore &data, const Chunk &chunk){
+        KmlWriter outs;
+        outs.open(trackFileName, false);
+        if (outs.fail()) return false;
+        outs.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<kml xmlns= \"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+                   "<Document>\n");
+        outs.write(format.styles);
+        outs.write("    <Folder id=\"chunks\">\n");
+        writeChunk(outs, data, chunk);
+        outs.write(kLiveTrackClose);
+        if (!outs.close() || !findTrackTail() || !writeUpdate(data)) return false;
+
+        outs.open(rootFileName, false);
+        if (outs.fail()) return false;
+        writeKmlLookAt(outs, data, format);
+        outs.write("<Document>\n    <NetworkLink>\n        <name>");
+        outs.write(format.name);
+        outs.write("</name>\n        <Link><href>");
+        outs.write(kmlHref(std::filesystem::path(trackFileName).filename().string()));
+        outs.write("</href></Link>\n    </NetworkLink>\n    <NetworkLink>\n        <name>");
+        outs.write(format.name);
+        outs.write(" updates</name>\n        <Link><href>");
+        outs.write(kmlHref(std::filesystem::path(updateFileName).filename().string()));
+        outs.write("</href><refreshMode>onInterval</refreshMode><refreshInterval>");
+        outs.writeGeneral(refreshSeconds);
+        outs.write("</refreshInterval></Link>\n    </NetworkLink>\n</Document>\n</kml>");
+        return outs.close();
+    }
+
+    void writeChunk(KmlWriter &outs, const TelemetryStore &data, const Chunk &chunk){
+        std::string_view placemarkOpen = format.placemarkOpen;
+        std::string_view placemarkTag = "    <Placemark>";
+        outs.write("    <Placemark id=\"chunk");
+        outs.write(std::to_string(chunk.id));
+        outs.write("\">");
+        if (placemarkOpen.substr(0, placemarkTag.size()) == placemarkTag) placemarkOpen.remove_prefix(placemarkTag.size());
+        outs.write(placemarkOpen);
+        writeKmlTrack(outs, data, chunk.first, chunk.last, format);
+        outs.write("        </Placemark>\n");
+    }
+
+    /// Writes the update file next to the old one and renames it into place, so Google Earth never reads half of it
+    bool writeUpdate(const TelemetryStore &data){
+        std::string temporaryFileName = updateFileName + ".tmp";
+        KmlWriter outs;
+        outs.open(temporaryFileName, false);
+        if (outs.fail()) return false;
+        outs.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<kml xmlns= \"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+                   "<NetworkLinkControl>\n");
+        if (!window.empty()){
+            outs.write("    <Update>\n        <targetHref>");
+            outs.write(kmlHref(std::filesystem::path(trackFileName).filename().string()));
+            outs.write("</targetHref>\n        <Delete>\n"); /// Removes the copy from the track file or an earlier reload
+            for (const Chunk &chunk : window){
+                outs.write("            <Placemark targetId=\"chunk");
+                outs.write(std::to_string(chunk.id));
+                outs.write("\"/>\n");
+            }
+            outs.write("        </Delete>\n        <Create><Folder targetId=\"chunks\">\n");
+            for (const Chunk &chunk : window) writeChunk(outs, data, chunk);
+            outs.write("        </Folder></Create>\n    </Update>\n");
+        }
+        outs.write("</NetworkLinkControl>\n</kml>");
+        if (!outs.close() || std::rename(temporaryFileName.c_str(), updateFileName.c_str()) != 0){
+            std::remove(temporaryFileName.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool findTrackTail(){ /// Where the next chunk goes: just before the closing tags
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(trackFileName, error);
+        if (error || size < sizeof(kLiveTrackClose) - 1) return false;
+        trackTail = size - (sizeof(kLiveTrackClose) - 1);
+        return true;
+    }
+
+    std::string rootFileName;
+    std::string trackFileName;
+    std::string updateFileName;
+    const KmlTrackFormat &format;
+    double refreshSeconds;
+    std::size_t publishedCount;     /// Epochs already in a chunk
+    std::size_t chunkCount;
+    std::uint64_t trackTail;
+    std::deque<Chunk> window;       /// Chunks repeated in the update file
+};
+/**
+ *  Class:      LiveKmlPublisher
+ *              Publishes a growing track for Google Earth. The first publish writes the track file with every
+ *              epoch so far, an empty update file, and the root file that links the two; each later publish
+ *              appends a chunk with the new epochs to the track file and rewrites the update file.
+ *
+ *  @param fileBase - name of the root file without ".kml", e.g. "KML File for Ublox GPS PVT Data.csv live"
+ *  @param format - kDroneTrackFormat or kUbloxTrackFormat
+ *  @param refreshSeconds - how often Google Earth reloads the update file
+ */
+
+template <class NewEpochHandler>
+bool followTelemetry(LiveTelemetryFeed &feed, TelemetryStore &data, LiveKmlPublisher &publisher, const LiveOptions &options,
+                     NewEpochHandler handleNewEpochs){
+    typedef std::chrono::steady_clock Clock;
+    std::signal(SIGINT, requestLiveStop);
+    std::signal(SIGTERM, requestLiveStop);
+    Clock::duration publishInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.refreshSeconds / 2));
+    Clock::duration idleTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.idleSeconds));
+    Clock::time_point lastGrowth = Clock::now(), lastPublish = lastGrowth - publishInterval;
+    while (!liveStopRequested){
+        std::size_t first = data.size();
+        std::uint64_t bytesBefore = feed.bytesRead();
+        if (feed.poll(data) < 0) return false;
+        Clock::time_point now = Clock::now();
+        if (feed.bytesRead() > bytesBefore) lastGrowth = now; /// Part of a record still counts as activity
+        if (data.size() > first) handleNewEpochs(first);
+        if (publisher.pending(data) && now - lastPublish >= publishInterval){
+            if (!publisher.publish(data)) return false;
+            lastPublish = now;
+        }
+        if (options.idleSeconds > 0 && now - lastGrowth >= idleTime) break;
+        int timeout = kLiveIdleWaitMilliseconds;
+        if (publisher.pending(data)) /// Wakes up in time to publish the epochs that are waiting
+            timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(lastPublish + publishInterval - now).count()) + 1;
+        feed.wait(std::max(1, timeout));
+    }
+    std::size_t first = data.size();
+    feed.finish(data); /// The recorder has stopped, so a last record without its terminator is complete
+    if (data.size() > first) handleNewEpochs(first);
+    return publisher.publish(data);
+}
+/**
+ *  Function:   followTelemetry
+ *              Follows a growing file until it has been idle for options.idleSeconds or the program is sent
+ *              SIGINT (Ctrl+C) or SIGTERM. New epochs are handed to handleNewEpochs as soon as they are parsed and
+ *              published at most twice per refresh interval, so each chunk holds every epoch since the last one.
+ *
+ *  @param feed - opened feed of the input file
+ *  @param data - store that the epochs are appended to
+ *  @param handleNewEpochs - callable void(std::size_t first) that fills in epochs [first, data.size()), e.g. their
+ *                           UTC times and look angles, before they are published
+ *  @return false if the file was truncated, its header is missing a column, or the KML Files could not be written
+ */
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file: mapped_file.h
+ * @date: 10/16/2026
+ * @brief: Read-only memory mapping of an input file. The parsers scan the mapped bytes in place instead of
+ *         copying every line into a std::string with getline. The interface follows ifstream
+ *         (open, fail, close) so it can be swapped in where the programs used to open an ifstream.
+ *         A gzip or zstd compressed file is decoded on a background thread (compressed_input.h) and the range
+ *         is the decoded text. begin, end, and size wait for the whole file; a reader that can work on a prefix
+ *         calls waitForBytes and reads from streamBegin while the rest is still being decoded.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "compressed_input.h"
+
+class MappedFile{
+public:
+    MappedFile() : data(nullptr), length(0), failed(false) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    void open(const std::string &fileName, bool decompress = true){
+        close();
+        failed = true;
+        int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) return;
+        struct stat fileStatus;
+        if (fstat(fileDescriptor, &fileStatus) == 0){
+            length = static_cast<std::size_t>(fileStatus.st_size);
+            if (length == 0){
+                failed = false; /// An empty file maps to an empty range
+            }
+            else {
+                void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+                if (mapping != MAP_FAILED){
+                    data = static_cast<const char *>(mapping);
+                    madvise(mapping, length, MADV_SEQUENTIAL); /// The parsers read front to back
+                    failed = false;
+                }
+                else length = 0;
+            }
+        }
+        ::close(fileDescriptor); /// The mapping stays valid after the descriptor is closed
+        InputCompression compression = detectCompression(data, length);
+        if (failed || !decompress || compression == InputCompression::None) return;
+        decoder.reset(new BackgroundDecoder);
+        if (decoder->start(compression, data, length, fileName)) return;
+        decoder.reset();
+        failed = true;
+    }
+
+    void close(){
+        decoder.reset(); /// Stops the decoder thread, which reads the mapping
+        if (data != nullptr) munmap(const_cast<char *>(data), length);
+        data = nullptr;
+        length = 0;
+    }
+
+    void release(const char *upTo){ /// Drops the pages before upTo that a streaming reader has finished with
+        const char *first = streamBegin();
+        if (first == nullptr || upTo < first) return;
+        if (decoder) decoder->release(static_cast<std::size_t>(upTo - first)); /// Also keeps decoding close behind upTo
+        std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t releaseLength = static_cast<std::size_t>(upTo - first) / pageSize * pageSize;
+        if (releaseLength > 0) madvise(const_cast<char *>(first), releaseLength, MADV_DONTNEED);
+    }
+
+    bool fail() const { return failed; }
+    bool compressed() const { return decoder != nullptr; }
+    const char *begin() const { return decoder ? (decoder->wait(), decoder->data()) : data; }
+    const char *end() const { return decoder ? decoder->data() + decoder->wait() : data + length; }
+    std::size_t size() const { return decoder ? decoder->wait() : length; }
+
+    const char *streamBegin() const { return decoder ? decoder->data() : data; }
+
+    std::size_t waitForBytes(std::size_t wanted, bool *finished = nullptr) const {
+        if (decoder) return decoder->waitForBytes(wanted, finished);
+        if (finished != nullptr) *finished = true;
+        return length;
+    }
+
+private:
+    const char *data;
+    std::size_t length;
+    bool failed;
+    std::unique_ptr<BackgroundDecoder> decoder;
+};
+/**
+ *  Class:      MappedFile
+ *              waitForBytes blocks until at least wanted bytes from streamBegin can be read, or the file has been
+ *              read to its end, and returns how many can be read, setting finished in the second case. For a file
+ *              that is not compressed it returns the whole file at once. Once a streaming reader has called
+ *              release, a compressed file is decoded only kDecodeLead bytes ahead of it.
+ */
+
+#endif
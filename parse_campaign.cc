@@ -0,0 +1,543 @@
+/**
+ * @file: parse_campaign.cc
+ * @date: 10/16/2026
+ * @brief: This program processes a whole test campaign at once. For every flight, a DJI SRT File paired with the
+ * u-center CSV File of the Ublox receiver, it writes the same files as running parse_srt.cc, parse_drone_csv.cc,
+ * and parse_ublox_csv.cc by hand: the per frame and Epic-by-Epic CSV Files and the two KML Files. Output files are
+ * written next to the SRT and u-center files. Flights run on a work-stealing pool (work_pool.h), longest first,
+ * and the outcome of each flight is printed at the end.
+ * A rerun only does the work its changes need. The stages of each flight (the two drone CSV Files, then the
+ * track files) are recorded in "<SRT File>.stages" (stage_ledger.h) with a key made from the content hashes of their
+ * inputs and the options they use, and a stage whose key and outputs are unchanged is skipped. Parsed inputs come
+ * from telemetry_cache.h caches, so an SRT or u-center CSV File that has grown only has its new records parsed.
+ * The campaign is either a manifest, a text file with one "SRT File, u-center CSV File" pair per line (relative
+ * paths are from the manifest's folder, lines starting with # are skipped), or a folder. In a folder and in each
+ * of its sub folders, every .SRT File is paired with the u-center CSV File of the same name, or with the only
+ * u-center CSV File of that folder when no SRT File has its name. A raw .ubx log of the receiver (ubx_parser.h) is paired the same way and
+ * can stand in for the u-center CSV File. A receiver file paired with more than one SRT File, such as the only
+ * u-center CSV File of a folder with several unmatched SRT Files, fails each of those flights instead of having
+ * them overwrite its outputs at once, and so does an SRT File that a manifest lists more than once. Any of these files may be gzip or zstd compressed (compressed_input.h),
+ * named with a .gz or .zst extension in a folder, and is then decoded while it is parsed and not cached.
+ * Each flight also gets a statistics stage (accuracy_stats.h) that summarizes the receiver's error against the drone
+ * in "Accuracy for <SRT File>.csv" and saves the mergeable sketches in "<SRT File>.stats". The flights'
+ * sketches, read back from those files when the stage is current, are merged into "Campaign Accuracy.csv" in the
+ * campaign folder (or the manifest's folder).
+ * An index stage writes the frames of the SRT File and the epochs of the receiver, in UTC, as spatial index segments
+ * "<file>.spatial" (spatial_index.h), and the segments of every flight are listed in "Campaign Index.catalog" next
+ * to "Campaign Accuracy.csv", which campaign_query.cc searches by place and time.
+ * --export chooses the formats of the drone and receiver tracks (track_export.h), each written in one pass: any of
+ * csv, geojson, gpx, and kml, or all. Only the KML Files are written by default.
+ * --metrics <file> writes the time and counts of each stage, summed over the flights, and the peak memory of the run
+ * as JSON (run_metrics.h).
+ * Usage: parse_campaign [-j threads] [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--kmz]
+ * [--simplify meters] [--tiles seconds] [--export formats] [--no-cache] [--metrics file] <campaign folder or manifest>. -j 0 (the
+ * default) uses every core; the KML, export, and cache options are those of parse_drone_csv.cc and parse_ublox_csv.cc.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <map>
+#include <set>
+#include "mapped_file.h"
+#include "telemetry_store.h"
+#include "srt_parser.h"
+#include "drone_csv.h"
+#include "ublox_csv.h"
+#include "ubx_parser.h"
+#include "time_align.h"
+#include "kml_writer.h"
+#include "track_lod.h"
+#include "telemetry_cache.h"
+#include "stage_ledger.h"
+#include "work_pool.h"
+#include "accuracy_stats.h"
+#include "track_export.h"
+#include "run_metrics.h"
+#include "spatial_index.h"
+using namespace std;
+namespace fs = std::filesystem;
+
+struct Flight{
+    fs::path srtFile;
+    fs::path ubloxFile;
+    uintmax_t bytes = 0;            /// Size of the SRT File, used to start the longest flights first
+    bool succeeded = false;
+    bool upToDate = false;          /// Every stage was current, so nothing was run
+    string outcome;
+    size_t frames = 0;
+    size_t seconds = 0;
+    size_t receiverEpochs = 0;
+    long long unmatchedDroneEpochs = 0;
+    long long unmatchedReceiverEpochs = 0;
+    double elapsedSeconds = 0;
+    AccuracyStatistics accuracy;    /// Errors of the receiver against the drone, valid once the flight succeeded
+};
+
+void readManifest(vector<Flight> &flights, const fs::path &manifestFile);
+/**
+ *  Function:   readManifest
+ *              Fills the flight vector from a manifest of "SRT File, u-center CSV File" lines
+ *
+ *  @param flights - vector that will be written with one entry per flight
+ *  @param manifestFile - name of the manifest
+ */
+
+void findFlights(vector<Flight> &flights, const fs::path &campaignFolder);
+/**
+ *  Function:   findFlights
+ *              Fills the flight vector with the SRT and u-center CSV pairs of a folder and its sub folders
+ *
+ *  @param flights - vector that will be written with one entry per flight
+ *  @param campaignFolder - folder of the campaign
+ */
+
+void refuseSharedInputs(vector<Flight> &flights);
+/**
+ *  Function:   refuseSharedInputs
+ *              Fails every flight whose SRT File is listed more than once, or whose receiver file is paired with
+ *              another SRT File too. A flight writes the outputs of its SRT File (CSV Files, cache, stage ledger,
+ *              "<SRT File>.stats", and spatial index) and of its receiver file (KML File, cache, and spatial index),
+ *              so flights sharing either would write the same files at the same time.
+ *
+ *  @param flights - flights of the campaign; the refused ones are given their outcome and are not processed
+ */
+
+void processFlight(Flight &flight, const AlignmentOptions &options, const KmlOutputOptions &kmlOptions,
+                   const ExportOptions &exportOptions, bool useCache);
+/**
+ *  Function:   processFlight
+ *              Runs every stage for one flight and records the outcome in the flight instead of exiting, so one
+ *              bad flight does not stop the campaign
+ *
+ *  @param flight - flight to process
+ *  @param options - drone clock offset and pairing tolerance
+ *  @param kmlOptions - KMZ output, simplification, and tiling of the KML Files
+ *  @param exportOptions - formats the drone and receiver tracks are written in
+ *  @param useCache - whether parsed inputs are read from and written to telemetry_cache.h caches
+ */
+
+void printOutcomes(const vector<Flight> &flights);
+/**
+ *  Function:   printOutcomes
+ *              Prints one line per flight and a summary
+ */
+
+void writeCampaignAccuracy(const vector<Flight> &flights, const fs::path &outputFolder);
+/**
+ *  Function:   writeCampaignAccuracy
+ *              Merges the accuracy statistics of every flight that succeeded, each receiver file once, and writes
+ *              "Campaign Accuracy.csv"
+ *
+ *  @param flights - processed flights
+ *  @param outputFolder - folder the summary is written to
+ */
+
+void writeCampaignIndex(const vector<Flight> &flights, const fs::path &outputFolder);
+/**
+ *  Function:   writeCampaignIndex
+ *              Lists the spatial index segments of every flight that succeeded in "Campaign Index.catalog", read
+ *              back from their headers so flights that were up to date are listed too
+ *
+ *  @param flights - processed flights
+ *  @param outputFolder - folder the catalog is written to
+ */
+
+int main(int argc, char *argv[]){
+    unsigned threadCount = 0;
+    AlignmentOptions options;
+    KmlOutputOptions kmlOptions;
+    ExportOptions exportOptions;
+    bool useCache = true;
+    string campaignName;
+    const char *usage = "Usage: parse_campaign [-j threads] [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--kmz] [--simplify meters] [--tiles seconds] [--export csv,geojson,gpx,kml] [--no-cache] [--metrics file] <campaign folder or manifest>";
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc){
+            const char *count = argv[++i], *countEnd = count + strlen(count);
+            from_chars_result parsed = from_chars(count, countEnd, threadCount);
+            if (parsed.ec != errc() || parsed.ptr != countEnd){
+                cout << usage << endl;
+                exit(0);
+            }
+        }
+        else if (parseAlignmentOption(i, argc, argv, options)) continue;
+        else if (parseKmlOutputOption(i, argc, argv, kmlOptions)) continue;
+        else if (parseExportOption(i, argc, argv, exportOptions)) continue;
+        else if (parseMetricsOption(i, argc, argv)) continue;
+        else if (argument == "--no-cache") useCache = false;
+        else if (argument[0] != '-' && campaignName.empty()) campaignName = argument;
+        else {
+            cout << usage << endl;
+            exit(0);
+        }
+    }
+    if (campaignName.empty()){
+        cout << "Enter name of campaign folder or manifest: ";
+        cin >> campaignName;
+    }
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    vector<Flight> flights;
+    error_code error;
+    if (fs::is_directory(campaignName, error)) findFlights(flights, campaignName);
+    else if (fs::is_regular_file(campaignName, error)) readManifest(flights, campaignName);
+    else {
+        cout << "Error opening the campaign folder or manifest." << endl;
+        exit(0);
+    }
+    if (flights.empty()){
+        cout << "The campaign has no flights." << endl;
+        exit(0);
+    }
+    refuseSharedInputs(flights);
+
+    vector<Flight *> longestFirst;
+    for (size_t i = 0; i < flights.size(); ++i) longestFirst.push_back(&flights[i]);
+    stable_sort(longestFirst.begin(), longestFirst.end(), [](const Flight *a, const Flight *b){ return a->bytes > b->bytes; });
+    WorkStealingPool pool(min<size_t>(threadCount, flights.size()));
+    for (Flight *flight : longestFirst){
+        if (!flight->outcome.empty()) continue; /// Refused before processing
+        pool.add([flight, &options, &kmlOptions, &exportOptions, useCache](){
+            processFlight(*flight, options, kmlOptions, exportOptions, useCache);
+        });
+    }
+    pool.run();
+    printOutcomes(flights);
+    fs::path outputFolder = fs::is_directory(campaignName, error) ? fs::path(campaignName) : fs::path(campaignName).parent_path();
+    writeCampaignAccuracy(flights, outputFolder);
+    writeCampaignIndex(flights, outputFolder);
+    for (size_t i = 0; i < flights.size(); ++i){
+        if (!flights[i].succeeded) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Strips spaces, tabs, quotes, and a carriage return from both ends
+static string trimField(string field){
+    const char *blank = " \t\"\r";
+    size_t first = field.find_first_not_of(blank);
+    if (first == string::npos) return "";
+    return field.substr(first, field.find_last_not_of(blank) - first + 1);
+}
+
+void readManifest(vector<Flight> &flights, const fs::path &manifestFile){
+    ifstream manifest(manifestFile);
+    if (manifest.fail()){
+        cout << "Error opening the manifest." << endl;
+        exit(0);
+    }
+    fs::path folder = manifestFile.parent_path();
+    string line;
+    int lineNumber = 0;
+    while (getline(manifest, line)){
+        lineNumber++;
+        line = trimField(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t separator = line.find_first_of(",\t");
+        if (separator == string::npos){
+            cout << "Line " << lineNumber << " of the manifest does not name both an SRT File and a u-center CSV File." << endl;
+            exit(0);
+        }
+        Flight flight;
+        flight.srtFile = folder / trimField(line.substr(0, separator));
+        flight.ubloxFile = folder / trimField(line.substr(separator + 1));
+        error_code error;
+        flight.bytes = fs::file_size(flight.srtFile, error);
+        if (error) flight.bytes = 0;
+        flights.push_back(flight);
+    }
+}
+
+/// True if the first line of the file is a u-center PVT CSV header; only that line of a compressed file is decoded
+static bool isUbloxCsvFile(const fs::path &fileName){
+    MappedFile file;
+    file.open(fileName.string());
+    if (file.fail()) return false;
+    bool finished = false;
+    size_t available = file.waitForBytes(1, &finished);
+    while (!finished && memchr(file.streamBegin(), '\n', available) == nullptr) available = file.waitForBytes(available + 1, &finished);
+    if (available == 0) return false;
+    const char *lineEnd = static_cast<const char *>(memchr(file.streamBegin(), '\n', available));
+    string header(file.streamBegin(), lineEnd == nullptr ? available : static_cast<size_t>(lineEnd - file.streamBegin()));
+    UbloxCsvLayout layout;
+    return mapUbloxCsvHeader(header, layout);
+}
+
+/// File name without a .gz or .zst extension, so an archived file is paired by the name it had before compression
+static fs::path uncompressedName(const fs::path &fileName){
+    string extension = fileName.extension().string();
+    transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return tolower(c); });
+    return extension == ".gz" || extension == ".zst" ? fileName.parent_path() / fileName.stem() : fileName;
+}
+
+static bool hasExtension(const fs::path &fileName, const char *extension){
+    string fileExtension = uncompressedName(fileName).extension().string();
+    transform(fileExtension.begin(), fileExtension.end(), fileExtension.begin(), [](unsigned char c){ return tolower(c); });
+    return fileExtension == extension;
+}
+
+void findFlights(vector<Flight> &flights, const fs::path &campaignFolder){
+    vector<fs::path> folders = {campaignFolder};
+    error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(campaignFolder, error)){
+        if (entry.is_directory()) folders.push_back(entry.path());
+    }
+    sort(folders.begin() + 1, folders.end());
+    for (const fs::path &folder : folders){
+        vector<fs::path> srtFiles, ubloxFiles;
+        for (const fs::directory_entry &entry : fs::directory_iterator(folder, error)){
+            if (!entry.is_regular_file()) continue;
+            if (hasExtension(entry.path(), ".srt")) srtFiles.push_back(entry.path());
+            else if (hasExtension(entry.path(), ".csv") && isUbloxCsvFile(entry.path())) ubloxFiles.push_back(entry.path());
+            else if (hasExtension(entry.path(), ".ubx")) ubloxFiles.push_back(entry.path());
+        }
+        sort(srtFiles.begin(), srtFiles.end());
+        auto sameName = [](const fs::path &a, const fs::path &b){ return uncompressedName(a).stem() == uncompressedName(b).stem(); };
+        bool loneReceiverNamed = ubloxFiles.size() == 1 && any_of(srtFiles.begin(), srtFiles.end(), [&](const fs::path &srtFile){
+            return sameName(srtFile, ubloxFiles[0]);
+        });
+        for (const fs::path &srtFile : srtFiles){
+            Flight flight;
+            flight.srtFile = srtFile;
+            for (const fs::path &ubloxFile : ubloxFiles){
+                if (sameName(ubloxFile, srtFile)) flight.ubloxFile = ubloxFile;
+            }
+            if (flight.ubloxFile.empty() && ubloxFiles.size() == 1 && !loneReceiverNamed) flight.ubloxFile = ubloxFiles[0];
+            flight.bytes = fs::file_size(srtFile, error);
+            if (error) flight.bytes = 0;
+            flights.push_back(flight);
+        }
+    }
+}
+
+void refuseSharedInputs(vector<Flight> &flights){
+    auto canonical = [](const fs::path &file){
+        error_code error;
+        fs::path path = fs::weakly_canonical(file, error); /// The same file reached by two paths is one file
+        return error ? file.lexically_normal() : path;
+    };
+    vector<fs::path> drones(flights.size()), receivers(flights.size());
+    map<fs::path, size_t> droneListings, pairings;
+    for (size_t i = 0; i < flights.size(); ++i){
+        drones[i] = canonical(flights[i].srtFile);
+        droneListings[drones[i]]++;
+        if (flights[i].ubloxFile.empty()) continue;
+        receivers[i] = canonical(flights[i].ubloxFile);
+        pairings[receivers[i]]++;
+    }
+    for (size_t i = 0; i < flights.size(); ++i){
+        if (droneListings[drones[i]] > 1)
+            flights[i].outcome = "the SRT File " + flights[i].srtFile.string() + " is listed " + to_string(droneListings[drones[i]])
+                               + " times; list each SRT File once, with its own receiver file";
+        else if (!receivers[i].empty() && pairings[receivers[i]] > 1)
+            flights[i].outcome = "the receiver file " + flights[i].ubloxFile.string() + " is paired with " + to_string(pairings[receivers[i]])
+                               + " SRT Files; give each SRT File its own receiver file, by name or in a manifest";
+    }
+}
+
+/// Output file in the same folder as an input file, e.g. "KML File for " + name + ".kml"
+static fs::path besideFile(const fs::path &inputFile, const string &prefix, const string &suffix){
+    return inputFile.parent_path() / (prefix + inputFile.filename().string() + suffix);
+}
+
+void processFlight(Flight &flight, const AlignmentOptions &options, const KmlOutputOptions &kmlOptions,
+                   const ExportOptions &exportOptions, bool useCache){
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    auto finish = [&](const string &outcome){
+        flight.outcome = outcome;
+        flight.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    if (flight.ubloxFile.empty()) return finish("no u-center CSV File or UBX log was found for this SRT File");
+
+    /// Each stage is keyed by the content of its inputs and the options that shape its output. An input whose size
+    /// and modification time match the ledger is not read to hash it, and is only opened once a stage has to run.
+    StageLedger ledger(besideFile(flight.srtFile, "", ".stages").string());
+    MappedFile srtFile, receiverFile;
+    bool srtOpened = false, receiverOpened = false, rehashed = false;
+    auto openInput = [](MappedFile &file, const fs::path &name, bool &opened){
+        if (!opened) file.open(name.string());
+        opened = true;
+        return !file.fail();
+    };
+    auto hashInput = [&](MappedFile &file, const fs::path &name, bool &opened, uint64_t &hash){
+        return ledger.inputHash(name.string(), hash, [&](uint64_t &fileHash){
+            if (!openInput(file, name, opened)) return false;
+            fileHash = hashTelemetrySource(file.begin(), file.size());
+            rehashed = true;
+            return true;
+        });
+    };
+    uint64_t srtHash, receiverHash;
+    if (!hashInput(srtFile, flight.srtFile, srtOpened, srtHash)) return finish("error opening the SRT File");
+    if (!hashInput(receiverFile, flight.ubloxFile, receiverOpened, receiverHash)) return finish("error opening the receiver file");
+    uint64_t csvKey = StageKey().add("csv").add(srtHash).value();
+    uint64_t exportKey = StageKey().add("export").add(srtHash).add(receiverHash).add(options.droneClockOffset).add(options.tolerance)
+                             .add(kmlOptions.kmz).add(kmlOptions.simplifyTolerance).add(kmlOptions.tileSeconds)
+                             .add(static_cast<uint64_t>(exportOptions.formats)).value();
+    uint64_t indexKey = StageKey().add("index").add(srtHash).add(receiverHash).add(options.droneClockOffset).value();
+    uint64_t statsKey = StageKey().add("stats").add(srtHash).add(receiverHash).add(options.droneClockOffset).add(options.tolerance).value();
+    fs::path statsFile = besideFile(flight.srtFile, "", ".stats"); /// Named after the flight, which is one SRT and receiver pair
+    fs::path accuracyFile = besideFile(flight.srtFile, "Accuracy for ", ".csv");
+    bool csvCurrent = ledger.current("csv", csvKey);
+    bool exportCurrent = ledger.current("export", exportKey);
+    bool indexCurrent = ledger.current("index", indexKey);
+    bool statsCurrent = ledger.current("stats", statsKey) && readAccuracyStatistics(flight.accuracy, statsFile.string());
+    fs::path droneIndexFile = spatialIndexName(flight.srtFile.string());
+    fs::path receiverIndexFile = spatialIndexName(flight.ubloxFile.string());
+    if (csvCurrent && exportCurrent && indexCurrent && statsCurrent){
+        flight.succeeded = flight.upToDate = true;
+        if (rehashed) ledger.save(); /// Keeps the hash of an input that was only touched
+        return finish("up to date");
+    }
+    if (!openInput(srtFile, flight.srtFile, srtOpened)) return finish("error opening the SRT File");
+    if (!openInput(receiverFile, flight.ubloxFile, receiverOpened)) return finish("error opening the receiver file");
+
+    TelemetryStore droneData, droneDataPerSecond;
+    loadTelemetryFile(droneData, flight.srtFile.string(), srtFile, TelemetrySource::Srt, useCache);
+    srtFile.close();
+    if (droneData.empty()) return finish("the SRT File has no telemetry entries");
+    decimateToSeconds(droneDataPerSecond, droneData);
+    flight.frames = droneData.size();
+    flight.seconds = droneDataPerSecond.size();
+    fs::path epicByEpicFile = besideFile(flight.srtFile, "", " Epic-by-Epic.csv");
+    if (!csvCurrent){
+        fs::path csvFile = besideFile(flight.srtFile, "", " CSV.csv");
+        if (!writeDroneCsv(droneData, csvFile.string())) return finish("error writing the CSV File");
+        if (!writeDroneCsv(droneDataPerSecond, epicByEpicFile.string())) return finish("error writing the Epic-by-Epic CSV File");
+        ledger.record("csv", csvKey, {csvFile.string(), epicByEpicFile.string()});
+        ledger.save();
+    }
+    if (!indexCurrent && !writeSpatialIndex(droneData, options.droneClockOffset, SpatialPlatform::Drone, srtHash, droneIndexFile.string()))
+        return finish("error writing the drone spatial index");
+    droneData.clear();
+    if (droneDataPerSecond.empty()) return finish("the flight is shorter than one second");
+
+    TelemetryStore receiverData;
+    TelemetrySource receiverKind = isUbxFile(flight.ubloxFile.string(), receiverFile.streamBegin(), receiverFile.waitForBytes(2))
+                                 ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv;
+    if (loadTelemetryFile(receiverData, flight.ubloxFile.string(), receiverFile, receiverKind, useCache) < 0)
+        return finish("the u-center CSV File is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns");
+    receiverFile.close();
+    if (receiverData.empty()) return finish("the receiver file has no telemetry entries");
+    flight.receiverEpochs = receiverData.size();
+    if (!indexCurrent){
+        if (!writeSpatialIndex(receiverData, 0, SpatialPlatform::Receiver, receiverHash, receiverIndexFile.string()))
+            return finish("error writing the receiver spatial index");
+        ledger.record("index", indexKey, {droneIndexFile.string(), receiverIndexFile.string()});
+        ledger.save();
+    }
+
+    applyClockOffset(droneDataPerSecond, options.droneClockOffset);
+    size_t next = 0;
+    flight.unmatchedDroneEpochs = alignLookAngles(droneDataPerSecond, [&](TelemetryRecord &entry){
+        if (next == receiverData.size()) return false;
+        entry = receiverData.record(next++);
+        return true;
+    }, true, options.tolerance);
+    next = 0;
+    flight.unmatchedReceiverEpochs = alignLookAngles(receiverData, [&](TelemetryRecord &entry){
+        if (next == droneDataPerSecond.size()) return false;
+        entry = droneDataPerSecond.record(next++);
+        return true;
+    }, false, options.tolerance);
+    if (!exportCurrent){
+        vector<string> droneFiles, receiverFiles;
+        if (!exportTrack(epicByEpicFile.string(), droneDataPerSecond, kDroneTrackFormat, kmlOptions, exportOptions, &droneFiles))
+            return finish("error writing the drone track files");
+        if (!exportTrack(flight.ubloxFile.string(), receiverData, kUbloxTrackFormat, kmlOptions, exportOptions, &receiverFiles))
+            return finish("error writing the Ublox track files");
+        droneFiles.insert(droneFiles.end(), receiverFiles.begin(), receiverFiles.end());
+        ledger.record("export", exportKey, droneFiles);
+        ledger.save();
+    }
+    if (!statsCurrent){
+        flight.accuracy = AccuracyStatistics();
+        accumulateAccuracy(receiverData, droneDataPerSecond, options.tolerance, flight.accuracy);
+        if (!writeAccuracyStatistics(flight.accuracy, statsFile.string()) || !writeAccuracySummary(flight.accuracy, accuracyFile.string()))
+            return finish("error writing the accuracy statistics");
+        ledger.record("stats", statsKey, {statsFile.string(), accuracyFile.string()});
+        ledger.save();
+    }
+    flight.succeeded = true;
+    finish("ok");
+}
+
+void printOutcomes(const vector<Flight> &flights){
+    size_t succeeded = 0;
+    double totalSeconds = 0;
+    cout << setprecision(2) << fixed;
+    for (const Flight &flight : flights){
+        totalSeconds += flight.elapsedSeconds;
+        succeeded += flight.succeeded;
+        if (flight.upToDate) cout << "CURRENT " << flight.srtFile.string() << ": every output is up to date, "
+                                  << flight.elapsedSeconds << " s" << endl;
+        else if (flight.succeeded){
+            cout << "OK      " << flight.srtFile.string() << ": " << flight.frames << " frames, " << flight.seconds
+                 << " seconds, " << flight.receiverEpochs << " receiver epochs, " << flight.unmatchedDroneEpochs
+                 << " drone and " << flight.unmatchedReceiverEpochs << " receiver epochs unmatched, "
+                 << flight.elapsedSeconds << " s" << endl;
+        }
+        else cout << "FAILED  " << flight.srtFile.string() << ": " << flight.outcome << endl;
+    }
+    cout << succeeded << " of " << flights.size() << " flights processed successfully (" << totalSeconds
+         << " s of work)." << endl;
+}
+
+void writeCampaignAccuracy(const vector<Flight> &flights, const fs::path &outputFolder){
+    AccuracyStatistics campaign;
+    set<fs::path> merged; /// Each receiver file's epochs are counted once
+    for (const Flight &flight : flights){
+        error_code error;
+        fs::path receiver = fs::weakly_canonical(flight.ubloxFile, error);
+        if (error) receiver = flight.ubloxFile.lexically_normal();
+        if (flight.succeeded && merged.insert(receiver).second) campaign.merge(flight.accuracy);
+    }
+    if (campaign.count() == 0) return;
+    fs::path accuracyFile = outputFolder / "Campaign Accuracy.csv";
+    if (!writeAccuracySummary(campaign, accuracyFile.string())){
+        cout << "Error writing the campaign accuracy statistics." << endl;
+        return;
+    }
+    cout << setprecision(3) << "Campaign CEP50 " << campaign.all.horizontal.magnitude.quantile(0.5) << " m, CEP95 "
+         << campaign.all.horizontal.magnitude.quantile(0.95) << " m, vertical RMS " << campaign.all.vertical.moments.rms()
+         << " m over " << campaign.count() << " receiver epochs (" << accuracyFile.string() << ")." << endl;
+}
+
+void writeCampaignIndex(const vector<Flight> &flights, const fs::path &outputFolder){
+    vector<SpatialCatalogEntry> entries;
+    set<fs::path> listed; /// A segment is listed once, or every query would return its epochs twice
+    uint64_t records = 0;
+    for (const Flight &flight : flights){
+        if (!flight.succeeded) continue;
+        for (const fs::path &sourceFile : {flight.srtFile, flight.ubloxFile}){
+            SpatialCatalogEntry entry;
+            fs::path indexFile = spatialIndexName(sourceFile.string());
+            error_code error;
+            fs::path segment = fs::weakly_canonical(indexFile, error);
+            if (error) segment = indexFile.lexically_normal();
+            if (!listed.insert(segment).second) continue;
+            if (!readSpatialIndexHeader(indexFile.string(), entry.header) || entry.header.recordCount == 0) continue;
+            fs::path relative = fs::relative(indexFile, outputFolder, error);
+            entry.indexFileName = error || relative.empty() ? fs::absolute(indexFile).string() : relative.string();
+            records += entry.header.recordCount;
+            entries.push_back(entry);
+        }
+    }
+    if (entries.empty()) return;
+    fs::path catalogFile = outputFolder / kSpatialCatalogName;
+    if (!writeSpatialCatalog(catalogFile.string(), entries)){
+        cout << "Error writing the campaign index catalog." << endl;
+        return;
+    }
+    cout << "Campaign index of " << records << " epochs in " << entries.size() << " segments (" << catalogFile.string() << ")." << endl;
+}
@@ -7,6 +7,36 @@
  *         Two output files are created. One file will contain each telemetry entry. The other file
  *         will contain one entry of telemetry for each second, which is known as epic by epic.
  *         Camera exposure details are not parsed but it can be added to the code in the future.
+ *         The SRT File is memory mapped and each block is scanned in place. Fields are found by their key
+ *         (FrameCnt, DiffTime, latitude, longitude, altitude) rather than by column, so a firmware update that
+ *         shifts the columns does not break the parser.
+ *         Usage: parse_srt [-j threads] [input file]. With -j the file is split into byte ranges that are parsed
+ *         on separate threads (-j 0 uses every core); a thread count that is not a number prints the usage line.
+ *         Without an input file the name is read from the prompt.
+ *         With -r linear or -r cubic the Epic-by-Epic file is interpolated with resample.h onto whole seconds, onto
+ *         a --rate in Hz, or onto the epochs of a u-center CSV File given with --grid (shifted into the drone's
+ *         clock by --utc-offset and --leap-seconds), instead of keeping the first frame of each second.
+ *         With --stream each block is written to both output files as soon as it is parsed and nothing is kept,
+ *         so memory stays constant however long the flight is (-j and -r are ignored in this mode).
+ *         --pipeline does the same on three threads: one reads the file, one parses blocks, and one formats and
+ *         writes the rows, connected by lock-free rings from pipeline.h, so disk time overlaps with parsing.
+ *         The parsed frames are cached in "<input file>.cache" (telemetry_cache.h), so a later run on the same
+ *         SRT File maps the cache instead of parsing the text again, and a file that is still growing has only
+ *         its new blocks parsed. --no-cache parses and writes no cache.
+ *         --follow tails an SRT File that is still being recorded (live_track.h): each new block is appended to both
+ *         output files as soon as it is complete and published to "KML File for <input> live.kml" for Google Earth
+ *         within about --refresh seconds, with look angles from the u-center CSV File or UBX log given with
+ *         --receiver. It stops once the file has been idle for --idle seconds or on Ctrl+C.
+ *         --export writes the Epic-by-Epic track, moved to UTC, in the chosen formats from the same parse
+ *         (track_export.h): any of csv, geojson, gpx, and kml, or all. With --receiver the look angles are computed
+ *         from the receiver file as parse_drone_csv.cc does, and the KML options of parse_drone_csv.cc apply, so one
+ *         run replaces parse_srt followed by parse_drone_csv. --export needs the whole flight, so it is refused with
+ *         --stream, --pipeline, or --follow.
+ *         --metrics <file> writes the time, record and byte counts of each stage, skipped record counts, and peak
+ *         memory of the run to a JSON file when the program exits (run_metrics.h).
+ *         The SRT File and the receiver file may be gzip or zstd compressed, as an archived flight is: they are
+ *         decoded on a separate thread while the decoded part is parsed (compressed_input.h), and are not cached.
+ *         --follow needs a plain SRT File.
  */
 
 #include <iostream>
@@ -15,30 +45,44 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include "mapped_file.h"
+#include "telemetry_store.h"
+#include "srt_parser.h"
+#include "drone_csv.h"
+#include "ublox_csv.h"
+#include "time_align.h"
+#include "resample.h"
+#include "pipeline.h"
+#include "telemetry_cache.h"
+#include "live_track.h"
+#include "ubx_parser.h"
+#include "track_lod.h"
+#include "track_export.h"
+#include "run_metrics.h"
 using namespace std;
 
-struct Telemetry{
-        string date;
-        string time;
-        int second;
-        double latitude;
-        double longitude;
-        double altitude;
-        int frameCount;
-        string diffTime;    /// Time between each frame, measured in milliseconds
-        string timecode; /// Starting duration for each frame for corresponding video
-};
-
-void fillVectorFromFile (vector<Telemetry> &data, ifstream &inputFileStream);
+void fillVectorFromFile (TelemetryStore &data, MappedFile &inputFile, string inputFileName, unsigned threadCount, bool useCache);
 /**
  *  Function:   fillVectorFromFile
- *              Fills the data vector with the date/time, latitude, longitude, and altitude at each given index
+ *              Fills the data vector with the date/time, latitude, longitude, and altitude at each given index.
+ *              With more than one thread the file is split into one byte range per thread, each range is moved
+ *              forward to the start of an SRT block, and the ranges are parsed concurrently and joined back in
+ *              frame order. The frames come from the cache when it is current, and only the blocks appended
+ *              since the cache was written are parsed when the file has grown.
  *
  *  @param data - vector passed by reference that will be written with position and time data
- *  @param inputFileStream - input file
+ *  @param inputFile - memory mapped input file
+ *  @param inputFileName - name of the input file, which the cache is named after
+ *  @param threadCount - number of worker threads
+ *  @param useCache - whether the cache is read and written
  */
 
-void fillVectorwithOneSecondDurationCounter(vector<Telemetry> &data, vector<Telemetry> &sourceData);
+void fillVectorwithOneSecondDurationCounter(TelemetryStore &data, TelemetryStore &sourceData);
 /**
  *  Function:   fillVectorwithOneSecondDurationCounter
  *              Fills the data vector with the date/time, latitude, longitude, and altitude for each second
@@ -47,7 +91,58 @@ void fillVectorwithOneSecondDurationCounter(vector<Telemetry> &data, vector<Tele
  *  @param data- vector passed by reference that will be written with position and time data for each second
  *  @param sourceData- vector that contains reference data
  */
-void fillOutputFile(vector<Telemetry> &droneData, string outsFileName);
+void fillVectorByResampling(TelemetryStore &data, TelemetryStore &sourceData, ResampleMode mode, double rate,
+                            string gridFileName, const AlignmentOptions &options);
+/**
+ *  Function:   fillVectorByResampling
+ *              Fills the data vector with positions interpolated onto a grid of epochs
+ *
+ *  @param data - vector passed by reference that will be written with the interpolated entries
+ *  @param sourceData - vector that contains every frame
+ *  @param mode - linear or cubic Hermite interpolation
+ *  @param rate - grid rate in Hz when no grid file is given
+ *  @param gridFileName - u-center CSV File whose epochs are the grid, or empty
+ *  @param options - drone clock offset used to bring the grid file's UTC epochs into the drone's clock
+ */
+void streamOutputFiles(MappedFile &inputFile, string outsFileName, string outsEpicByEpicFileName);
+/**
+ *  Function:   streamOutputFiles
+ *              Parses the SRT File block by block and writes each entry to the per frame file and, through the
+ *              one second decimator, to the Epic-by-Epic file without storing the flight. Pages of the mapping
+ *              that have been parsed are released as the scan moves on.
+ *
+ *  @param inputFile - memory mapped input file
+ *  @param outsFileName - string containing the name for the per frame output file
+ *  @param outsEpicByEpicFileName - string containing the name for the per second output file
+ */
+void pipelineOutputFiles(string inputFileName, string outsFileName, string outsEpicByEpicFileName);
+/**
+ *  Function:   pipelineOutputFiles
+ *              Writes the same two files as streamOutputFiles with a reader thread, a parser thread, and the calling
+ *              thread as the writer. The reader fills a small pool of chunk buffers with read(), each cut after the
+ *              last complete block, and the parser hands batches of entries to the writer, which formats them
+ *              into page aligned write buffers.
+ *
+ *  @param inputFileName - name of the SRT File
+ *  @param outsFileName - string containing the name for the per frame output file
+ *  @param outsEpicByEpicFileName - string containing the name for the per second output file
+ */
+void followInputFile(string inputFileName, string outsFileName, string outsEpicByEpicFileName, string receiverFileName,
+                     const AlignmentOptions &options, const LiveOptions &liveOptions);
+/**
+ *  Function:   followInputFile
+ *              Follows an SRT File as it is recorded. The blocks completed since the last read are parsed, written
+ *              to both output files, moved to UTC, matched against the receiver epochs, and published as a chunk of
+ *              the live KML track. The rows are flushed after every read, so the files can be opened mid flight.
+ *
+ *  @param inputFileName - name of the SRT File
+ *  @param outsFileName - string containing the name for the per frame output file
+ *  @param outsEpicByEpicFileName - string containing the name for the per second output file
+ *  @param receiverFileName - u-center CSV File or UBX log for the look angles, or empty
+ *  @param options - drone clock offset and matching tolerance
+ *  @param liveOptions - refresh interval and idle time
+ */
+void fillOutputFile(TelemetryStore &droneData, string outsFileName);
 /**
  *  Function:   fillOutputFile
  *              Fills the output file with one entry per frame
@@ -55,7 +150,7 @@ void fillOutputFile(vector<Telemetry> &droneData, string outsFileName);
  *  @param droneData - vector that contains reference data
  *  @param outsFileName - string containing the name for the output file
  */
-void fillOutputEpicByEpicFile(vector<Telemetry> &droneDataPerSecond, string outsFileName);
+void fillOutputEpicByEpicFile(TelemetryStore &droneDataPerSecond, string outsFileName);
 /**
  *  Function:   fillOutputEpicByEpicFile
  *              Fills the output file with one entry per second
@@ -63,130 +158,468 @@ void fillOutputEpicByEpicFile(vector<Telemetry> &droneDataPerSecond, string outs
  *  @param droneDataPerSecond - vector that contains reference data
  *  @param outsFileName - string containing the name for the output file
  */
+void exportEpicByEpic(TelemetryStore &droneDataPerSecond, string outsEpicByEpicFileName, string receiverFileName,
+                      const AlignmentOptions &options, const KmlOutputOptions &kmlOptions, const ExportOptions &exportOptions, bool useCache);
+/**
+ *  Function:   exportEpicByEpic
+ *              Moves the per second entries to UTC, computes their look angles from the receiver file when one is
+ *              given, and writes them in every chosen format named after the Epic-by-Epic file
+ *
+ *  @param droneDataPerSecond - per second entries, which are moved to UTC in place
+ *  @param outsEpicByEpicFileName - name of the Epic-by-Epic file, which the exported files are named after
+ *  @param receiverFileName - u-center CSV File or UBX log for the look angles, or empty
+ *  @param options - drone clock offset and matching tolerance
+ *  @param kmlOptions - KMZ output, simplification, and tiling of the KML File
+ *  @param exportOptions - formats to write
+ *  @param useCache - whether the receiver file is read from and written to its telemetry_cache.h cache
+ */
 
-int main(){
+int main(int argc, char *argv[]){
     cout << setprecision(6) << fixed;
     string inputFileName;
-    cout << "Enter name of input file: ";
-    cin >> inputFileName;
+    unsigned threadCount = 1;
+    bool resample = false;
+    bool stream = false;
+    bool pipeline = false;
+    bool useCache = true;
+    ResampleMode resampleMode = ResampleMode::Linear;
+    double resampleRate = 1;
+    string gridFileName;
+    string receiverFileName;
+    AlignmentOptions options;
+    LiveOptions liveOptions;
+    KmlOutputOptions kmlOptions;
+    ExportOptions exportOptions;
+    bool exportTracks = false;
+    const char *usage = "Usage: parse_srt [-j threads] [-r linear|cubic] [--rate hz] [--grid file] [--stream] [--pipeline] [--no-cache] [--follow] [--refresh seconds] [--idle seconds] [--receiver file] [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--kmz] [--simplify meters] [--tiles seconds] [--export csv,geojson,gpx,kml] [--metrics file] [input file]";
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc){
+            const char *count = argv[++i], *countEnd = count + strlen(count);
+            from_chars_result parsed = from_chars(count, countEnd, threadCount);
+            if (parsed.ec != errc() || parsed.ptr != countEnd){
+                cout << usage << endl;
+                exit(0);
+            }
+        }
+        else if (argument == "-r" && i + 1 < argc){
+            string mode = argv[++i];
+            if (mode != "linear" && mode != "cubic"){
+                cout << "Resampling mode must be linear or cubic." << endl;
+                exit(0);
+            }
+            resample = true;
+            resampleMode = mode == "cubic" ? ResampleMode::CubicHermite : ResampleMode::Linear;
+        }
+        else if (argument == "--stream") stream = true;
+        else if (argument == "--pipeline") pipeline = true;
+        else if (argument == "--no-cache") useCache = false;
+        else if (argument == "--rate" && i + 1 < argc) resampleRate = atof(argv[++i]);
+        else if (argument == "--grid" && i + 1 < argc) gridFileName = argv[++i];
+        else if (argument == "--receiver" && i + 1 < argc) receiverFileName = argv[++i];
+        else if (parseLiveOption(i, argc, argv, liveOptions)) continue;
+        else if (parseKmlOutputOption(i, argc, argv, kmlOptions)) continue;
+        else if (parseExportOption(i, argc, argv, exportOptions)) exportTracks = true;
+        else if (parseMetricsOption(i, argc, argv)) continue;
+        else if (parseAlignmentOption(i, argc, argv, options)) continue;
+        else if (inputFileName.empty() && argument[0] != '-') inputFileName = argument;
+        else {
+            cout << usage << endl;
+            exit(0);
+        }
+    }
+    if (exportTracks && (stream || pipeline || liveOptions.follow)){
+        cout << "--export needs the whole flight, so it cannot be combined with --stream, --pipeline, or --follow." << endl;
+        cout << usage << endl;
+        exit(0);
+    }
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    if (inputFileName.empty()){
+        cout << "Enter name of input file: ";
+        cin >> inputFileName;
+    }
     string outputFileName = inputFileName + " CSV.csv";
     string outsEpicByEpicFileName = inputFileName + " Epic-by-Epic.csv";
-    vector<Telemetry> droneData;
-    vector<Telemetry> droneDataPerSecond;
-    ifstream inputFileStream;
-    inputFileStream.open(inputFileName);
-    if (inputFileStream.fail()){
+    TelemetryStore droneData;
+    TelemetryStore droneDataPerSecond;
+    if (liveOptions.follow){
+        followInputFile(inputFileName, outputFileName, outsEpicByEpicFileName, receiverFileName, options, liveOptions);
+        cout << "Both files have compiled successfully." << endl;
+        return 0;
+    }
+    if (pipeline){
+        pipelineOutputFiles(inputFileName, outputFileName, outsEpicByEpicFileName);
+        cout << "Both files have compiled successfully." << endl;
+        return 0;
+    }
+    MappedFile inputFile;
+    inputFile.open(inputFileName);
+    if (inputFile.fail()){
         cout << "Error opening the input file." << endl;
         exit(0);
     }
-    fillVectorFromFile(droneData, inputFileStream);
-    fillVectorwithOneSecondDurationCounter(droneDataPerSecond, droneData);
+    if (stream){
+        streamOutputFiles(inputFile, outputFileName, outsEpicByEpicFileName);
+        cout << "Both files have compiled successfully." << endl;
+        inputFile.close();
+        return 0;
+    }
+    fillVectorFromFile(droneData, inputFile, inputFileName, threadCount, useCache);
+    if (resample) fillVectorByResampling(droneDataPerSecond, droneData, resampleMode, resampleRate, gridFileName, options);
+    else fillVectorwithOneSecondDurationCounter(droneDataPerSecond, droneData);
     /// One second index will be used in the same way count was used for indexing the primary vector, droneData, which will be called sourceData in the  fillVectorwithOneSecondDurationCounter function
     fillOutputFile(droneData, outputFileName);
     fillOutputEpicByEpicFile(droneDataPerSecond, outsEpicByEpicFileName);
     cout << "Both files have compiled successfully." << endl;
-    inputFileStream.close();
+    if (exportTracks) exportEpicByEpic(droneDataPerSecond, outsEpicByEpicFileName, receiverFileName, options, kmlOptions, exportOptions, useCache);
+    inputFile.close();
     return 0;
 }
 
-void fillVectorFromFile (vector<Telemetry> &data, ifstream &inputFileStream){
-    string temp;
-    string tcode;
-    string timeWithHourMinuteSecond, fractionOfSecondString, timeModified; /// The format in which the date and time are presented is modified
-    double thousandthSecond;
-    string latitudeString, longitudeString, altitudeString;
-    /// These 3 strings are substrings of the string containing the line of the SRT file where the data is located
-    Telemetry entry; /// Represents a blank entry to push back the vector droneData
-    int count = 0;
-    int diffTimeIndex = 0;
-    while (getline(inputFileStream, temp)){
-        if (temp.length() == 29){
-            data.push_back(entry);
-            tcode = temp.substr(0,8) + "." + temp.substr(9,3);
-            data.at(count).timecode = tcode;
-            getline(inputFileStream, temp);
-            if (count < 10) data.at(count).frameCount = stoi(temp.substr(27, 1));
-            if (count < 100 && count > 10) data.at(count).frameCount = stoi(temp.substr(27, 2));
-            if (count < 1000 && count > 100) data.at(count).frameCount = stoi(temp.substr(27, 3));
-            if (count < 10000 && count > 1000) data.at(count).frameCount = stoi(temp.substr(27, 4));
-            if (count < 100000 && count > 10000) data.at(count).frameCount = stoi(temp.substr(27, 5));
-            if (count < 1000000) data.at(count).frameCount = stoi(temp.substr(27, 6));
-            diffTimeIndex = temp.find("DiffTime") + 11;
-            data.at(count).diffTime = temp.substr(diffTimeIndex, 2);
-            getline(inputFileStream, temp);
-            data.at(count).date = temp.substr(0, 10);
-            timeWithHourMinuteSecond = temp.substr(11, 8);
-            data.at(count).second = stoi(temp.substr(17, 2));
-            fractionOfSecondString = temp.substr(20, 3) + temp.substr(24,3);
-            thousandthSecond = stoi(fractionOfSecondString) / 1000000.0;
-            timeModified = timeWithHourMinuteSecond + to_string(thousandthSecond).substr(1,7);
-            data.at(count).time = timeModified;
-            getline(inputFileStream, temp);
-            latitudeString = temp.substr(119, 9);
-            data.at(count).latitude = stod(latitudeString);
-            longitudeString = temp.substr(144, 10);
-            data.at(count).longitude = stod(longitudeString);
-            altitudeString = temp.substr(167, 10);
-            data.at(count).altitude = stod(altitudeString);
-            count++;
+void fillVectorFromFile (TelemetryStore &data, MappedFile &inputFile, string inputFileName, unsigned threadCount, bool useCache){
+    loadTelemetryFile(data, inputFileName, inputFile, TelemetrySource::Srt, useCache, threadCount);
+}
+
+void fillVectorwithOneSecondDurationCounter(TelemetryStore &data, TelemetryStore &sourceData){
+    decimateToSeconds(data, sourceData);
+}
+
+void streamOutputFiles(MappedFile &inputFile, string outsFileName, string outsEpicByEpicFileName){
+    BufferedFileWriter outputFile, outsEpicByEpic;
+    outputFile.open(outsFileName);
+    if (outputFile.fail()){
+        cout << "Error opening output file." << endl;
+        exit(0);
+    }
+    outsEpicByEpic.open(outsEpicByEpicFileName);
+    if (outsEpicByEpic.fail()){
+        cout << "Error opening epic-by-epic output file." << endl;
+        exit(0);
+    }
+    outputFile.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    outsEpicByEpic.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    ScopedStageTimer timer("SRT stream");
+    const size_t releaseBytes = 16 << 20; /// Parsed pages are handed back to the kernel every 16 MB
+    const char *begin = inputFile.streamBegin(), *released = begin;
+    size_t parsed = 0, available = 0;
+    bool finished = false;
+    OneSecondDecimator decimator;
+    inputFile.release(begin); /// A compressed file is decoded only a little ahead of the blocks written so far
+    while (!finished){ /// A compressed file is scanned a piece at a time while the rest is decoded; a plain one at once
+        available = inputFile.waitForBytes(max(parsed + kStreamedParseBytes, available + 1), &finished);
+        size_t scanned = finished ? available : parsed + lastSrtBlockBoundary(begin + parsed, available - parsed);
+        scanSrtBlocks(begin + parsed, begin + scanned, [&](const TelemetryRecord &entry, const char *blockBegin, const char *){
+            char *row = outputFile.reserve(kDroneCsvRowMaxLength);
+            char *rowEnd = formatDroneCsvRow(entry, row);
+            outputFile.commit(rowEnd);
+            decimator.push(entry, [&](){ outsEpicByEpic.write(row, rowEnd - row); });
+            if (static_cast<size_t>(blockBegin - released) >= releaseBytes){
+                inputFile.release(blockBegin);
+                released = blockBegin;
+            }
+        });
+        parsed = scanned;
+    }
+    timer.count(decimator.index, available);
+    outputFile.close();
+    outsEpicByEpic.close();
+    if (outputFile.fail() || outsEpicByEpic.fail()){
+        cout << "Error writing the output files." << endl;
+        exit(0);
+    }
+}
+
+void fillVectorByResampling(TelemetryStore &data, TelemetryStore &sourceData, ResampleMode mode, double rate,
+                            string gridFileName, const AlignmentOptions &options){
+    if (sourceData.empty()) return;
+    vector<int64_t> grid;
+    if (gridFileName.empty()){
+        if (rate <= 0){
+            cout << "The resampling rate must be greater than zero." << endl;
+            exit(0);
+        }
+        makeEpochGrid(sourceData.time.front(), sourceData.time.back(), static_cast<int64_t>(kMicrosecondsPerSecond / rate), grid);
+    }
+    else {
+        MappedFile gridFile;
+        gridFile.open(gridFileName);
+        if (gridFile.fail()){
+            cout << "Error opening the grid file." << endl;
+            exit(0);
+        }
+        UbloxCsvReader reader(gridFile.begin(), gridFile.end());
+        if (reader.fail()){
+            cout << "The grid file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+            exit(0);
         }
+        UbloxCsvRecord record;
+        while (reader.next(record)) grid.push_back(record.utc - options.droneClockOffset); /// Grid epochs in the drone's clock
+        gridFile.close();
     }
+    resampleTelemetry(sourceData, grid.data(), grid.size(), mode, data);
 }
 
-void fillVectorwithOneSecondDurationCounter(vector<Telemetry> &data, vector <Telemetry> &sourceData){
-    Telemetry entry;
-    int oneSecondIndex = 0;
-    for (int i = 1; i < sourceData.size(); ++i){
-        int indexMinus1 = i - 1;
-        if((sourceData.at(i).second == 0) && ((sourceData.at(indexMinus1).second == 59) || i == 1)){
-            data.push_back(entry);
-            data.at(oneSecondIndex) = sourceData.at(i);
+const size_t kPipelineChunkBytes = 4 << 20;
+const size_t kPipelineChunkCount = 4;
+const size_t kPipelineBatchSize = 4096;
+const size_t kPipelineBatchCount = 4;
+
+struct PipelineChunk{
+    size_t buffer;      /// Index into the chunk pool
+    size_t length;      /// Bytes that end on a block boundary
+    bool last;
+};
+
+struct PipelineBatch{
+    size_t batch;       /// Index into the batch pool
+    size_t count;
+    bool last;
+};
+
+void pipelineOutputFiles(string inputFileName, string outsFileName, string outsEpicByEpicFileName){
+    ScopedStageTimer timer("SRT pipeline");
+    size_t bytesRead = 0; /// Written by the reader and read after it is joined
+    int readError = 0;    /// errno of a failed read, likewise
+    int inputDescriptor = ::open(inputFileName.c_str(), O_RDONLY);
+    if (inputDescriptor < 0){
+        cout << "Error opening the input file." << endl;
+        exit(0);
+    }
+    MappedFile compressedInput; /// A compressed file is decoded by the reader thread in place of read
+    compressedInput.open(inputFileName, false);
+    InputCompression compression = compressedInput.fail() ? InputCompression::None
+                                                           : detectCompression(compressedInput.streamBegin(), compressedInput.size());
+    InputDecoder decoder;
+    if (compression != InputCompression::None && !decoder.open(compression, compressedInput.streamBegin(), compressedInput.size())){
+        cout << inputFileName << " is " << compressionName(compression) << " compressed, and this program was built without "
+             << (compression == InputCompression::Gzip ? "zlib." : "zstd.") << endl;
+        exit(0);
+    }
+    BufferedFileWriter outputFile, outsEpicByEpic;
+    outputFile.open(outsFileName);
+    if (outputFile.fail()){
+        cout << "Error opening output file." << endl;
+        exit(0);
+    }
+    outsEpicByEpic.open(outsEpicByEpicFileName);
+    if (outsEpicByEpic.fail()){
+        cout << "Error opening epic-by-epic output file." << endl;
+        exit(0);
+    }
+
+    vector<vector<char>> chunks(kPipelineChunkCount, vector<char>(kPipelineChunkBytes));
+    vector<vector<TelemetryRecord>> batches(kPipelineBatchCount, vector<TelemetryRecord>(kPipelineBatchSize));
+    SpscRing<PipelineChunk, kPipelineChunkCount> filledChunks;
+    SpscRing<size_t, kPipelineChunkCount> freeChunks;
+    SpscRing<PipelineBatch, kPipelineBatchCount> filledBatches;
+    SpscRing<size_t, kPipelineBatchCount> freeBatches;
+    for (size_t i = 0; i < kPipelineChunkCount; ++i) freeChunks.push(i);
+    for (size_t i = 0; i < kPipelineBatchCount; ++i) freeBatches.push(i);
 
-            oneSecondIndex++;
+    thread reader([&](){
+        size_t current = freeChunks.pop(), carried = 0;
+        while (true){
+            vector<char> &chunk = chunks[current];
+            if (carried == chunk.size()) chunk.resize(chunk.size() * 2); /// A block longer than the chunk
+            ssize_t result = compression == InputCompression::None
+                           ? ::read(inputDescriptor, chunk.data() + carried, chunk.size() - carried)
+                           : static_cast<ssize_t>(decoder.decode(chunk.data() + carried, chunk.size() - carried));
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0){ /// The end of the file, or an error that is reported once the threads are joined
+                if (result < 0) readError = errno;
+                filledChunks.push(PipelineChunk{current, carried, true});
+                return;
+            }
+            bytesRead += static_cast<size_t>(result);
+            size_t length = carried + static_cast<size_t>(result);
+            size_t boundary = lastSrtBlockBoundary(chunk.data(), length);
+            if (boundary == 0){ /// Keep reading into the same chunk until a block is complete
+                carried = length;
+                continue;
+            }
+            size_t next = freeChunks.pop();
+            carried = length - boundary;
+            if (chunks[next].size() < carried) chunks[next].resize(carried * 2);
+            memcpy(chunks[next].data(), chunk.data() + boundary, carried); /// The partial block starts the next chunk
+            filledChunks.push(PipelineChunk{current, boundary, false});
+            current = next;
         }
-        if ((sourceData.at(i).second > sourceData.at(indexMinus1).second) || ((sourceData.at(i).second == 59) && (sourceData.at(indexMinus1).second == 58))){
-            data.push_back(entry);
-            data.at(oneSecondIndex) = sourceData.at(i);
-            oneSecondIndex++;
+    });
+
+    thread parser([&](){
+        size_t batch = freeBatches.pop(), count = 0;
+        while (true){
+            PipelineChunk chunk = filledChunks.pop();
+            const char *begin = chunks[chunk.buffer].data();
+            scanSrtBlocks(begin, begin + chunk.length, [&](const TelemetryRecord &entry, const char *, const char *){
+                batches[batch][count++] = entry;
+                if (count == kPipelineBatchSize){
+                    filledBatches.push(PipelineBatch{batch, count, false});
+                    batch = freeBatches.pop();
+                    count = 0;
+                }
+            });
+            freeChunks.push(chunk.buffer);
+            if (chunk.last){
+                filledBatches.push(PipelineBatch{batch, count, true});
+                return;
+            }
+        }
+    });
+
+    outputFile.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    outsEpicByEpic.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    OneSecondDecimator decimator;
+    while (true){
+        PipelineBatch batch = filledBatches.pop();
+        for (size_t i = 0; i < batch.count; ++i){
+            const TelemetryRecord &entry = batches[batch.batch][i];
+            char *row = outputFile.reserve(kDroneCsvRowMaxLength);
+            char *rowEnd = formatDroneCsvRow(entry, row);
+            outputFile.commit(rowEnd);
+            decimator.push(entry, [&](){ outsEpicByEpic.write(row, rowEnd - row); });
         }
+        freeBatches.push(batch.batch);
+        if (batch.last) break;
+    }
+    reader.join();
+    parser.join();
+    timer.count(decimator.index, bytesRead);
+    if (readError != 0){
+        cout << "Error reading " << inputFileName << " after " << bytesRead << " bytes: " << strerror(readError) << endl;
+        exit(0);
+    }
+    if (decoder.fail()){
+        cerr << "Warning: " << inputFileName << " is truncated or corrupt after " << bytesRead
+             << " decompressed bytes; the rest is skipped." << endl;
+        countRunMetric("corrupt compressed inputs", 1);
+    }
+    ::close(inputDescriptor);
+    outputFile.close();
+    outsEpicByEpic.close();
+    if (outputFile.fail() || outsEpicByEpic.fail()){
+        cout << "Error writing the output files." << endl;
+        exit(0);
     }
 }
 
-void fillOutputFile(vector<Telemetry> &droneData, string outsFileName){
-    ofstream outputFileStream;
-    outputFileStream.open(outsFileName);
-    if (outputFileStream.fail())
-    {
+void followInputFile(string inputFileName, string outsFileName, string outsEpicByEpicFileName, string receiverFileName,
+                     const AlignmentOptions &options, const LiveOptions &liveOptions){
+    LiveTelemetryFeed feed;
+    feed.open(inputFileName, TelemetrySource::Srt);
+    if (feed.fail()){
+        cout << "Error opening the input file." << endl;
+        exit(0);
+    }
+    MappedFile inputFile;
+    inputFile.open(inputFileName, false);
+    if (detectCompression(inputFile.streamBegin(), inputFile.size()) != InputCompression::None){
+        cout << "A compressed SRT File is not being recorded; run parse_srt on it without --follow." << endl;
+        exit(0);
+    }
+    inputFile.close();
+    TelemetryStore receiverData;
+    if (!receiverFileName.empty()){
+        MappedFile receiverFile;
+        receiverFile.open(receiverFileName);
+        if (receiverFile.fail()){
+            cout << "Error opening the receiver file." << endl;
+            exit(0);
+        }
+        TelemetrySource receiverKind = isUbxFile(receiverFileName, receiverFile.streamBegin(), receiverFile.waitForBytes(2))
+                                     ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv;
+        if (loadTelemetryFile(receiverData, receiverFileName, receiverFile, receiverKind, true) < 0){
+            cout << "The receiver file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+            exit(0);
+        }
+    }
+    BufferedFileWriter outputFile, outsEpicByEpic;
+    outputFile.open(outsFileName);
+    if (outputFile.fail()){
         cout << "Error opening output file." << endl;
         exit(0);
     }
-    outputFileStream << "TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude" << endl;
-    outputFileStream << setprecision(6) << fixed;
-    /// The for loop below fills the output CSV file.
-    for (int i = 0; i < droneData.size(); ++i)
-    {
-        outputFileStream << droneData.at(i).timecode << ", " << droneData.at(i).frameCount << ", " << droneData.at(i).diffTime << ", " << droneData.at(i).date << ", " << droneData.at(i).time << ", "
-            << droneData.at(i).latitude << ", " << droneData.at(i).longitude << ", " << droneData.at(i).altitude << endl;
+    outsEpicByEpic.open(outsEpicByEpicFileName);
+    if (outsEpicByEpic.fail()){
+        cout << "Error opening epic-by-epic output file." << endl;
+        exit(0);
     }
-    outputFileStream.close();
+    outputFile.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+    outsEpicByEpic.write(kDroneCsvHeader, sizeof(kDroneCsvHeader) - 1);
+
+    TelemetryStore droneData;
+    LiveKmlPublisher publisher("KML File for " + inputFileName + " live", kDroneTrackFormat, liveOptions.refreshSeconds);
+    cout << "Following " << inputFileName << ". Open \"" << publisher.fileName() << "\" in Google Earth; press Ctrl+C to stop." << endl;
+    OneSecondDecimator decimator;
+    long long unmatchedEpochs = 0;
+    bool followed = followTelemetry(feed, droneData, publisher, liveOptions, [&](size_t first){
+        for (size_t i = first; i < droneData.size(); ++i){
+            TelemetryRecord entry = droneData.record(i);
+            char *row = outputFile.reserve(kDroneCsvRowMaxLength);
+            char *rowEnd = formatDroneCsvRow(entry, row);
+            outputFile.commit(rowEnd);
+            decimator.push(entry, [&](){ outsEpicByEpic.write(row, rowEnd - row); });
+            droneData.time[i] += options.droneClockOffset; /// The rows keep the drone's clock; the live track is in UTC
+        }
+        outputFile.flush();
+        outsEpicByEpic.flush();
+        unmatchedEpochs += alignLiveEpochs(droneData, first, receiverData, true, options.tolerance);
+    });
+    outputFile.close();
+    outsEpicByEpic.close();
+    if (feed.truncated()) cout << "The input file was truncated while it was being followed." << endl;
+    else if (!followed) cout << "Error writing the live KML Files." << endl;
+    if (outputFile.fail() || outsEpicByEpic.fail()){
+        cout << "Error writing the output files." << endl;
+        exit(0);
+    }
+    if (!followed) exit(0);
+    if (unmatchedEpochs > 0 && !receiverData.empty()) cout << unmatchedEpochs << " drone epochs have no Ublox epoch within the tolerance." << endl;
 }
 
-void fillOutputEpicByEpicFile(vector<Telemetry> &droneDataPerSecond, string outsFileName)
+void fillOutputFile(TelemetryStore &droneData, string outsFileName){
+    if (!writeDroneCsv(droneData, outsFileName)){
+        cout << "Error writing output file." << endl;
+        exit(0);
+    }
+}
+
+void fillOutputEpicByEpicFile(TelemetryStore &droneDataPerSecond, string outsFileName)
 {
-    ofstream outsEpicByEpic;
-    outsEpicByEpic.open(outsFileName);
-    if (outsEpicByEpic.fail())
-    {
-        cout << "Error opening epic-by-epic output file." << endl;
+    if (!writeDroneCsv(droneDataPerSecond, outsFileName)){
+        cout << "Error writing epic-by-epic output file." << endl;
         exit(0);
     }
-    outsEpicByEpic << "TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude" << endl;
-    outsEpicByEpic << setprecision(6) << fixed;
-    /// The for loop below fills the output CSV file.
-    for (int i = 0; i < droneDataPerSecond.size(); ++i)
-    {
-        outsEpicByEpic << droneDataPerSecond.at(i).timecode << ", " << droneDataPerSecond.at(i).frameCount << ", " << droneDataPerSecond.at(i).diffTime << ", " << droneDataPerSecond.at(i).date << ", " << droneDataPerSecond.at(i).time << ", "
-            << droneDataPerSecond.at(i).latitude << ", " << droneDataPerSecond.at(i).longitude << ", " << droneDataPerSecond.at(i).altitude << endl;
+}
+
+void exportEpicByEpic(TelemetryStore &droneDataPerSecond, string outsEpicByEpicFileName, string receiverFileName,
+                      const AlignmentOptions &options, const KmlOutputOptions &kmlOptions, const ExportOptions &exportOptions, bool useCache){
+    applyClockOffset(droneDataPerSecond, options.droneClockOffset); /// Converts the drone's local clock to UTC
+    if (!receiverFileName.empty()){
+        MappedFile receiverFile;
+        receiverFile.open(receiverFileName);
+        if (receiverFile.fail()){
+            cout << "Error opening the receiver file." << endl;
+            exit(0);
+        }
+        TelemetryStore receiverData;
+        TelemetrySource receiverKind = isUbxFile(receiverFileName, receiverFile.streamBegin(), receiverFile.waitForBytes(2))
+                                     ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv;
+        if (loadTelemetryFile(receiverData, receiverFileName, receiverFile, receiverKind, useCache) < 0){
+            cout << "The receiver file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+            exit(0);
+        }
+        size_t next = 0;
+        long long unmatchedEpochs = alignLookAngles(droneDataPerSecond, [&](TelemetryRecord &entry){
+            if (next == receiverData.size()) return false;
+            entry = receiverData.record(next++);
+            return true;
+        }, true, options.tolerance);
+        if (unmatchedEpochs > 0) cout << unmatchedEpochs << " drone epochs have no Ublox epoch within the tolerance." << endl;
+    }
+    if (!exportTrack(outsEpicByEpicFileName, droneDataPerSecond, kDroneTrackFormat, kmlOptions, exportOptions)){
+        cout << "Error writing the exported files." << endl;
+        exit(0);
     }
-    outsEpicByEpic.close();
-}
\ No newline at end of file
+    cout << "The exported files have compiled successfully." << endl;
+}
@@ -4,6 +4,32 @@
  * @date: 08/06/2020
  * @brief: This program parses the Ublox Test Platform GPS sensor's telemetry data found in the CSV File
  * that was compiled with Ucenter into a KML File to be used with Google Earth.
+ * The slant distance, heading, and elevation angle that used to come from calculations.m are computed
+ * in-process with geodesy.h from this file and the drone's Epic-by-Epic CSV File.
+ * Columns of the u-center CSV File are mapped from its header line by ublox_csv.h, so any number of rows
+ * and any extra exported columns are accepted.
+ * Receiver epochs are paired with the drone epoch nearest in UTC by time_align.h; the drone CSV File is streamed
+ * rather than loaded. --simplify and --tiles thin and regionate long tracks (track_lod.h), and --kmz writes KMZ.
+ * The input file is parsed once and cached in "<input file>.cache" (telemetry_cache.h) unless --no-cache is given.
+ * With --follow the CSV File is followed while u-center is still recording it (live_track.h): each new row is
+ * matched against the drone CSV File, if it exists yet, and published to "KML File for <input> live.kml" within
+ * about --refresh seconds, until the file has been idle for --idle seconds or Ctrl+C is pressed. When following
+ * stops, the drone CSV File is read again, since it is usually only written after the flight, and the usual KML
+ * File, and with --stats the accuracy files, are written from it. A UBX log is recognized by its sync bytes once
+ * the first ones are recorded.
+ * The input may also be a raw UBX log from the receiver (ubx_parser.h), recognized by a .ubx name or its leading
+ * sync bytes, in which case the NAV-PVT epochs are decoded directly and u-center's CSV export is not needed.
+ * Either kind of input, and the drone CSV File, may be gzip or zstd compressed: the input is decoded on a separate
+ * thread while the decoded part is parsed (compressed_input.h) and is not cached. --follow needs a plain file.
+ * With --stats the receiver's error against the drone's position is summarized (accuracy_stats.h): mean, RMS, CEP50,
+ * CEP95, and vertical error overall and per 10 degree elevation bin are written to "Accuracy for <input>.csv", and
+ * the mergeable sketches to "<input>.stats".
+ * --export chooses the formats written from the aligned track in one pass (track_export.h): any of csv, geojson,
+ * gpx, and kml, or all. Only the KML File is written by default.
+ * --metrics <file> writes the time and counts of each stage and the peak memory of the run as JSON (run_metrics.h).
+ * Usage: parse_ublox_csv [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--kmz] [--simplify meters]
+ * [--tiles seconds] [--export formats] [--no-cache] [--metrics file] [--stats] [--follow] [--refresh seconds] [--idle seconds] [Ublox CSV File or UBX log]
+ * [drone CSV File]
  */
 
 #include <iostream>
@@ -12,202 +38,192 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include "geodesy.h"
+#include "mapped_file.h"
+#include "telemetry_store.h"
+#include "drone_csv.h"
+#include "ublox_csv.h"
+#include "ubx_parser.h"
+#include "time_align.h"
+#include "kml_writer.h"
+#include "track_lod.h"
+#include "telemetry_cache.h"
+#include "live_track.h"
+#include "accuracy_stats.h"
+#include "track_export.h"
+#include "run_metrics.h"
 using namespace std;
 
-struct Telemetry{
-    int index;
-    string time;
-    string date;
-    string dateYMD; /// Date formatted as YYYY-MM-DD
-    string latitude;
-    string longitude;
-    string altitude;
-    string when;    /// KML When contains yyyy-mm-ddThh:mm:ss.xxxZ
-    string coord;   /// KML Coord is arranged as "longitude" "latitude" "altitude"
-    double elevationAngle;
-    double declineAngle;
-    double heading; /// Heading where the Ublox GNSS is the Origin in relation to the drone
-    double slantDistance;
-    string angles; /// gx angles for gx tour in KML
-};
+void loadVector(TelemetryStore &data, MappedFile &inputFile, const string &inputFileName, bool useCache);
 
-void loadVector(vector<Telemetry> &data, ifstream &inputFileStream);
+void followInputFile(TelemetryStore &data, const string &inputFileName, const string &droneFileName,
+                     const AlignmentOptions &options, const LiveOptions &liveOptions, bool useCache);
 
-void fillKMLFile(vector<Telemetry> &data, ofstream &outs);
+void alignDroneFile(TelemetryStore &data, MappedFile &droneFile, const AlignmentOptions &options);
 
-int main(){
+void writeAccuracyFiles(const TelemetryStore &data, MappedFile &droneFile, const string &inputFileName, const AlignmentOptions &options);
+
+int main(int argc, char *argv[]){
     cout << setprecision(8) << fixed;
     string inputFileName = "Ublox GPS PVT Data.csv";
-    string outputFileName = "KML File for " + inputFileName + ".kml";
-    vector <Telemetry> ubloxData;
-    ifstream inputFileStream;
-    inputFileStream.open(inputFileName);
-    if (inputFileStream.fail()){
+    string droneFileName = "DJI_0071.SRT Epic-by-Epic.csv";
+    AlignmentOptions options;
+    KmlOutputOptions kmlOptions;
+    ExportOptions exportOptions;
+    LiveOptions liveOptions;
+    bool useCache = true;
+    bool statistics = false;
+    int fileArgument = 0;
+    for (int i = 1; i < argc; ++i){
+        if (parseAlignmentOption(i, argc, argv, options)) continue;
+        if (parseKmlOutputOption(i, argc, argv, kmlOptions)) continue;
+        if (parseExportOption(i, argc, argv, exportOptions)) continue;
+        if (parseMetricsOption(i, argc, argv)) continue;
+        if (parseLiveOption(i, argc, argv, liveOptions)) continue;
+        if (string(argv[i]) == "--no-cache"){
+            useCache = false;
+            continue;
+        }
+        if (string(argv[i]) == "--stats"){
+            statistics = true;
+            continue;
+        }
+        if (argv[i][0] == '-' || fileArgument == 2){
+            cout << "Usage: parse_ublox_csv [--utc-offset hours] [--leap-seconds seconds] [--tolerance seconds] [--kmz] [--simplify meters] [--tiles seconds] [--export csv,geojson,gpx,kml] [--no-cache] [--metrics file] [--stats] [--follow] [--refresh seconds] [--idle seconds] [ublox_csv | ubx_log] [drone_csv]" << endl;
+            exit(0);
+        }
+        if (fileArgument++ == 0) inputFileName = argv[i];
+        else droneFileName = argv[i];
+    }
+    TelemetryStore ubloxData;
+    if (liveOptions.follow){
+        followInputFile(ubloxData, inputFileName, droneFileName, options, liveOptions, useCache);
+        if (ubloxData.empty()){
+            cout << "The input file has no telemetry entries." << endl;
+            exit(0);
+        }
+        MappedFile droneFile; /// Read again, since the drone CSV File is usually only written once the flight is over
+        droneFile.open(droneFileName);
+        if (droneFile.fail()) cout << "The drone input file could not be opened, so the KML File has no look angles." << endl;
+        else {
+            alignDroneFile(ubloxData, droneFile, options);
+            if (statistics) writeAccuracyFiles(ubloxData, droneFile, inputFileName, options);
+            droneFile.close();
+        }
+        if (!exportTrack(inputFileName, ubloxData, kUbloxTrackFormat, kmlOptions, exportOptions)){
+            cout << "Error writing the output file." << endl;
+            exit(0);
+        }
+        return EXIT_SUCCESS;
+    }
+    MappedFile inputFile;
+    inputFile.open(inputFileName);
+    if (inputFile.fail()){
         cout << "Error opening the input file." << endl;
         exit(0);
     }
-    loadVector(ubloxData, inputFileStream);
-    ofstream outputKMLFile;
-    outputKMLFile.open(outputFileName);
-    if(outputKMLFile.fail()){
-        cout << "Error opening the output file." << endl;
+    loadVector(ubloxData, inputFile, inputFileName, useCache);
+    if (ubloxData.empty()){
+        cout << "The input file has no telemetry entries." << endl;
         exit(0);
     }
-    fillKMLFile(ubloxData, outputKMLFile);
-    inputFileStream.close(); outputKMLFile.close();
+    MappedFile droneFile;
+    droneFile.open(droneFileName);
+    if (droneFile.fail()){
+        cout << "Error opening the drone input file." << endl;
+        exit(0);
+    }
+    alignDroneFile(ubloxData, droneFile, options);
+    if (statistics) writeAccuracyFiles(ubloxData, droneFile, inputFileName, options);
+    droneFile.close();
+    if (!exportTrack(inputFileName, ubloxData, kUbloxTrackFormat, kmlOptions, exportOptions)){
+        cout << "Error writing the output file." << endl;
+        exit(0);
+    }
+    inputFile.close();
     return EXIT_SUCCESS;
 }
 
-void loadVector(vector<Telemetry> &data, ifstream &inputFileStream){
-    ifstream inputElevationAngle;
-    inputElevationAngle.open("MATLAB/elevationAngle.txt");
-    if(inputElevationAngle.fail()){
-        cout << "Error opening the elevation angle input file." << endl;
+void loadVector(TelemetryStore &data, MappedFile &inputFile, const string &inputFileName, bool useCache){
+    long long malformedRecords = 0;
+    TelemetrySource kind = isUbxFile(inputFileName, inputFile.streamBegin(), inputFile.waitForBytes(2)) ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv;
+    long long recordCount = loadTelemetryFile(data, inputFileName, inputFile, kind, useCache, 1, &malformedRecords);
+    if (recordCount < 0){
+        cout << "The input file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
         exit(0);
     }
-    ifstream inputHeading;
-    inputHeading.open("MATLAB/heading.txt");
-    if (inputElevationAngle.fail()) {
-        cout << "Error opening the heading input file." << endl;
+    if (malformedRecords > 0 && kind == TelemetrySource::Ubx) cout << malformedRecords << " corrupt UBX frames were skipped." << endl;
+    else if (malformedRecords > 0) cout << malformedRecords << " malformed rows were skipped." << endl;
+}
+
+void followInputFile(TelemetryStore &data, const string &inputFileName, const string &droneFileName,
+                     const AlignmentOptions &options, const LiveOptions &liveOptions, bool useCache){
+    LiveTelemetryFeed feed;
+    TelemetrySource kind = isUbxFile(inputFileName, nullptr, 0) ? TelemetrySource::Ubx : TelemetrySource::UbloxCsv; /// May still be empty
+    feed.open(inputFileName, kind); /// A log that is not named .ubx is recognized by the feed once its first bytes arrive
+    if (feed.fail()){
+        cout << "Error opening the input file." << endl;
         exit(0);
     }
-    ifstream inputSlantDistance;
-    inputSlantDistance.open("MATLAB/slantDistance.txt");
-    if (inputSlantDistance.fail()) {
-        cout << "Error opening the slant distance input file." << endl;
+    MappedFile inputFile;
+    inputFile.open(inputFileName, false);
+    if (detectCompression(inputFile.streamBegin(), inputFile.size()) != InputCompression::None){
+        cout << "A compressed receiver file is not being recorded; run parse_ublox_csv on it without --follow." << endl;
         exit(0);
     }
-    string temp;
-    Telemetry entry; /// Represents a blank entry to push back the vector "data"
-    int dataSize = 0;
-    while (getline(inputFileStream, temp)){
-        if (temp.length() < 58){ /// If the length of the temp string is less than 58, the title entries are shown.
-                                 /// This assumes that the order is "Index,UTC,Lat,Lon,Alt (MSL)"
-            getline(inputFileStream, temp);
-        }
-        if (temp.length() == 60){ /// This accounts for when the index variable is between 0 and 99
-            data.push_back(entry);
-            data.at(dataSize).index = stoi(temp.substr(0,2));
-            data.at(dataSize).time = temp.substr(3, 12);
-            data.at(dataSize).date = temp.substr(16, 10);
-            data.at(dataSize).latitude = (temp.substr(27, 11));
-            data.at(dataSize).longitude = (temp.substr(39, 12));
-            data.at(dataSize).altitude = (temp.substr(52, 7));
-        }
-        if (temp.length() == 61){ /// This accounts for when the index variable is between 100 and 999
-            data.push_back(entry);
-            data.at(dataSize).index = stoi(temp.substr(0, 3));
-            data.at(dataSize).time = temp.substr(4, 12);
-            data.at(dataSize).date = temp.substr(17, 10);
-            data.at(dataSize).latitude = (temp.substr(28, 11));
-            data.at(dataSize).longitude = (temp.substr(40, 12));
-            data.at(dataSize).altitude = (temp.substr(53, 7));
-        }
-        if (temp.length() == 62){ /// This accounts for when the index variable is between 1000 and 9999
-            data.push_back(entry);
-            data.at(dataSize).index = stoi(temp.substr(0, 4));
-            data.at(dataSize).time = temp.substr(5, 12);
-            data.at(dataSize).date = temp.substr(18, 10);
-            data.at(dataSize).latitude = (temp.substr(29, 11));
-            data.at(dataSize).longitude = (temp.substr(41, 12));
-            data.at(dataSize).altitude = (temp.substr(54, 7));
-        }
-        dataSize++;
-    }
-    for (int i = 0; i < data.size(); ++i){ /// Creates when and coord entries for use with the KML File
-        data.at(i).dateYMD = data.at(i).date.substr(6, 4) + "-" + data.at(i).date.substr(0, 2) + "-" + data.at(i).date.substr(3, 2);
-        data.at(i).when = "<when>" + data.at(i).dateYMD + "T" + data.at(i).time + "Z</when>";
-        data.at(i).coord = "<gx:coord>" + (data.at(i).longitude) + " " + (data.at(i).latitude) + " " + (data.at(i).altitude) + "</gx:coord>";
+    inputFile.close();
+    TelemetryStore droneData; /// Loaded once for the live track; main aligns the whole drone CSV File at the end
+    MappedFile droneFile;
+    droneFile.open(droneFileName);
+    if (droneFile.fail()) cout << "The drone input file could not be opened, so the live track has no look angles." << endl;
+    else {
+        loadTelemetryFile(droneData, droneFileName, droneFile, TelemetrySource::DroneCsv, useCache);
+        applyClockOffset(droneData, options.droneClockOffset);
+        droneFile.close();
     }
-    for (int i = 0; i < data.size() && getline(inputElevationAngle, temp); ++i){
-        data.at(i).elevationAngle = stod(temp);
-        data.at(i).declineAngle = 90 - data[i].elevationAngle;
-    }
-    for (int i = 0; i < data.size() && getline(inputHeading, temp); ++i) {
-        data.at(i).heading = stod(temp);
-    }
-    for (int i = 0; i < data.size() && getline(inputSlantDistance, temp); ++i){
-        data.at(i).slantDistance = stod(temp);
-    }
-inputElevationAngle.close();
-    inputHeading.close();
-    inputSlantDistance.close();
+    LiveKmlPublisher publisher("KML File for " + inputFileName + " live", kUbloxTrackFormat, liveOptions.refreshSeconds);
+    cout << "Following " << inputFileName << ". Open \"" << publisher.fileName() << "\" in Google Earth; press Ctrl+C to stop." << endl;
+    bool followed = followTelemetry(feed, data, publisher, liveOptions, [&](size_t first){
+        alignLiveEpochs(data, first, droneData, false, options.tolerance);
+    });
+    if (feed.truncated()) cout << "The input file was truncated while it was being followed." << endl;
+    else if (feed.missingColumns()) cout << "The input file is missing one of the Index, UTC, Lat, Lon, or Alt (MSL) columns." << endl;
+    else if (!followed) cout << "Error writing the live KML Files." << endl;
+    if (!followed) exit(0);
+    if (feed.malformedRecords() > 0 && feed.source() == TelemetrySource::Ubx) cout << feed.malformedRecords() << " corrupt UBX frames were skipped." << endl;
+    else if (feed.malformedRecords() > 0) cout << feed.malformedRecords() << " malformed rows were skipped." << endl;
 }
 
-void fillKMLFile(vector<Telemetry> &data, ofstream &outs){
-    outs << "<?xml version=" << '"' << "1.0" << '"' << " encoding=" << '"' << "UTF-8" << '"' << "?>" << endl
-         << "<kml xmlns= " << '"' << "http:/" << "/www.opengis.net/kml/2.2" << '"' << " xmlns:gx=" << '"' << "http:/" << "/www.google.com/kml/ext/2.2" << '"' << '>' << endl;
-    outs << "    <LookAt>" << endl << "        <gx:TimeSpan>" << endl << "            <begin>" << data.at(0).dateYMD + "T" + data.at(0).time + "Z" << "</begin>" << endl
-         << "            <end>" << data.at(data.size()-1).dateYMD + "T" + data.at(data.size()-1).time + "Z" << "</end>" << endl << "        </gx:TimeSpan>" << endl
-         << "            <longitude>" << data.at(0).longitude << "</longitude>" << endl
-         << "            <latitude>" << data.at(0).latitude << "</latitude>" << endl
-         << "            <tilt>" << data.at(0).elevationAngle << "</tilt>" << endl /// This is the tilt angle - https://developers.google.com/kml/documentation/cameras
-         << "            <heading>" << data.at(0).heading << "</heading>" << endl
-         << "            <range>" << data.at(0).slantDistance << "</range>" << endl
-        //<< "           <range>" << 2000 /****Replace this number */<< "</range>" << endl
-         << "    </LookAt>" << endl;
-        /// Information above includes the beginning of the XML KML file, the document infomation, and the LookAt Information
-    outs << "    <Style id=" << '"' << "track_n" << '"' << '>' << endl
-         << "        <IconStyle>" << endl
-         << "            <scale>.5</scale>" << endl
-         << "            <Icon><href>http:/" << "/earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon>" << endl
-         << "        </IconStyle>" << endl
-         << "      <LabelStyle><scale>0</scale></LabelStyle>" << endl
-        << "    </Style>" << endl; /// This style information includes details about the track icon
-
-    outs << "    <Style id=" << '"' << "track_h" << '"' << '>' << endl /// Highlighted Track Style
-        << "        <IconStyle>" << endl
-        << "            <scale>1.2</scale>" << endl
-        << "            <Icon><href>http:/" << "/earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon>" << endl
-        << "        </IconStyle>" << endl
-        << "    </Style>" << endl; /// This style information includes details about the track icon
-
-    outs << "    <StyleMap id = " << '"' << "track" << '"' << '>' <<  endl    /// This style info is a StyleMap to activate the style for track_n and track_h
-         << "        <Pair>" << endl
-         << "            <key>normal</key>" << " <styleUrl>#track_n</styleUrl>" << endl
-         << "        </Pair>" << endl
-         << "        <Pair>" << endl
-         << "            <key>highlight</key>" << " <styleUrl>#track_h</styleUrl>" << endl
-         << "        </Pair>" << endl
-         << "    </StyleMap>" << endl;
-
-    outs << "    <!-- Normal Multitrack Style -->" << endl
-         << "    <Style id=" << '"' << "multiTrack_n" << '"' << '>' << endl
-         << "        <IconStyle><scale>1.2</scale><Icon><href>http:/" << "/earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon></IconStyle>" << endl
-         << "        <LineStyle><color>ff00ff00</color><width>6</width></LineStyle>" << endl
-        << "    </Style>" << endl;
-
-    outs << "    <!-- Highlighted Multitrack Style -->" << endl
-        << "    <Style id=" << '"' << "multiTrack_n" << '"' << '>' << endl
-        << "        <IconStyle><scale>1.2</scale><Icon><href>http:/" << "/earth.google.com/images/kml-icons/track-directional/track-none.png</href></Icon></IconStyle>" << endl
-        << "        <LineStyle><color>99ffac59</color><width>8</width></LineStyle>" << endl
-        << "    </Style>" << endl;
+void alignDroneFile(TelemetryStore &data, MappedFile &droneFile, const AlignmentOptions &options){
+    DroneCsvReader reader(droneFile.begin(), droneFile.end());
+    long long unmatchedEpochs = alignLookAngles(data, [&](TelemetryRecord &entry){
+        if (!reader.next(entry)) return false;
+        entry.time += options.droneClockOffset;
+        return true;
+    }, false, options.tolerance);
+    if (reader.malformedRecords() > 0) cout << reader.malformedRecords() << " malformed drone rows were skipped." << endl;
+    if (unmatchedEpochs > 0) cout << unmatchedEpochs << " receiver epochs have no drone epoch within the tolerance." << endl;
+}
 
-    outs << "    <StyleMap id = " << '"' << "multitrack" << '"' << '>' <<  endl    /// This style info is a StyleMap to activate the style for track_n and track_h
-        << "        <Pair>" << endl
-        << "            <key>normal</key>" << " <styleUrl>#multitrack_n</styleUrl>" << endl
-        << "        </Pair>" << endl
-        << "        <Pair>" << endl
-        << "            <key>highlight</key>" << " <styleUrl>#multitrack_h</styleUrl>" << endl
-        << "        </Pair>" << endl
-        << "    </StyleMap>" << endl;
-    outs << "    <Placemark>" << endl
-         << "        <name>Test Platform</name>" << endl
-         << "        <Snippet></Snippet>" << endl
-         << "        <styleUrl>#multiTrack</styleUrl>" << endl
-        << "        <gx:balloonVisibility>0</gx:balloonVisibility>" << endl
-        << "        <gx:Track>" << endl;
-    for (int i = 0; i < data.size(); ++i){
-        outs << "            " << data.at(i).when << endl;
-    }
-    for (int i = 0; i < data.size(); ++i) {
-        outs << "            " << data.at(i).coord << endl;
-    }
-    for (int i = 0; i < data.size(); ++i) {
-        data.at(i).angles = "<gx:angles>" + to_string(data.at(i).heading) + " " + to_string(data.at(i).elevationAngle) + " 0.0</gx:angles>";
-        outs << "            " << data.at(i).angles << endl;
+void writeAccuracyFiles(const TelemetryStore &data, MappedFile &droneFile, const string &inputFileName, const AlignmentOptions &options){
+    AccuracyStatistics statistics;
+    DroneCsvReader reader(droneFile.begin(), droneFile.end());
+    size_t next = 0;
+    accumulateAccuracy([&](TelemetryRecord &entry){
+        if (next == data.size()) return false;
+        entry = data.record(next++);
+        return true;
+    }, [&](TelemetryRecord &entry){
+        if (!reader.next(entry)) return false;
+        entry.time += options.droneClockOffset;
+        return true;
+    }, options.tolerance, statistics);
+    if (!writeAccuracyStatistics(statistics, inputFileName + ".stats") || !writeAccuracySummary(statistics, "Accuracy for " + inputFileName + ".csv")){
+        cout << "Error writing the accuracy statistics." << endl;
+        exit(0);
     }
-    outs << "        </gx:Track>" << endl
-         << "        </Placemark>" << endl;
-    outs << "</kml>";
-}
\ No newline at end of file
+    if (statistics.count() == 0) cout << "No receiver epoch has a drone epoch within the tolerance, so the accuracy statistics are empty." << endl;
+    else cout << setprecision(3) << "CEP50 " << statistics.all.horizontal.magnitude.quantile(0.5) << " m, CEP95 "
+              << statistics.all.horizontal.magnitude.quantile(0.95) << " m, vertical RMS " << statistics.all.vertical.moments.rms()
+              << " m over " << statistics.count() << " epochs." << endl;
+}
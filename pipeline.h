@@ -0,0 +1,158 @@
+/**
+ * @file: pipeline.h
+ * @date: 10/16/2026
+ * @brief: Building blocks for running reading, parsing, and writing on separate threads. SpscRing is a bounded
+ *         lock-free queue between exactly one producer thread and one consumer thread, and BufferedFileWriter
+ *         collects output in a large page aligned buffer that is handed to write() only when it fills, instead
+ *         of flushing an ofstream after every line with endl.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+const std::size_t kCacheLineSize = 64;
+const std::size_t kWriteBufferAlignment = 4096;
+
+template <class T, std::size_t Capacity>
+class SpscRing{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    SpscRing() : head(0), tail(0) {}
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    bool tryPush(const T &value){
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[position & (Capacity - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value){
+        std::size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) return false;
+        value = slots[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(const T &value){ /// Waits while the ring is full
+        while (!tryPush(value)) std::this_thread::yield();
+    }
+
+    T pop(){ /// Waits while the ring is empty
+        T value;
+        while (!tryPop(value)) std::this_thread::yield();
+        return value;
+    }
+
+private:
+    alignas(kCacheLineSize) std::atomic<std::size_t> head;  /// Next slot to read, written by the consumer only
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail;  /// Next slot to write, written by the producer only
+    alignas(kCacheLineSize) T slots[Capacity];
+};
+/**
+ *  Class:      SpscRing
+ *              Single producer, single consumer ring buffer. The two counters only ever grow and live on separate
+ *              cache lines, so the threads never contend for a lock or for the same line.
+ */
+
+class BufferedFileWriter{
+public:
+    explicit BufferedFileWriter(std::size_t capacity = 1 << 20)
+        : fileDescriptor(-1), capacity((capacity + kWriteBufferAlignment - 1) / kWriteBufferAlignment * kWriteBufferAlignment),
+          used(0), flushedBytes(0), failed(false) {
+        buffer = static_cast<char *>(std::aligned_alloc(kWriteBufferAlignment, this->capacity));
+    }
+    ~BufferedFileWriter(){
+        close();
+        std::free(buffer);
+    }
+    BufferedFileWriter(const BufferedFileWriter &) = delete;
+    BufferedFileWriter &operator=(const BufferedFileWriter &) = delete;
+
+    void open(const std::string &fileName){
+        close();
+        fileDescriptor = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed = fileDescriptor < 0 || buffer == nullptr;
+    }
+
+    void openAt(const std::string &fileName, off_t offset){ /// Overwrites an existing file from offset on
+        close();
+        fileDescriptor = ::open(fileName.c_str(), O_WRONLY);
+        failed = fileDescriptor < 0 || buffer == nullptr || lseek(fileDescriptor, offset, SEEK_SET) != offset;
+    }
+
+    bool fail() const { return failed; }
+
+    std::uint64_t bytesWritten() const { return flushedBytes + used; } /// Bytes given to the writer since it was made
+
+    char *reserve(std::size_t length){ /// Room for at least length bytes, which must not exceed the capacity
+        if (capacity - used < length) flush();
+        return buffer + used;
+    }
+
+    void commit(char *writtenEnd){ /// Marks the bytes written after reserve as used
+        used = writtenEnd - buffer;
+    }
+
+    void write(const char *data, std::size_t length){
+        while (length > 0){
+            if (used == capacity) flush();
+            std::size_t count = capacity - used < length ? capacity - used : length;
+            std::memcpy(buffer + used, data, count);
+            used += count;
+            data += count;
+            length -= count;
+        }
+    }
+
+    void write(const std::string &text){ write(text.data(), text.size()); }
+
+    void flush(){
+        std::size_t written = 0;
+        while (written < used && fileDescriptor >= 0){
+            ssize_t result = ::write(fileDescriptor, buffer + written, used - written);
+            if (result <= 0){
+                failed = true;
+                break;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+        flushedBytes += written;
+        used = 0;
+    }
+
+    void close(){
+        if (fileDescriptor < 0) return;
+        flush();
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+
+private:
+    int fileDescriptor;
+    char *buffer;
+    std::size_t capacity;
+    std::size_t used;
+    std::uint64_t flushedBytes;
+    bool failed;
+};
+/**
+ *  Class:      BufferedFileWriter
+ *              Output file with a page aligned buffer (1 MB by default). Callers either copy bytes in with write or
+ *              format straight into the buffer between reserve and commit.
+ */
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file: resample.h
+ * @date: 10/16/2026
+ * @brief: Interpolates full rate drone telemetry onto any grid of epochs (whole seconds, 10 Hz, or the Ublox
+ *         receiver's own epochs) instead of keeping the first frame after each second ticks over, which left up
+ *         to a frame of timing error. Linear and cubic Hermite interpolation are offered. Target epochs are
+ *         located in one forward pass over the source, then each column is interpolated over a batch of
+ *         epochs at a time with plain array loops the compiler can vectorize.
+ */
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "telemetry_store.h"
+
+enum class ResampleMode{
+    Linear,
+    CubicHermite    /// Piecewise cubic through the samples with finite difference tangents (Catmull-Rom for even spacing)
+};
+
+const std::size_t kResampleBatchSize = 256;
+
+inline void makeEpochGrid(std::int64_t first, std::int64_t last, std::int64_t interval, std::vector<std::int64_t> &grid){
+    grid.clear();
+    if (interval <= 0 || last < first) return;
+    std::int64_t time = -floorDivide(-first, interval) * interval; /// First multiple of the interval at or after first
+    grid.reserve(static_cast<std::size_t>((last - time) / interval + 1));
+    for (; time <= last; time += interval) grid.push_back(time);
+}
+/**
+ *  Function:   makeEpochGrid
+ *              Lists every multiple of interval between first and last, so a 1 s interval gives whole seconds
+ *
+ *  @param first - earliest epoch in microseconds
+ *  @param last - latest epoch in microseconds
+ *  @param interval - spacing in microseconds
+ *  @param grid - written with the epochs
+ */
+
+/// Slope of a column at sample k per microsecond, one sided at the ends of the source
+inline double hermiteTangent(const double *column, const std::int64_t *times, std::size_t sourceCount, std::size_t k){
+    std::size_t before = k > 0 ? k - 1 : k;
+    std::size_t after = k + 1 < sourceCount ? k + 1 : k;
+    double span = static_cast<double>(times[after] - times[before]);
+    return span > 0 ? (column[after] - column[before]) / span : 0;
+}
+
+inline void interpolateColumn(const double *column, const std::int64_t *times, std::size_t sourceCount,
+                              const std::size_t *segment, const double *fraction, std::size_t count,
+                              ResampleMode mode, double *output){
+    if (mode == ResampleMode::Linear){
+        for (std::size_t i = 0; i < count; ++i){
+            double left = column[segment[i]], right = column[segment[i] + 1];
+            output[i] = left + fraction[i] * (right - left);
+        }
+        return;
+    }
+    double leftTangent[kResampleBatchSize], rightTangent[kResampleBatchSize], length[kResampleBatchSize];
+    for (std::size_t i = 0; i < count; ++i){
+        std::size_t k = segment[i];
+        length[i] = static_cast<double>(times[k + 1] - times[k]);
+        leftTangent[i] = hermiteTangent(column, times, sourceCount, k);
+        rightTangent[i] = hermiteTangent(column, times, sourceCount, k + 1);
+    }
+    for (std::size_t i = 0; i < count; ++i){
+        double t = fraction[i], t2 = t * t, t3 = t2 * t;
+        double h00 = 2 * t3 - 3 * t2 + 1, h10 = t3 - 2 * t2 + t, h01 = -2 * t3 + 3 * t2, h11 = t3 - t2;
+        output[i] = h00 * column[segment[i]] + h10 * length[i] * leftTangent[i]
+                  + h01 * column[segment[i] + 1] + h11 * length[i] * rightTangent[i];
+    }
+}
+/**
+ *  Function:   interpolateColumn
+ *              Interpolates one column of the source at a batch of located epochs
+ *
+ *  @param column - source column
+ *  @param times - source times, ascending
+ *  @param sourceCount - number of source samples
+ *  @param segment - for each epoch, the sample at or before it (always followed by another sample)
+ *  @param fraction - for each epoch, its position between segment and segment + 1 from 0 to 1
+ *  @param count - number of epochs, at most kResampleBatchSize
+ *  @param mode - interpolation to use
+ *  @param output - written with count values
+ */
+
+inline std::size_t resampleTelemetry(const TelemetryStore &source, const std::int64_t *targetTimes, std::size_t targetCount,
+                                     ResampleMode mode, TelemetryStore &output){
+    std::size_t sourceCount = source.size();
+    if (sourceCount < 2) return 0;
+    const std::int64_t *times = source.time.data();
+    std::size_t segment[kResampleBatchSize];
+    double fraction[kResampleBatchSize], latitude[kResampleBatchSize], longitude[kResampleBatchSize], altitude[kResampleBatchSize];
+    std::int64_t batchTimes[kResampleBatchSize];
+    std::size_t k = 0, written = 0, target = 0;
+    output.reserve(output.size() + targetCount);
+    while (target < targetCount){
+        std::size_t count = 0;
+        for (; target < targetCount && count < kResampleBatchSize; ++target){
+            std::int64_t time = targetTimes[target];
+            if (time < times[0] || time > times[sourceCount - 1]) continue; /// No extrapolation past the flight
+            while (k + 2 < sourceCount && times[k + 1] <= time) k++;
+            std::int64_t span = times[k + 1] - times[k];
+            segment[count] = k;
+            fraction[count] = span > 0 ? static_cast<double>(time - times[k]) / static_cast<double>(span) : 0;
+            batchTimes[count++] = time;
+        }
+        interpolateColumn(source.latitude.data(), times, sourceCount, segment, fraction, count, mode, latitude);
+        interpolateColumn(source.longitude.data(), times, sourceCount, segment, fraction, count, mode, longitude);
+        interpolateColumn(source.altitude.data(), times, sourceCount, segment, fraction, count, mode, altitude);
+        TelemetryRecord entry;
+        for (std::size_t i = 0; i < count; ++i){
+            std::size_t left = segment[i], nearest = left + (fraction[i] >= 0.5);
+            entry.time = batchTimes[i];
+            entry.timecode = source.timecode[left]
+                           + static_cast<std::int64_t>(fraction[i] * (source.timecode[left + 1] - source.timecode[left]));
+            entry.frame = source.frame[nearest];
+            entry.diffTime = source.diffTime[left];
+            entry.latitude = latitude[i];
+            entry.longitude = longitude[i];
+            entry.altitude = altitude[i];
+            entry.fixType = source.fixType[nearest];
+            entry.satellites = source.satellites[nearest];
+            entry.horizontalAccuracy = source.horizontalAccuracy[nearest];
+            entry.verticalAccuracy = source.verticalAccuracy[nearest];
+            output.append(entry);
+        }
+        written += count;
+    }
+    return written;
+}
+/**
+ *  Function:   resampleTelemetry
+ *              Appends one interpolated epoch to output for every target time that falls within the source.
+ *              The timecode is interpolated linearly; the frame and the fix quality columns are those of the
+ *              nearest source frame.
+ *
+ *  @param source - full rate telemetry with ascending times
+ *  @param targetTimes - epochs to interpolate at, ascending, in the same clock as the source
+ *  @param targetCount - number of target epochs
+ *  @param mode - linear or cubic Hermite interpolation
+ *  @param output - store that will be appended to
+ *  @return number of epochs appended
+ */
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file: run_metrics.h
+ * @date: 10/16/2026
+ * @brief: Per run performance data for the tools. Each stage of the shared headers (parsing, the cache, alignment,
+ *         decimation, and the CSV, KML, and export writers) is wrapped in a ScopedStageTimer that adds its time and
+ *         its record and byte counts to a process wide RunMetrics, and skipped or malformed records are counted
+ *         under a name. With "--metrics <file>" a tool writes everything as JSON when it exits, together with
+ *         the wall and CPU time and the peak resident set size. Without the option a timer is one test of a bool
+ *         per stage, not per record, and nothing is recorded. Stages are summed by name; in parse_campaign.cc
+ *         they run on several threads at once, so their seconds add up to more than the wall time.
+ */
+
+#ifndef RUN_METRICS_H
+#define RUN_METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+
+struct StageMetrics{
+    const char *name;
+    long long calls;
+    double seconds;
+    std::uint64_t records;
+    std::uint64_t bytes;
+};
+
+class RunMetrics{
+public:
+    RunMetrics() : active(false), start(std::chrono::steady_clock::now()) {}
+
+    bool enabled() const { return active; }
+
+    void enable(const std::string &outputFileName, int argc, char *argv[]){
+        fileName = outputFileName;
+        arguments.assign(argv, argv + argc);
+        active = true;
+    }
+
+    void addStage(const char *name, double seconds, std::uint64_t records, std::uint64_t bytes){
+        std::lock_guard<std::mutex> lock(mutex);
+        StageMetrics &stage = find(stages, name, StageMetrics{name, 0, 0, 0, 0});
+        stage.calls++;
+        stage.seconds += seconds;
+        stage.records += records;
+        stage.bytes += bytes;
+    }
+
+    void addCount(const char *name, long long count){
+        std::lock_guard<std::mutex> lock(mutex);
+        find(counts, name, std::pair<const char *, long long>(name, 0)).second += count;
+    }
+
+    bool write() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ofstream outs(fileName);
+        if (outs.fail()) return false;
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        char number[64];
+        outs << "{\n  \"tool\": " << jsonString(arguments.empty() ? "" : arguments[0]) << ",\n  \"arguments\": [";
+        for (std::size_t i = 1; i < arguments.size(); ++i) outs << (i > 1 ? ", " : "") << jsonString(arguments[i]);
+        std::snprintf(number, sizeof(number), "%.6f", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        outs << "],\n  \"wallSeconds\": " << number;
+        std::snprintf(number, sizeof(number), "%.6f", usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6);
+        outs << ",\n  \"userCpuSeconds\": " << number;
+        std::snprintf(number, sizeof(number), "%.6f", usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
+        outs << ",\n  \"systemCpuSeconds\": " << number;
+        outs << ",\n  \"peakRssBytes\": " << static_cast<long long>(usage.ru_maxrss) * 1024 << ",\n  \"stages\": ["; /// ru_maxrss is in kB on Linux
+        for (std::size_t i = 0; i < stages.size(); ++i){
+            const StageMetrics &stage = stages[i];
+            outs << (i > 0 ? "," : "") << "\n    {\"name\": " << jsonString(stage.name) << ", \"calls\": " << stage.calls;
+            std::snprintf(number, sizeof(number), "%.6f", stage.seconds);
+            outs << ", \"seconds\": " << number << ", \"records\": " << stage.records << ", \"bytes\": " << stage.bytes;
+            std::snprintf(number, sizeof(number), "%.0f", stage.seconds > 0 ? stage.records / stage.seconds : 0);
+            outs << ", \"recordsPerSecond\": " << number;
+            std::snprintf(number, sizeof(number), "%.0f", stage.seconds > 0 ? stage.bytes / stage.seconds : 0);
+            outs << ", \"bytesPerSecond\": " << number << "}";
+        }
+        outs << (stages.empty() ? "" : "\n  ") << "],\n  \"counts\": {";
+        for (std::size_t i = 0; i < counts.size(); ++i)
+            outs << (i > 0 ? "," : "") << "\n    " << jsonString(counts[i].first) << ": " << counts[i].second;
+        outs << (counts.empty() ? "" : "\n  ") << "}\n}\n";
+        outs.close();
+        return !outs.fail();
+    }
+
+private:
+    template <class Entry>
+    static Entry &find(std::vector<Entry> &entries, const char *name, const Entry &empty){
+        for (Entry &entry : entries){
+            if (std::strcmp(entryName(entry), name) == 0) return entry;
+        }
+        entries.push_back(empty);
+        return entries.back();
+    }
+
+    static const char *entryName(const StageMetrics &stage){ return stage.name; }
+    static const char *entryName(const std::pair<const char *, long long> &count){ return count.first; }
+
+    static std::string jsonString(const std::string &text){
+        std::string quoted = "\"";
+        for (char character : text){
+            if (character == '"' || character == '\\') quoted += '\\';
+            if (static_cast<unsigned char>(character) < 0x20){
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                quoted += escaped;
+            }
+            else quoted += character;
+        }
+        return quoted + "\"";
+    }
+
+    bool active;
+    std::chrono::steady_clock::time_point start;
+    std::string fileName;
+    std::vector<std::string> arguments;
+    std::vector<StageMetrics> stages;
+    std::vector<std::pair<const char *, long long>> counts;
+    mutable std::mutex mutex;
+};
+/**
+ *  Class:      RunMetrics
+ *              Stage times and counts of one run, in the order the stages first ran. Names must be string literals.
+ */
+
+inline RunMetrics &runMetrics(){
+    static RunMetrics metrics;
+    return metrics;
+}
+
+class ScopedStageTimer{
+public:
+    explicit ScopedStageTimer(const char *name) : name(name), active(runMetrics().enabled()), records(0), bytes(0) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedStageTimer(){
+        if (active) runMetrics().addStage(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), records, bytes);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+    void count(std::uint64_t recordCount, std::uint64_t byteCount = 0){
+        records += recordCount;
+        bytes += byteCount;
+    }
+
+private:
+    const char *name;
+    bool active;
+    std::uint64_t records;
+    std::uint64_t bytes;
+    std::chrono::steady_clock::time_point start;
+};
+/**
+ *  Class:      ScopedStageTimer
+ *              Times the scope it is declared in as one call of a stage. count adds the records and bytes it handled.
+ */
+
+inline void countRunMetric(const char *name, long long count){
+    if (count != 0 && runMetrics().enabled()) runMetrics().addCount(name, count);
+}
+
+inline void writeRunMetricsAtExit(){
+    if (!runMetrics().write()) std::fprintf(stderr, "Error writing the metrics file.\n");
+}
+
+inline bool parseMetricsOption(int &argumentIndex, int argc, char *argv[]){
+    if (std::strcmp(argv[argumentIndex], "--metrics") != 0 || argumentIndex + 1 >= argc) return false;
+    if (!runMetrics().enabled()) std::atexit(writeRunMetricsAtExit);
+    runMetrics().enable(argv[argumentIndex + 1], argc, argv);
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseMetricsOption
+ *              Reads "--metrics <file>" from the command line and has the metrics written to the file at exit,
+ *              including the exits the tools take on errors
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not the metrics option
+ */
+
+#endif
@@ -0,0 +1,536 @@
+/**
+ * @file: spatial_index.h
+ * @date: 10/16/2026
+ * @brief: Persistent space and time index over the flights of a campaign, so "every epoch within 50 m of this point
+ *         between 14:00 and 14:10" or "the ten epochs nearest this point" is answered by visiting a few hundred
+ *         records instead of a pass over every CSV File. Each parsed file gets a segment written next to it as
+ *         "<file>.spatial": a header with its record count, time span, and bounding box, followed by fixed-width
+ *         little-endian columns on 64 byte boundaries, like frame_index.h. The segment is a packed R-tree: the
+ *         records are sorted along a Hilbert curve over their bounding box, so records that are close on the
+ *         ground are close in the file, and every kSpatialIndexFanout consecutive records form a leaf node that
+ *         stores their bounding box and time span. Every kSpatialIndexFanout consecutive nodes form a node of the
+ *         next level up to a single root, so the tree needs no pointers and a query descends only into the nodes
+ *         whose box and time span it can touch. Unlike a fixed grid, this stays fast both where a drone hovers or
+ *         repeats an orbit and where a receiver logs once a second.
+ *         A campaign lists its segments in a text catalog with their time spans and bounding boxes, so a query
+ *         skips the segments it cannot touch without opening them. Segments are only rewritten when their file
+ *         changes, and the catalog is rebuilt from the segment headers, so adding a flight costs the parse of that
+ *         flight alone.
+ *         Distances are horizontal, on the plane tangent to the WGS-84 ellipsoid at the query point, which is
+ *         within about a decimeter per kilometer of the geodesic, plenty over the few kilometers of a campaign.
+ *         Longitudes are not wrapped at the antimeridian.
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "pipeline.h"
+#include "telemetry_store.h"
+#include "geodesy.h"
+#include "run_metrics.h"
+
+const char kSpatialIndexMagic[8] = {'O', 'U', 'S', 'P', 'T', 'I', 'D', 'X'};
+const std::uint32_t kSpatialIndexVersion = 1;
+const std::size_t kSpatialIndexColumnAlignment = 64;
+const std::size_t kSpatialIndexHeaderBytes = 128;
+const std::uint32_t kSpatialIndexFanout = 32;       /// Records per leaf and children per node
+const char kSpatialCatalogName[] = "Campaign Index.catalog";
+const char kSpatialCatalogFirstLine[] = "# OU-JUP-UAV-GNSS spatial catalog 1";
+
+enum class SpatialPlatform : std::uint32_t { Drone = 0, Receiver = 1 };
+
+inline const char *spatialPlatformName(SpatialPlatform platform){ return platform == SpatialPlatform::Drone ? "drone" : "receiver"; }
+
+struct SpatialIndexHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t platform;             /// SpatialPlatform of the records
+    std::uint64_t recordCount;
+    std::uint64_t nodeCount;            /// Nodes of every level, leaves first and the root last
+    std::uint64_t sourceHash;           /// hashTelemetrySource of the file the records were parsed from
+    std::uint32_t fanout;
+    std::uint32_t reserved;
+    std::int64_t minTime;               /// UTC microseconds since 1970-01-01
+    std::int64_t maxTime;
+    double minLatitude;
+    double maxLatitude;
+    double minLongitude;
+    double maxLongitude;
+};
+
+static_assert(sizeof(SpatialIndexHeader) == 96, "Index layout must not be padded");
+
+/// Stored columns in file order: the records in tree order, then the nodes; changing this list needs a new kSpatialIndexVersion
+enum SpatialIndexColumn{
+    kSpatialIndexTime, kSpatialIndexLatitude, kSpatialIndexLongitude, kSpatialIndexAltitude, kSpatialIndexFrame,
+    kSpatialIndexNodeMinLatitude, kSpatialIndexNodeMaxLatitude, kSpatialIndexNodeMinLongitude, kSpatialIndexNodeMaxLongitude,
+    kSpatialIndexNodeMinTime, kSpatialIndexNodeMaxTime, kSpatialIndexColumnCount
+};
+
+inline std::string spatialIndexName(const std::string &sourceFileName){ return sourceFileName + ".spatial"; }
+
+inline std::uint64_t spatialIndexColumnOffset(std::uint64_t recordCount, std::uint64_t nodeCount, int column){
+    auto columnBytes = [](std::uint64_t count){
+        return (count * 8 + kSpatialIndexColumnAlignment - 1) / kSpatialIndexColumnAlignment * kSpatialIndexColumnAlignment;
+    };
+    if (column <= kSpatialIndexNodeMinLatitude) return kSpatialIndexHeaderBytes + column * columnBytes(recordCount); /// The header fits in the first 128 bytes
+    return kSpatialIndexHeaderBytes + kSpatialIndexNodeMinLatitude * columnBytes(recordCount)
+         + (column - kSpatialIndexNodeMinLatitude) * columnBytes(nodeCount);
+}
+
+inline std::uint64_t spatialIndexLevels(std::uint64_t recordCount, std::uint32_t fanout, std::vector<std::uint64_t> &levelStart){
+    levelStart.clear();
+    std::uint64_t nodes = 0, size = recordCount;
+    while (size > 0){
+        size = (size + fanout - 1) / fanout;
+        levelStart.push_back(nodes);
+        nodes += size;
+        if (size == 1) break;
+    }
+    levelStart.push_back(nodes);
+    return nodes;
+}
+/**
+ *  Function:   spatialIndexLevels
+ *              Lays out the levels of a packed tree: node i of a level covers children [i * fanout, (i + 1) * fanout)
+ *              of the level below, and the leaves cover records the same way
+ *
+ *  @param recordCount - records of the segment
+ *  @param fanout - records per leaf and children per node
+ *  @param levelStart - written with the first node of each level, leaves first, and one past the last node
+ *  @return number of nodes
+ */
+
+inline std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y){
+    const std::uint32_t side = 1u << 16;
+    std::uint64_t index = 0;
+    for (std::uint32_t s = side / 2; s > 0; s /= 2){
+        std::uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+        index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0){ /// Rotate the quadrant so the curve stays continuous
+            if (rx == 1){
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+/**
+ *  Function:   hilbertIndex
+ *              Distance along a Hilbert curve filling a 65536 by 65536 grid to the cell (x, y)
+ */
+
+inline void metersPerDegree(double latitude, double &north, double &east){
+    double phi = latitude * kDegreesToRadians;
+    double sinPhi = std::sin(phi);
+    double w = 1.0 - kWgs84EccentricitySquared * sinPhi * sinPhi;
+    double primeVertical = kWgs84SemiMajorAxis / std::sqrt(w);
+    north = primeVertical * (1.0 - kWgs84EccentricitySquared) / w * kDegreesToRadians;
+    east = primeVertical * std::cos(phi) * kDegreesToRadians;
+}
+/**
+ *  Function:   metersPerDegree
+ *              Length of a degree of latitude (meridian radius) and of longitude (prime vertical radius times the
+ *              cosine of the latitude) on the WGS-84 ellipsoid
+ */
+
+inline double boxDistance(double minLatitude, double maxLatitude, double minLongitude, double maxLongitude,
+                          double latitude, double longitude, double north, double east){
+    double northing = (std::clamp(latitude, minLatitude, maxLatitude) - latitude) * north;
+    double easting = (std::clamp(longitude, minLongitude, maxLongitude) - longitude) * east;
+    return std::sqrt(northing * northing + easting * easting);
+}
+/**
+ *  Function:   boxDistance
+ *              Distance in meters from a point to a latitude and longitude box, 0 inside it. Nothing in the box is
+ *              nearer than this.
+ *
+ *  @param north, east - metersPerDegree at the point
+ */
+
+inline double spatialBoundsDistance(const SpatialIndexHeader &header, double latitude, double longitude){
+    double north, east;
+    metersPerDegree(latitude, north, east);
+    return boxDistance(header.minLatitude, header.maxLatitude, header.minLongitude, header.maxLongitude, latitude, longitude, north, east);
+}
+/**
+ *  Function:   spatialBoundsDistance
+ *              Distance in meters from a point to the bounding box of a segment, so whole segments are skipped
+ */
+
+struct SpatialQuery{
+    double latitude = 0;
+    double longitude = 0;
+    double radius = std::numeric_limits<double>::infinity();   /// Meters; nearest ignores records further away
+    std::int64_t begin = std::numeric_limits<std::int64_t>::min();  /// UTC window in microseconds, inclusive
+    std::int64_t end = std::numeric_limits<std::int64_t>::max();
+    double minAltitude = -std::numeric_limits<double>::infinity();
+    double maxAltitude = std::numeric_limits<double>::infinity();
+};
+
+struct SpatialMatch{
+    double distance;            /// Horizontal meters from the query point
+    std::uint32_t segment;      /// Number the caller gave the segment the row is in
+    std::size_t row;
+};
+
+class SpatialIndex{
+public:
+    SpatialIndex() : count(0) {}
+    SpatialIndex(const SpatialIndex &) = delete;
+    SpatialIndex &operator=(const SpatialIndex &) = delete;
+
+    bool open(const std::string &indexFileName){
+        file.open(indexFileName);
+        count = 0;
+        if (file.fail() || file.size() < kSpatialIndexHeaderBytes) return false;
+        std::memcpy(&header, file.begin(), sizeof(header));
+        if (std::memcmp(header.magic, kSpatialIndexMagic, sizeof(header.magic)) != 0 || header.version != kSpatialIndexVersion
+            || header.fanout < 2 || header.recordCount > file.size() / 8
+            || spatialIndexLevels(header.recordCount, header.fanout, levelStart) != header.nodeCount
+            || file.size() < spatialIndexColumnOffset(header.recordCount, header.nodeCount, kSpatialIndexColumnCount)) return false;
+        count = static_cast<std::size_t>(header.recordCount);
+        return true;
+    }
+
+    const SpatialIndexHeader &info() const { return header; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const std::int64_t *time() const { return integerColumn(kSpatialIndexTime); }
+    const double *latitude() const { return doubleColumn(kSpatialIndexLatitude); }
+    const double *longitude() const { return doubleColumn(kSpatialIndexLongitude); }
+    const double *altitude() const { return doubleColumn(kSpatialIndexAltitude); }
+    const std::int64_t *frame() const { return integerColumn(kSpatialIndexFrame); }
+
+    void within(const SpatialQuery &query, std::uint32_t segment, std::vector<SpatialMatch> &matches) const {
+        if (count == 0 || !(query.radius >= 0) || std::isinf(query.radius)) return;
+        double north, east;
+        metersPerDegree(query.latitude, north, east);
+        std::vector<std::pair<std::size_t, std::size_t>> pending(1, std::make_pair(levelStart.size() - 2, std::size_t(0)));
+        while (!pending.empty()){
+            std::size_t level = pending.back().first, node = pending.back().second;
+            pending.pop_back();
+            if (!reaches(level, node, query, north, east, query.radius)) continue;
+            std::size_t first = node * header.fanout, last = std::min(first + header.fanout, childCount(level));
+            for (std::size_t child = first; child < last; ++child){
+                if (level > 0){
+                    pending.push_back(std::make_pair(level - 1, child));
+                    continue;
+                }
+                double distance = distanceTo(child, query, north, east);
+                if (distance <= query.radius && inWindow(child, query)) matches.push_back(SpatialMatch{distance, segment, child});
+            }
+        }
+    }
+
+    void nearest(const SpatialQuery &query, std::size_t wanted, std::uint32_t segment, std::vector<SpatialMatch> &best) const {
+        if (count == 0 || wanted == 0) return;
+        double north, east;
+        metersPerDegree(query.latitude, north, east);
+        auto limit = [&](){ return best.size() == wanted ? std::min(best.back().distance, query.radius) : query.radius; };
+        struct Pending{
+            double distance;
+            std::size_t level;
+            std::size_t node;
+            bool operator<(const Pending &other) const { return distance > other.distance; } /// Nearest on top
+        };
+        std::priority_queue<Pending> pending;
+        std::size_t root = levelStart.size() - 2;
+        if (reaches(root, 0, query, north, east, limit())) pending.push(Pending{nodeDistance(root, 0, query, north, east), root, 0});
+        while (!pending.empty()){
+            Pending next = pending.top();
+            pending.pop();
+            if (next.distance > limit() || (best.size() == wanted && next.distance >= best.back().distance)) break;
+            std::size_t first = next.node * header.fanout, last = std::min(first + header.fanout, childCount(next.level));
+            for (std::size_t child = first; child < last; ++child){
+                if (next.level > 0){
+                    if (reaches(next.level - 1, child, query, north, east, limit()))
+                        pending.push(Pending{nodeDistance(next.level - 1, child, query, north, east), next.level - 1, child});
+                    continue;
+                }
+                double distance = distanceTo(child, query, north, east);
+                if (distance > limit() || (best.size() == wanted && distance >= best.back().distance) || !inWindow(child, query)) continue;
+                SpatialMatch match{distance, segment, child};
+                best.insert(std::upper_bound(best.begin(), best.end(), match, [](const SpatialMatch &a, const SpatialMatch &b){
+                    return a.distance < b.distance;
+                }), match);
+                if (best.size() > wanted) best.pop_back();
+            }
+        }
+    }
+
+private:
+    const std::int64_t *integerColumn(int column) const {
+        return reinterpret_cast<const std::int64_t *>(file.begin() + spatialIndexColumnOffset(header.recordCount, header.nodeCount, column));
+    }
+    const double *doubleColumn(int column) const {
+        return reinterpret_cast<const double *>(file.begin() + spatialIndexColumnOffset(header.recordCount, header.nodeCount, column));
+    }
+
+    /// Records below the leaves, nodes of the level below otherwise
+    std::size_t childCount(std::size_t level) const {
+        return level == 0 ? count : static_cast<std::size_t>(levelStart[level] - levelStart[level - 1]);
+    }
+
+    double nodeDistance(std::size_t level, std::size_t node, const SpatialQuery &query, double north, double east) const {
+        std::size_t i = static_cast<std::size_t>(levelStart[level]) + node;
+        return boxDistance(doubleColumn(kSpatialIndexNodeMinLatitude)[i], doubleColumn(kSpatialIndexNodeMaxLatitude)[i],
+                           doubleColumn(kSpatialIndexNodeMinLongitude)[i], doubleColumn(kSpatialIndexNodeMaxLongitude)[i],
+                           query.latitude, query.longitude, north, east);
+    }
+
+    /// True if the node's time span meets the query's window and its box is within radius of the query point
+    bool reaches(std::size_t level, std::size_t node, const SpatialQuery &query, double north, double east, double radius) const {
+        std::size_t i = static_cast<std::size_t>(levelStart[level]) + node;
+        return integerColumn(kSpatialIndexNodeMinTime)[i] <= query.end && integerColumn(kSpatialIndexNodeMaxTime)[i] >= query.begin
+            && nodeDistance(level, node, query, north, east) <= radius;
+    }
+
+    bool inWindow(std::size_t row, const SpatialQuery &query) const {
+        return time()[row] >= query.begin && time()[row] <= query.end && altitude()[row] >= query.minAltitude && altitude()[row] <= query.maxAltitude;
+    }
+
+    double distanceTo(std::size_t row, const SpatialQuery &query, double north, double east) const {
+        double northing = (latitude()[row] - query.latitude) * north, easting = (longitude()[row] - query.longitude) * east;
+        return std::sqrt(northing * northing + easting * easting);
+    }
+
+    MappedFile file;
+    SpatialIndexHeader header;
+    std::vector<std::uint64_t> levelStart;
+    std::size_t count;
+};
+/**
+ *  Class:      SpatialIndex
+ *              Read side of "<file>.spatial", read in place from the mapping. within appends every record inside
+ *              the query's radius, time window, and altitude band, descending only into the nodes whose box and
+ *              time span it reaches. nearest keeps best sorted by distance and at most wanted long, opening nodes
+ *              nearest first until the next one is further than the furthest kept match; passing the same vector
+ *              for several segments gives the nearest over all of them.
+ */
+
+inline bool writeSpatialIndex(const TelemetryStore &data, std::int64_t timeOffset, SpatialPlatform platform,
+                              std::uint64_t sourceHash, const std::string &indexFileName){
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    return false; /// The columns are stored little-endian
+#endif
+    ScopedStageTimer timer("spatial index write");
+    std::vector<std::size_t> rows;
+    rows.reserve(data.size());
+    for (std::size_t i = 0; i < data.size(); ++i){ /// Epochs without a fix have no place in the tree
+        if (std::isfinite(data.latitude[i]) && std::isfinite(data.longitude[i]) && std::fabs(data.latitude[i]) <= 90.0
+            && std::fabs(data.longitude[i]) <= 180.0 && (data.latitude[i] != 0 || data.longitude[i] != 0)) rows.push_back(i);
+    }
+    std::size_t count = rows.size();
+    timer.count(count);
+    SpatialIndexHeader header = {};
+    std::memcpy(header.magic, kSpatialIndexMagic, sizeof(header.magic));
+    header.version = kSpatialIndexVersion;
+    header.platform = static_cast<std::uint32_t>(platform);
+    header.recordCount = count;
+    header.sourceHash = sourceHash;
+    header.fanout = kSpatialIndexFanout;
+    header.minTime = std::numeric_limits<std::int64_t>::max();
+    header.maxTime = std::numeric_limits<std::int64_t>::min();
+    header.minLatitude = header.minLongitude = std::numeric_limits<double>::infinity();
+    header.maxLatitude = header.maxLongitude = -std::numeric_limits<double>::infinity();
+    for (std::size_t row : rows){
+        header.minTime = std::min(header.minTime, data.time[row] + timeOffset);
+        header.maxTime = std::max(header.maxTime, data.time[row] + timeOffset);
+        header.minLatitude = std::min(header.minLatitude, data.latitude[row]);
+        header.maxLatitude = std::max(header.maxLatitude, data.latitude[row]);
+        header.minLongitude = std::min(header.minLongitude, data.longitude[row]);
+        header.maxLongitude = std::max(header.maxLongitude, data.longitude[row]);
+    }
+    std::vector<std::uint64_t> curve(data.size());
+    double latitudeScale = header.maxLatitude > header.minLatitude ? 65535.0 / (header.maxLatitude - header.minLatitude) : 0;
+    double longitudeScale = header.maxLongitude > header.minLongitude ? 65535.0 / (header.maxLongitude - header.minLongitude) : 0;
+    for (std::size_t row : rows){
+        curve[row] = hilbertIndex(static_cast<std::uint32_t>((data.longitude[row] - header.minLongitude) * longitudeScale),
+                                  static_cast<std::uint32_t>((data.latitude[row] - header.minLatitude) * latitudeScale));
+    }
+    std::sort(rows.begin(), rows.end(), [&](std::size_t a, std::size_t b){
+        return curve[a] != curve[b] ? curve[a] < curve[b] : data.time[a] < data.time[b];
+    });
+
+    std::vector<std::int64_t> timeColumn(count), frameColumn(count);
+    std::vector<double> latitudeColumn(count), longitudeColumn(count), altitudeColumn(count);
+    for (std::size_t i = 0; i < count; ++i){
+        std::size_t row = rows[i];
+        timeColumn[i] = data.time[row] + timeOffset;
+        latitudeColumn[i] = data.latitude[row];
+        longitudeColumn[i] = data.longitude[row];
+        altitudeColumn[i] = data.altitude[row];
+        frameColumn[i] = data.frame[row];
+    }
+    std::vector<std::uint64_t> levelStart;
+    std::size_t nodeCount = static_cast<std::size_t>(spatialIndexLevels(count, kSpatialIndexFanout, levelStart));
+    header.nodeCount = nodeCount;
+    std::vector<double> minLatitude(nodeCount), maxLatitude(nodeCount), minLongitude(nodeCount), maxLongitude(nodeCount);
+    std::vector<std::int64_t> minTime(nodeCount), maxTime(nodeCount);
+    for (std::size_t level = 0; level + 1 < levelStart.size(); ++level){
+        std::size_t children = level == 0 ? count : static_cast<std::size_t>(levelStart[level] - levelStart[level - 1]);
+        for (std::size_t node = levelStart[level]; node < levelStart[level + 1]; ++node){
+            std::size_t first = (node - levelStart[level]) * kSpatialIndexFanout;
+            std::size_t last = std::min<std::size_t>(first + kSpatialIndexFanout, children);
+            minLatitude[node] = minLongitude[node] = std::numeric_limits<double>::infinity();
+            maxLatitude[node] = maxLongitude[node] = -std::numeric_limits<double>::infinity();
+            minTime[node] = std::numeric_limits<std::int64_t>::max();
+            maxTime[node] = std::numeric_limits<std::int64_t>::min();
+            for (std::size_t child = first; child < last; ++child){
+                if (level == 0){
+                    minLatitude[node] = std::min(minLatitude[node], latitudeColumn[child]);
+                    maxLatitude[node] = std::max(maxLatitude[node], latitudeColumn[child]);
+                    minLongitude[node] = std::min(minLongitude[node], longitudeColumn[child]);
+                    maxLongitude[node] = std::max(maxLongitude[node], longitudeColumn[child]);
+                    minTime[node] = std::min(minTime[node], timeColumn[child]);
+                    maxTime[node] = std::max(maxTime[node], timeColumn[child]);
+                    continue;
+                }
+                std::size_t below = levelStart[level - 1] + child;
+                minLatitude[node] = std::min(minLatitude[node], minLatitude[below]);
+                maxLatitude[node] = std::max(maxLatitude[node], maxLatitude[below]);
+                minLongitude[node] = std::min(minLongitude[node], minLongitude[below]);
+                maxLongitude[node] = std::max(maxLongitude[node], maxLongitude[below]);
+                minTime[node] = std::min(minTime[node], minTime[below]);
+                maxTime[node] = std::max(maxTime[node], maxTime[below]);
+            }
+        }
+    }
+    const void *columns[kSpatialIndexColumnCount] = {timeColumn.data(), latitudeColumn.data(), longitudeColumn.data(),
+                                                     altitudeColumn.data(), frameColumn.data(), minLatitude.data(),
+                                                     maxLatitude.data(), minLongitude.data(), maxLongitude.data(),
+                                                     minTime.data(), maxTime.data()};
+
+    std::string temporaryFileName = indexFileName + ".tmp"; /// Renamed into place, so a reader never sees half an index
+    BufferedFileWriter outs;
+    outs.open(temporaryFileName);
+    if (outs.fail()) return false;
+    const char padding[kSpatialIndexHeaderBytes] = {};
+    outs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::uint64_t written = sizeof(header);
+    for (int column = 0; column < kSpatialIndexColumnCount; ++column){
+        std::uint64_t start = spatialIndexColumnOffset(count, nodeCount, column);
+        std::uint64_t length = (column < kSpatialIndexNodeMinLatitude ? count : nodeCount) * 8;
+        outs.write(padding, start - written);
+        outs.write(static_cast<const char *>(columns[column]), length);
+        written = start + length;
+    }
+    outs.write(padding, spatialIndexColumnOffset(count, nodeCount, kSpatialIndexColumnCount) - written);
+    outs.close();
+    if (outs.fail() || std::rename(temporaryFileName.c_str(), indexFileName.c_str()) != 0){
+        std::remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+/**
+ *  Function:   writeSpatialIndex
+ *              Sorts the records with a position along a Hilbert curve, then by time, and writes them as a segment
+ *              with the nodes of the packed tree over them
+ *
+ *  @param data - parsed records
+ *  @param timeOffset - added to the record times to get UTC, the drone clock offset for SRT Files and 0 otherwise
+ *  @param platform - whether the records come from the drone or the receiver
+ *  @param sourceHash - hashTelemetrySource of the parsed file
+ *  @param indexFileName - name of the segment, usually spatialIndexName of the parsed file
+ *  @return false if the segment could not be written
+ */
+
+inline bool readSpatialIndexHeader(const std::string &indexFileName, SpatialIndexHeader &header){
+    std::ifstream ins(indexFileName, std::ios::binary);
+    if (!ins.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    return std::memcmp(header.magic, kSpatialIndexMagic, sizeof(header.magic)) == 0 && header.version == kSpatialIndexVersion;
+}
+/**
+ *  Function:   readSpatialIndexHeader
+ *              Reads the header of a segment without mapping its columns
+ *
+ *  @return false if the file is missing or is not a segment of this version
+ */
+
+struct SpatialCatalogEntry{
+    std::string indexFileName;      /// As written in the catalog, relative to the catalog's folder unless absolute
+    std::string path;               /// indexFileName resolved against the catalog's folder
+    SpatialIndexHeader header;      /// Only the platform, record count, time span, and bounding box are kept in the catalog
+};
+
+inline bool writeSpatialCatalog(const std::string &catalogFileName, const std::vector<SpatialCatalogEntry> &entries){
+    std::string temporaryFileName = catalogFileName + ".tmp";
+    std::ofstream outs(temporaryFileName);
+    if (outs.fail()) return false;
+    outs << kSpatialCatalogFirstLine << "\n# platform\trecords\tfirst UTC us\tlast UTC us\tmin latitude\tmax latitude\tmin longitude\tmax longitude\tsegment\n";
+    char line[256];
+    for (const SpatialCatalogEntry &entry : entries){
+        const SpatialIndexHeader &header = entry.header;
+        std::snprintf(line, sizeof(line), "%s\t%llu\t%lld\t%lld\t%.9f\t%.9f\t%.9f\t%.9f\t", spatialPlatformName(static_cast<SpatialPlatform>(header.platform)),
+                      static_cast<unsigned long long>(header.recordCount), static_cast<long long>(header.minTime),
+                      static_cast<long long>(header.maxTime), header.minLatitude, header.maxLatitude, header.minLongitude, header.maxLongitude);
+        outs << line << entry.indexFileName << '\n';
+    }
+    outs.close();
+    if (outs.fail() || std::rename(temporaryFileName.c_str(), catalogFileName.c_str()) != 0){
+        std::remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+/**
+ *  Function:   writeSpatialCatalog
+ *              Writes a catalog with one tab separated line per segment, its file name last so it may hold any
+ *              character but a tab
+ *
+ *  @return false if the catalog could not be written
+ */
+
+inline bool readSpatialCatalog(const std::string &catalogFileName, std::vector<SpatialCatalogEntry> &entries){
+    std::ifstream ins(catalogFileName);
+    std::string line;
+    if (!std::getline(ins, line) || line.rfind(kSpatialCatalogFirstLine, 0) != 0) return false;
+    std::filesystem::path folder = std::filesystem::path(catalogFileName).parent_path();
+    while (std::getline(ins, line)){
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t nameStart = 0;
+        for (int field = 0; field < 8 && nameStart != std::string::npos; ++field) nameStart = line.find('\t', nameStart + (field > 0));
+        if (nameStart == std::string::npos) return false;
+        std::istringstream fields(line.substr(0, nameStart));
+        std::string platform;
+        SpatialCatalogEntry entry;
+        SpatialIndexHeader &header = entry.header;
+        header = SpatialIndexHeader();
+        if (!(fields >> platform >> header.recordCount >> header.minTime >> header.maxTime >> header.minLatitude
+              >> header.maxLatitude >> header.minLongitude >> header.maxLongitude)) return false;
+        header.platform = static_cast<std::uint32_t>(platform == "drone" ? SpatialPlatform::Drone : SpatialPlatform::Receiver);
+        entry.indexFileName = line.substr(nameStart + 1);
+        std::filesystem::path segment(entry.indexFileName);
+        entry.path = (segment.is_absolute() ? segment : folder / segment).string();
+        entries.push_back(entry);
+    }
+    return true;
+}
+/**
+ *  Function:   readSpatialCatalog
+ *              Appends the segments of a catalog to entries
+ *
+ *  @return false if the file is not a catalog or has a malformed line
+ */
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file: srt_parser.h
+ * @date: 10/16/2026
+ * @brief: Parser for the SRT File a DJI drone writes next to each video. Blocks are scanned in place in a memory
+ *         mapped or read buffer, and fields are found by their key (FrameCnt, DiffTime, latitude, longitude,
+ *         altitude) rather than by column, so a firmware update that shifts the columns does not break it.
+ *         Used by parse_srt.cc and parse_campaign.cc.
+ */
+
+#ifndef SRT_PARSER_H
+#define SRT_PARSER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "telemetry_store.h"
+
+/// Returns the end of the line that starts at position, excluding the line break
+inline const char *findSrtLineEnd(const char *position, const char *end){
+    const char *newline = static_cast<const char *>(std::memchr(position, '\n', end - position));
+    return newline == nullptr ? end : newline;
+}
+
+/// Length of a line without a trailing carriage return
+inline std::size_t srtLineLength(const char *lineBegin, const char *lineEnd){
+    std::size_t length = lineEnd - lineBegin;
+    if (length > 0 && lineBegin[length - 1] == '\r') length--;
+    return length;
+}
+
+/// A timecode line looks like "00:00:01,001 --> 00:00:01,034"
+inline bool isSrtTimecodeLine(const char *lineBegin, const char *lineEnd){
+    return srtLineLength(lineBegin, lineEnd) >= 29 && lineBegin[2] == ':' && std::memcmp(lineBegin + 13, "-->", 3) == 0;
+}
+
+/// Returns the first character of the value that follows "key", skipping the spaces and colon in between
+inline const char *findSrtKeyValue(std::string_view block, std::string_view key){
+    std::size_t keyIndex = block.find(key);
+    if (keyIndex == std::string_view::npos) return nullptr;
+    const char *value = block.data() + keyIndex + key.size();
+    const char *blockEnd = block.data() + block.size();
+    while (value < blockEnd && (*value == ' ' || *value == ':')) value++;
+    return value;
+}
+
+/// Reads a fixed number of digits starting at position
+inline int readSrtDigits(const char *position, int count){
+    int value = 0;
+    for (int i = 0; i < count; ++i) value = value * 10 + (position[i] - '0');
+    return value;
+}
+
+inline bool parseSrtBlock(TelemetryRecord &entry, const char *blockBegin, const char *blockEnd){
+    /// Timecode looks like "hh:mm:ss,xxx"
+    entry.timecode = ((readSrtDigits(blockBegin, 2) * 60 + readSrtDigits(blockBegin + 3, 2)) * 60 + readSrtDigits(blockBegin + 6, 2))
+                   * kMicrosecondsPerSecond + readSrtDigits(blockBegin + 9, 3) * 1000;
+
+    const char *bodyBegin = findSrtLineEnd(blockBegin, blockEnd);
+    std::string_view body(bodyBegin, blockEnd - bodyBegin);
+
+    const char *value = findSrtKeyValue(body, "FrameCnt");
+    if (value == nullptr || std::from_chars(value, blockEnd, entry.frame).ec != std::errc()) return false;
+    value = findSrtKeyValue(body, "DiffTime");
+    if (value == nullptr || std::from_chars(value, blockEnd, entry.diffTime).ec != std::errc()) return false;
+
+    const char *dateLine = nullptr; /// The date line looks like "2020-08-04 14:23:17,123,456"
+    for (const char *line = bodyBegin; line < blockEnd; ){
+        line += (*line == '\n');
+        const char *lineEnd = findSrtLineEnd(line, blockEnd);
+        if (srtLineLength(line, lineEnd) >= 19 && line[4] == '-' && line[7] == '-' && line[13] == ':' && line[16] == ':'){
+            dateLine = line;
+            break;
+        }
+        line = lineEnd;
+    }
+    if (dateLine == nullptr) return false;
+    int microsecond = 0;
+    int fractionDigits = 0;
+    for (const char *digit = dateLine + 19; digit < blockEnd && fractionDigits < 6 && *digit != '\n'; ++digit){
+        if (*digit >= '0' && *digit <= '9'){ /// Milliseconds and microseconds are split by a separator
+            microsecond = microsecond * 10 + (*digit - '0');
+            fractionDigits++;
+        }
+        else if (fractionDigits != 0 && fractionDigits != 3) break;
+    }
+    for (; fractionDigits < 6; ++fractionDigits) microsecond *= 10;
+    entry.time = makeTimestamp(readSrtDigits(dateLine, 4), readSrtDigits(dateLine + 5, 2), readSrtDigits(dateLine + 8, 2),
+                               readSrtDigits(dateLine + 11, 2), readSrtDigits(dateLine + 14, 2), readSrtDigits(dateLine + 17, 2), microsecond);
+
+    value = findSrtKeyValue(body, "latitude");
+    if (value == nullptr || std::from_chars(value, blockEnd, entry.latitude).ec != std::errc()) return false;
+    value = findSrtKeyValue(body, "longitude");
+    if (value == nullptr) value = findSrtKeyValue(body, "longtitude"); /// DJI firmware spells the key "longtitude"
+    if (value == nullptr || std::from_chars(value, blockEnd, entry.longitude).ec != std::errc()) return false;
+    value = findSrtKeyValue(body, "altitude");
+    if (value == nullptr || std::from_chars(value, blockEnd, entry.altitude).ec != std::errc()) return false;
+    return true;
+}
+/**
+ *  Function:   parseSrtBlock
+ *              Decodes one SRT block directly from the buffer into numbers, so no heap allocation is made per record.
+ *
+ *  @param entry - record that will be written with the block's data
+ *  @param blockBegin - first byte of the timecode line
+ *  @param blockEnd - first byte of the blank line that closes the block (or the end of the file)
+ *  @return false if the block is missing any of the required fields
+ */
+
+template <class RecordHandler>
+void scanSrtBlocks(const char *begin, const char *end, RecordHandler handleRecord){
+    TelemetryRecord entry;
+    const char *position = begin;
+    while (position < end){
+        const char *lineEnd = findSrtLineEnd(position, end);
+        if (!isSrtTimecodeLine(position, lineEnd)){
+            position = lineEnd + (lineEnd < end);
+            continue;
+        }
+        const char *blockEnd = lineEnd;
+        while (blockEnd < end){ /// The block ends at the blank line before the next sequence number
+            const char *nextLine = blockEnd + 1;
+            const char *nextLineEnd = findSrtLineEnd(nextLine, end);
+            blockEnd = nextLine;
+            if (nextLine >= end || srtLineLength(nextLine, nextLineEnd) == 0) break;
+            blockEnd = nextLineEnd;
+        }
+        if (parseSrtBlock(entry, position, blockEnd)) handleRecord(entry, position, blockEnd);
+        position = blockEnd;
+    }
+}
+/**
+ *  Function:   scanSrtBlocks
+ *              Finds every SRT block that starts inside [begin, end) and calls handleRecord(entry, blockBegin, blockEnd)
+ *              for each block that parses
+ *
+ *  @param begin - first byte of the SRT text
+ *  @param end - one past the last byte of the SRT text
+ *  @param handleRecord - callable that takes a const TelemetryRecord & and the block's first and one past last bytes
+ */
+
+inline void loadSrt(TelemetryStore &data, const char *begin, const char *end){
+    scanSrtBlocks(begin, end, [&](const TelemetryRecord &entry, const char *blockBegin, const char *blockEnd){
+        if (data.size() == data.time.capacity()) /// Sizes the store from the first block instead of doubling it repeatedly
+            data.reserve(data.size() + (end - blockBegin) / (blockEnd - blockBegin + 1) + 1);
+        data.append(entry);
+    });
+}
+/**
+ *  Function:   loadSrt
+ *              Appends every SRT block that starts inside [begin, end) to a telemetry store
+ */
+
+/// Moves position forward to the first byte after the next blank line, which is where an SRT block starts
+inline const char *alignToSrtBlockStart(const char *position, const char *end){
+    while (position < end){
+        const char *lineEnd = findSrtLineEnd(position, end);
+        const char *nextLine = lineEnd + (lineEnd < end);
+        if (nextLine < end && srtLineLength(nextLine, findSrtLineEnd(nextLine, end)) == 0)
+            return findSrtLineEnd(nextLine, end) + 1;
+        position = nextLine;
+    }
+    return end;
+}
+
+/// One past the line break that closes the last complete block in a buffer, or 0 if the buffer holds no blank line
+inline std::size_t lastSrtBlockBoundary(const char *buffer, std::size_t length){
+    for (std::size_t i = length; i >= 2; --i){
+        if (buffer[i - 1] != '\n') continue;
+        if (buffer[i - 2] == '\n' || (i >= 3 && buffer[i - 2] == '\r' && buffer[i - 3] == '\n')) return i;
+    }
+    return 0;
+}
+
+inline void loadSrtParallel(TelemetryStore &data, const char *begin, const char *end, unsigned threadCount){
+    const std::size_t minimumChunkBytes = 1 << 20; /// Small files are not worth the thread start up
+    std::size_t size = end - begin;
+    std::size_t chunkCount = std::min<std::size_t>(threadCount, size / minimumChunkBytes + 1);
+    std::vector<const char *> chunkStart(chunkCount + 1);
+    chunkStart[0] = begin;
+    chunkStart[chunkCount] = end;
+    for (std::size_t i = 1; i < chunkCount; ++i){
+        const char *split = std::max(chunkStart[i - 1], begin + size / chunkCount * i);
+        chunkStart[i] = std::min(alignToSrtBlockStart(split, end), end);
+    }
+    std::vector<TelemetryStore> chunkData(chunkCount);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < chunkCount; ++i)
+        workers.emplace_back(loadSrt, std::ref(chunkData[i]), chunkStart[i], chunkStart[i + 1]);
+    for (std::size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    std::size_t totalSize = data.size();
+    for (std::size_t i = 0; i < chunkCount; ++i) totalSize += chunkData[i].size();
+    data.reserve(totalSize);
+    for (std::size_t i = 0; i < chunkCount; ++i) /// Ranges are in file order, so appending them keeps frame order
+        data.append(chunkData[i]);
+}
+/**
+ *  Function:   loadSrtParallel
+ *              Splits the buffer into one byte range per thread, moves each range forward to the start of an
+ *              SRT block, parses the ranges concurrently, and joins the results back in frame order.
+ *              The store is identical to the one loadSrt produces.
+ */
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file: stage_ledger.h
+ * @date: 10/16/2026
+ * @brief: Records which processing stages of a flight are up to date, so a rerun skips the stages whose inputs
+ *         and parameters have not changed. A stage is keyed by a StageKey, a hash of the content hashes of its
+ *         input files and of every parameter that changes its output, and the ledger remembers the key each
+ *         stage last ran with along with the size and modification time of each file it wrote. A stage is
+ *         current while its key is unchanged and none of its outputs has been deleted or edited since.
+ *         The ledger also remembers the content hash of each input file with its size and modification time, so
+ *         an input that has not been touched since is not read again to hash it, as telemetry_cache.h does.
+ *         The ledger is a small text file with one "stage key size time output" line per output and one
+ *         "input hash size time input" line per input.
+ */
+
+#ifndef STAGE_LEDGER_H
+#define STAGE_LEDGER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+#include "telemetry_cache.h"
+
+class StageKey{
+public:
+    StageKey() : hash(0x243F6A8885A308D3ull) {}
+
+    StageKey &add(std::uint64_t value){
+        hash = hashTelemetrySource(reinterpret_cast<const char *>(&value), sizeof(value)) ^ (hash * 0x9E3779B97F4A7C15ull);
+        return *this;
+    }
+    StageKey &add(std::int64_t value){ return add(static_cast<std::uint64_t>(value)); }
+    StageKey &add(bool value){ return add(static_cast<std::uint64_t>(value)); }
+    StageKey &add(double value){
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return add(bits);
+    }
+    StageKey &add(std::string_view text){ return add(hashTelemetrySource(text.data(), text.size())); }
+    StageKey &add(const char *text){ return add(std::string_view(text)); }
+
+    std::uint64_t value() const { return hash; }
+
+private:
+    std::uint64_t hash;
+};
+/**
+ *  Class:      StageKey
+ *              Order dependent hash of a stage's name, input hashes, and parameters
+ */
+
+class StageLedger{
+public:
+    explicit StageLedger(const std::string &fileName) : fileName(fileName) {
+        std::ifstream ins(fileName);
+        std::string line;
+        while (getline(ins, line)){
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream fields(line);
+            std::string stage;
+            Output output;
+            std::uint64_t key;
+            if (!(fields >> stage >> std::hex >> key >> std::dec >> output.size >> output.modifiedTime)) continue;
+            getline(fields >> std::ws, output.name);
+            if (stage == kInputStage){
+                inputs[output.name] = Input{key, output.size, output.modifiedTime};
+                continue;
+            }
+            stages[stage].key = key;
+            stages[stage].outputs.push_back(output);
+        }
+    }
+
+    bool current(const std::string &stage, std::uint64_t key) const {
+        std::map<std::string, Stage>::const_iterator found = stages.find(stage);
+        if (found == stages.end() || found->second.key != key || found->second.outputs.empty()) return false;
+        for (const Output &output : found->second.outputs){
+            struct stat fileStatus;
+            if (stat(output.name.c_str(), &fileStatus) != 0 || static_cast<std::uint64_t>(fileStatus.st_size) != output.size
+                || modifiedTime(fileStatus) != output.modifiedTime) return false;
+        }
+        return true;
+    }
+
+    void record(const std::string &stage, std::uint64_t key, const std::vector<std::string> &outputs){
+        Stage &entry = stages[stage];
+        entry.key = key;
+        entry.outputs.clear();
+        for (const std::string &name : outputs){
+            struct stat fileStatus;
+            if (stat(name.c_str(), &fileStatus) != 0) continue;
+            Output output;
+            output.name = name;
+            output.size = static_cast<std::uint64_t>(fileStatus.st_size);
+            output.modifiedTime = modifiedTime(fileStatus);
+            entry.outputs.push_back(output);
+        }
+    }
+
+    template <typename HashFile>
+    bool inputHash(const std::string &name, std::uint64_t &hash, HashFile hashFile){
+        struct stat fileStatus;
+        if (stat(name.c_str(), &fileStatus) != 0) return false;
+        Input input{0, static_cast<std::uint64_t>(fileStatus.st_size), modifiedTime(fileStatus)};
+        std::map<std::string, Input>::const_iterator found = inputs.find(name);
+        if (found != inputs.end() && found->second.size == input.size && found->second.modifiedTime == input.modifiedTime){
+            hash = found->second.hash;
+            return true;
+        }
+        if (!hashFile(input.hash)) return false;
+        inputs[name] = input;
+        hash = input.hash;
+        return true;
+    }
+
+    bool save() const {
+        std::string temporaryFileName = fileName + ".tmp";
+        std::ofstream outs(temporaryFileName);
+        outs << "# stage key size modified-time output" << '\n';
+        for (const std::pair<const std::string, Input> &input : inputs){
+            outs << kInputStage << ' ' << std::hex << input.second.hash << std::dec << ' ' << input.second.size << ' '
+                 << input.second.modifiedTime << ' ' << input.first << '\n';
+        }
+        for (const std::pair<const std::string, Stage> &stage : stages){
+            for (const Output &output : stage.second.outputs){
+                outs << stage.first << ' ' << std::hex << stage.second.key << std::dec << ' ' << output.size << ' '
+                     << output.modifiedTime << ' ' << output.name << '\n';
+            }
+        }
+        outs.close();
+        if (outs.fail() || std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0){
+            std::remove(temporaryFileName.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Output{
+        std::string name;
+        std::uint64_t size = 0;
+        std::int64_t modifiedTime = 0;
+    };
+    struct Stage{
+        std::uint64_t key = 0;
+        std::vector<Output> outputs;
+    };
+    struct Input{
+        std::uint64_t hash;
+        std::uint64_t size;
+        std::int64_t modifiedTime;
+    };
+    static constexpr const char *kInputStage = "input";
+
+    static std::int64_t modifiedTime(const struct stat &fileStatus){
+        return static_cast<std::int64_t>(fileStatus.st_mtim.tv_sec) * 1000000000 + fileStatus.st_mtim.tv_nsec;
+    }
+
+    std::string fileName;
+    std::map<std::string, Stage> stages;
+    std::map<std::string, Input> inputs;
+};
+/**
+ *  Class:      StageLedger
+ *              Ledger of the stages of one flight. inputHash gives the content hash of an input file, calling
+ *              hashFile(hash) only when the file's size or modification time differs from the ledger's; current
+ *              tells whether a stage can be skipped; record is called after a stage has written its outputs, and
+ *              save writes the ledger back (through a temporary file, so an interrupted run leaves the previous
+ *              ledger).
+ */
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file: synthetic_flight.h
+ * @date: 10/16/2026
+ * @brief: Deterministic generator of the two inputs of a flight, the DJI SRT File and the u-center PVT CSV File,
+ *         so the parsers can be profiled without a real flight. The drone climbs to altitude and then orbits the
+ *         take off point; the receiver reports the same track with seeded Gaussian noise. The noise comes from a
+ *         SplitMix64 generator and a Box-Muller transform rather than the standard library distributions, whose
+ *         output differs between implementations, so the same options give byte-identical files when built with
+ *         the same compiler and libm. Another libm may round sin, cos, or log differently in the last place and
+ *         change a printed digit. The flight length, the frame and receiver rates, the clock offset, and the column
+ *         layouts of the SRT firmware and the u-center export can be chosen. Used by generate_flight.cc and
+ *         bench_stages.cc.
+ */
+
+#ifndef SYNTHETIC_FLIGHT_H
+#define SYNTHETIC_FLIGHT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "telemetry_store.h"
+#include "geodesy.h"
+
+enum class SrtLayout { Mavic2, Phantom4, PositionFirst };
+enum class UbloxCsvColumns { Minimal, Full };
+
+struct SyntheticFlightOptions{
+    double seconds = 600;                   /// Length of the flight
+    double frameRate = 30000.0 / 1001.0;    /// Video frames per second, one SRT block each
+    double receiverRate = 1;                /// Receiver epochs per second
+    std::int64_t start = makeTimestamp(2020, 8, 4, 14, 0, 0, 0);    /// UTC of the first frame
+    std::int64_t droneClockOffset = 4 * 3600 * kMicrosecondsPerSecond; /// Added to drone times to get UTC
+    double latitude = 39.2109;              /// Take off point in degrees
+    double longitude = -82.2283;
+    double altitude = 232;                  /// Meters above mean sea level
+    double orbitRadius = 150;               /// Meters
+    double groundSpeed = 8;                 /// Meters per second along the orbit
+    double cruiseHeight = 120;              /// Meters above the take off point
+    double horizontalNoise = 1.5;           /// Standard deviation of the receiver error in meters, per axis
+    double verticalNoise = 3;
+    std::uint64_t seed = 1;
+    SrtLayout srtLayout = SrtLayout::Mavic2;
+    UbloxCsvColumns ubloxColumns = UbloxCsvColumns::Minimal;
+};
+
+class SyntheticRandom{
+public:
+    explicit SyntheticRandom(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next(){
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double uniform(){ return ((next() >> 11) + 0.5) / 9007199254740992.0; } /// In (0, 1)
+
+    double normal(){ return std::sqrt(-2 * std::log(uniform())) * std::cos(2 * M_PI * uniform()); }
+
+private:
+    std::uint64_t state;
+};
+/**
+ *  Class:      SyntheticRandom
+ *              SplitMix64 generator with uniform and standard normal draws
+ */
+
+inline void syntheticPosition(const SyntheticFlightOptions &options, double seconds, double &latitude, double &longitude,
+                              double &altitude){
+    const double climbRate = 3;     /// Meters per second, straight up before the orbit starts
+    double climbSeconds = options.cruiseHeight / climbRate;
+    double east = 0, north = 0, up = options.cruiseHeight;
+    if (seconds < climbSeconds) up = climbRate * seconds;
+    else {
+        double angle = options.groundSpeed * (seconds - climbSeconds) / options.orbitRadius;
+        east = options.orbitRadius * std::sin(angle);
+        north = options.orbitRadius * (1 - std::cos(angle)); /// The orbit passes through the take off point
+        up += 10 * std::sin(angle / 3);
+    }
+    double phi = options.latitude * kDegreesToRadians;
+    double sinPhi = std::sin(phi);
+    double curvature = 1 - kWgs84EccentricitySquared * sinPhi * sinPhi;
+    double meridianRadius = kWgs84SemiMajorAxis * (1 - kWgs84EccentricitySquared) / (curvature * std::sqrt(curvature));
+    double primeVertical = kWgs84SemiMajorAxis / std::sqrt(curvature);
+    latitude = options.latitude + north / meridianRadius * kRadiansToDegrees;
+    longitude = options.longitude + east / (primeVertical * std::cos(phi)) * kRadiansToDegrees;
+    altitude = options.altitude + up;
+}
+/**
+ *  Function:   syntheticPosition
+ *              Drone position a number of seconds after take off
+ */
+
+inline void generateSyntheticSrt(const SyntheticFlightOptions &options, std::string &text){
+    std::int64_t frameCount = static_cast<std::int64_t>(options.seconds * options.frameRate);
+    double framePeriod = kMicrosecondsPerSecond / options.frameRate;
+    int diffTime = static_cast<int>(std::lround(framePeriod / 1000));
+    text.clear();
+    text.reserve(static_cast<std::size_t>(frameCount) * 300);
+    char block[512];
+    for (std::int64_t i = 0; i < frameCount; ++i){
+        std::int64_t offset = static_cast<std::int64_t>(std::llround(i * framePeriod));
+        std::int64_t nextOffset = static_cast<std::int64_t>(std::llround((i + 1) * framePeriod));
+        char timecode[16], nextTimecode[16], date[16], time[16];
+        *formatTimeOfDay(offset, 3, timecode) = '\0';
+        *formatTimeOfDay(nextOffset, 3, nextTimecode) = '\0';
+        timecode[8] = nextTimecode[8] = ',';   /// SRT timecodes use a decimal comma
+        std::int64_t localTime = options.start + offset - options.droneClockOffset;
+        *formatDate(localTime, date) = '\0';
+        *formatTimeOfDay(localTime, 6, time) = '\0';
+        double latitude, longitude, altitude;
+        syntheticPosition(options, offset / static_cast<double>(kMicrosecondsPerSecond), latitude, longitude, altitude);
+        const char *exposure = "[iso : 100] [shutter : 1/640.0] [fnum : 280] [ev : 0] [ct : 5500] [color_md : default] [focal_len : 240]";
+        int length = 0;
+        if (options.srtLayout == SrtLayout::Phantom4){ /// Older firmware: wider font, spaced keys, "longtitude"
+            length = std::snprintf(block, sizeof(block), "%lld\n%s --> %s\n<font size=\"36\">FrameCnt : %lld, DiffTime : %dms\n"
+                                   "%s %.8s,%.3s,%.3s\n%s [latitude : %.6f] [longtitude : %.6f] [altitude: %.3f] </font>\n\n",
+                                   static_cast<long long>(i + 1), timecode, nextTimecode, static_cast<long long>(i + 1), diffTime,
+                                   date, time, time + 9, time + 12, exposure, latitude, longitude, altitude);
+        }
+        else if (options.srtLayout == SrtLayout::PositionFirst){ /// Position columns moved ahead of the exposure
+            length = std::snprintf(block, sizeof(block), "%lld\n%s --> %s\n<font size=\"28\">FrameCnt: %lld, DiffTime: %dms\n"
+                                   "%s %.8s,%.3s,%.3s\n[latitude: %.6f] [longitude: %.6f] [altitude: %.3f] %s </font>\n\n",
+                                   static_cast<long long>(i + 1), timecode, nextTimecode, static_cast<long long>(i + 1), diffTime,
+                                   date, time, time + 9, time + 12, latitude, longitude, altitude, exposure);
+        }
+        else {
+            length = std::snprintf(block, sizeof(block), "%lld\n%s --> %s\n<font size=\"28\">FrameCnt: %lld, DiffTime: %dms\n"
+                                   "%s %.8s,%.3s,%.3s\n%s [latitude: %.6f] [longitude: %.6f] [altitude: %.3f] </font>\n\n",
+                                   static_cast<long long>(i + 1), timecode, nextTimecode, static_cast<long long>(i + 1), diffTime,
+                                   date, time, time + 9, time + 12, exposure, latitude, longitude, altitude);
+        }
+        text.append(block, length);
+    }
+}
+/**
+ *  Function:   generateSyntheticSrt
+ *              Writes the SRT File of the flight, one block per video frame, in the chosen firmware layout. Times
+ *              are in the drone's clock, which is options.droneClockOffset behind UTC.
+ *
+ *  @param options - flight to generate
+ *  @param text - string that will be written with the file
+ */
+
+inline void generateSyntheticUbloxCsv(const SyntheticFlightOptions &options, std::string &text){
+    SyntheticRandom random(options.seed);
+    std::int64_t epochCount = static_cast<std::int64_t>(options.seconds * options.receiverRate);
+    text.clear();
+    text.reserve(static_cast<std::size_t>(epochCount) * (options.ubloxColumns == UbloxCsvColumns::Full ? 160 : 64));
+    if (options.ubloxColumns == UbloxCsvColumns::Full)
+        text += "Index,UTC,GPS Time,Fix Type,Num SV,Lat,Lon,Alt (HAE),Alt (MSL),HAcc,VAcc,Vel N,Vel E,Vel D,PDOP\n";
+    else text += "Index,UTC,Lat,Lon,Alt (MSL)\n";
+    const double geoidSeparation = -33.4; /// Alt (HAE) minus Alt (MSL) near the take off point
+    char row[256];
+    for (std::int64_t i = 0; i < epochCount; ++i){
+        std::int64_t offset = static_cast<std::int64_t>(std::llround(i * kMicrosecondsPerSecond / options.receiverRate));
+        std::int64_t utc = options.start + offset;
+        char date[16], time[16];
+        formatDate(utc, date);
+        *formatTimeOfDay(utc, 3, time) = '\0';
+        double latitude, longitude, altitude;
+        syntheticPosition(options, offset / static_cast<double>(kMicrosecondsPerSecond), latitude, longitude, altitude);
+        double metersPerDegree = kWgs84SemiMajorAxis * kDegreesToRadians;
+        latitude += options.horizontalNoise * random.normal() / metersPerDegree;
+        longitude += options.horizontalNoise * random.normal() / (metersPerDegree * std::cos(options.latitude * kDegreesToRadians));
+        altitude += options.verticalNoise * random.normal();
+        int length = 0;
+        if (options.ubloxColumns == UbloxCsvColumns::Full){
+            int satellites = 14 + static_cast<int>(random.next() % 6);
+            length = std::snprintf(row, sizeof(row), "%lld,%s %.2s/%.2s/%.4s,%.3f,3D,%d,%.8f,%.8f,%.3f,%.3f,%.3f,%.3f,0.000,0.000,0.000,1.21\n",
+                                   static_cast<long long>(i), time, date + 5, date + 8, date,
+                                   (utc / kMicrosecondsPerSecond - 315964800 + 18) % 604800 + (utc % kMicrosecondsPerSecond) / 1e6,
+                                   satellites, latitude, longitude, altitude + geoidSeparation, altitude,
+                                   options.horizontalNoise, options.verticalNoise);
+        }
+        else length = std::snprintf(row, sizeof(row), "%lld,%s %.2s/%.2s/%.4s,%.8f,%.8f,%.3f\n",
+                                    static_cast<long long>(i), time, date + 5, date + 8, date, latitude, longitude, altitude);
+        text.append(row, length);
+    }
+}
+/**
+ *  Function:   generateSyntheticUbloxCsv
+ *              Writes the u-center PVT CSV File of the flight: the drone's track in UTC with seeded receiver noise,
+ *              either with only the columns the parsers need or with the wider set of a full NAV-PVT export
+ *
+ *  @param options - flight to generate
+ *  @param text - string that will be written with the file
+ */
+
+inline bool parseSrtLayout(const std::string &name, SrtLayout &layout){
+    if (name == "mavic2") layout = SrtLayout::Mavic2;
+    else if (name == "phantom4") layout = SrtLayout::Phantom4;
+    else if (name == "position-first") layout = SrtLayout::PositionFirst;
+    else return false;
+    return true;
+}
+
+inline bool parseUbloxCsvColumns(const std::string &name, UbloxCsvColumns &columns){
+    if (name == "minimal") columns = UbloxCsvColumns::Minimal;
+    else if (name == "full") columns = UbloxCsvColumns::Full;
+    else return false;
+    return true;
+}
+
+inline bool parseSyntheticFlightOption(int &argumentIndex, int argc, char *argv[], SyntheticFlightOptions &options){
+    std::string argument = argv[argumentIndex];
+    if (argumentIndex + 1 >= argc) return false;
+    std::string value = argv[argumentIndex + 1];
+    if (argument == "--seconds") options.seconds = std::atof(value.c_str());
+    else if (argument == "--frame-rate") options.frameRate = std::atof(value.c_str());
+    else if (argument == "--receiver-rate") options.receiverRate = std::atof(value.c_str());
+    else if (argument == "--seed") options.seed = std::strtoull(value.c_str(), nullptr, 10);
+    else if (argument == "--layout"){
+        if (!parseSrtLayout(value, options.srtLayout)) return false;
+    }
+    else if (argument == "--columns"){
+        if (!parseUbloxCsvColumns(value, options.ubloxColumns)) return false;
+    }
+    else return false;
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseSyntheticFlightOption
+ *              Reads "--seconds", "--frame-rate", "--receiver-rate", "--seed", "--layout mavic2|phantom4|position-first",
+ *              or "--columns minimal|full" from the command line
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not a synthetic flight option
+ */
+
+#endif
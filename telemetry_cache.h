@@ -0,0 +1,405 @@
+/**
+ * @file: telemetry_cache.h
+ * @date: 10/16/2026
+ * @brief: Binary cache of a parsed telemetry file, so a tool run again on the same SRT File, CSV File, or UBX log
+ *         memory maps the columns instead of parsing the source again. The cache is written next to the source as "<source>.cache":
+ *         a header with the format version, the kind of source, its size, modification time, and content hash,
+ *         and a schema of the stored columns, followed by each column as fixed-width little-endian values
+ *         starting on a 64 byte boundary. The cache is used only while the source still has the same size and
+ *         either the same modification time or the same content hash, and is replaced whenever the format
+ *         version or the schema changes. The geometry columns are computed by every tool and are not stored.
+ *         When the source has only grown, which is how a recorder writes, the cached epochs are kept and just
+ *         the appended tail is parsed: the header records where the last complete record ended, and the cache
+ *         is reused if the first sourceSize bytes of the file still have the cached hash. A gzip or zstd
+ *         compressed source is parsed as it is decoded and is not cached.
+ */
+
+#ifndef TELEMETRY_CACHE_H
+#define TELEMETRY_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+#include "pipeline.h"
+#include "telemetry_store.h"
+#include "srt_parser.h"
+#include "drone_csv.h"
+#include "ublox_csv.h"
+#include "ubx_parser.h"
+#include "run_metrics.h"
+
+const char kTelemetryCacheMagic[8] = {'O', 'U', 'T', 'L', 'M', 'C', 'A', 'C'};
+const std::uint32_t kTelemetryCacheVersion = 3; /// 3: u-center altitudes come only from Alt (MSL)
+const std::size_t kTelemetryCacheColumnAlignment = 64;
+const std::size_t kTelemetryCacheColumnNameLength = 16;
+const std::size_t kStreamedParseBytes = 8 << 20;   /// Decoded bytes of a compressed source parsed at a time
+
+enum class TelemetrySource : std::uint32_t { Srt = 1, DroneCsv = 2, UbloxCsv = 3, Ubx = 4 };
+
+struct TelemetryCacheHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t source;               /// TelemetrySource the columns were parsed from
+    std::uint64_t recordCount;
+    std::uint64_t sourceSize;           /// Bytes of the source file
+    std::int64_t sourceModifiedTime;    /// Nanoseconds since 1970-01-01
+    std::uint64_t sourceHash;           /// hashTelemetrySource of the source file
+    std::uint64_t resumeOffset;         /// End of the last complete record (SRT block or CSV line) in the source
+    std::uint64_t resumeRecordCount;    /// Records parsed from before resumeOffset
+    std::uint32_t columnCount;
+    std::uint32_t reserved;
+};
+
+struct TelemetryCacheColumn{
+    char name[kTelemetryCacheColumnNameLength];
+    std::uint32_t type;                 /// 1 for int64, 2 for float64
+    std::uint32_t reserved;
+    std::uint64_t offset;               /// Bytes from the start of the cache file
+};
+
+static_assert(sizeof(TelemetryCacheHeader) == 72 && sizeof(TelemetryCacheColumn) == 32, "Cache layout must not be padded");
+
+/// Stored columns in file order; changing this list needs a new kTelemetryCacheVersion. Every source stores the first
+/// kTelemetryCacheColumnCount, and a UBX log also stores the fix quality columns that only it has.
+const char *const kTelemetryCacheColumnNames[] = {"time", "timecode", "frame", "diffTime", "latitude", "longitude", "altitude",
+                                                  "fixType", "satellites", "hAccuracy", "vAccuracy"};
+const std::uint32_t kTelemetryCacheColumnTypes[] = {1, 1, 1, 1, 2, 2, 2, 1, 1, 2, 2};
+const std::uint32_t kTelemetryCacheColumnCount = 7;
+const std::uint32_t kTelemetryCacheUbxColumnCount = 11;
+
+inline std::uint32_t telemetryCacheColumnCount(TelemetrySource kind){
+    return kind == TelemetrySource::Ubx ? kTelemetryCacheUbxColumnCount : kTelemetryCacheColumnCount;
+}
+
+inline std::uint64_t hashTelemetrySource(const char *data, std::size_t length){
+    const std::uint64_t prime1 = 0x9E3779B97F4A7C15ull, prime2 = 0xC2B2AE3D27D4EB4Full;
+    std::uint64_t lanes[4] = {prime1, prime2, ~prime1, ~prime2};
+    std::size_t position = 0;
+    for (; position + 32 <= length; position += 32){ /// Four independent lanes keep the multiplier busy
+        for (int lane = 0; lane < 4; ++lane){
+            std::uint64_t word;
+            std::memcpy(&word, data + position + 8 * lane, 8);
+            lanes[lane] ^= word * prime2;
+            lanes[lane] = ((lanes[lane] << 31) | (lanes[lane] >> 33)) * prime1;
+        }
+    }
+    std::uint64_t hash = length * prime1;
+    for (int lane = 0; lane < 4; ++lane) hash = (hash ^ lanes[lane]) * prime2;
+    for (; position < length; ++position) hash = (hash ^ static_cast<unsigned char>(data[position])) * prime1;
+    hash ^= hash >> 33; hash *= prime2; hash ^= hash >> 29; hash *= prime1; hash ^= hash >> 32;
+    return hash;
+}
+/**
+ *  Function:   hashTelemetrySource
+ *              64-bit content hash of a source file. It only has to tell an edited file from the one the cache was
+ *              built from, so it is a fast multiply-rotate hash rather than a cryptographic one.
+ */
+
+inline std::string telemetryCacheName(const std::string &sourceFileName){ return sourceFileName + ".cache"; }
+
+inline std::int64_t fileModifiedTime(const std::string &fileName){
+    struct stat fileStatus;
+    if (stat(fileName.c_str(), &fileStatus) != 0) return 0;
+    return static_cast<std::int64_t>(fileStatus.st_mtim.tv_sec) * 1000000000 + fileStatus.st_mtim.tv_nsec;
+}
+
+/// Columns of a store in the order of kTelemetryCacheColumnNames
+inline const void *telemetryCacheColumn(const TelemetryStore &data, std::uint32_t column){
+    const void *columns[kTelemetryCacheUbxColumnCount] = {data.time.data(), data.timecode.data(), data.frame.data(), data.diffTime.data(),
+                                                          data.latitude.data(), data.longitude.data(), data.altitude.data(),
+                                                          data.fixType.data(), data.satellites.data(),
+                                                          data.horizontalAccuracy.data(), data.verticalAccuracy.data()};
+    return columns[column];
+}
+
+inline bool readTelemetryCache(TelemetryStore &data, const std::string &sourceFileName, const MappedFile &source,
+                               TelemetrySource kind, std::size_t &resumeOffset){
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    return false; /// The columns are stored little-endian
+#endif
+    MappedFile cache;
+    cache.open(telemetryCacheName(sourceFileName));
+    if (cache.fail() || cache.size() < sizeof(TelemetryCacheHeader)) return false;
+    TelemetryCacheHeader header;
+    std::memcpy(&header, cache.begin(), sizeof(header));
+    if (std::memcmp(header.magic, kTelemetryCacheMagic, sizeof(header.magic)) != 0 || header.version != kTelemetryCacheVersion
+        || header.source != static_cast<std::uint32_t>(kind) || header.columnCount != telemetryCacheColumnCount(kind)
+        || header.sourceSize > source.size() || header.resumeOffset > header.sourceSize
+        || header.resumeRecordCount > header.recordCount) return false;
+    if (cache.size() < sizeof(header) + header.columnCount * sizeof(TelemetryCacheColumn)) return false;
+    const char *columns[kTelemetryCacheUbxColumnCount] = {};
+    for (std::uint32_t i = 0; i < header.columnCount; ++i){
+        TelemetryCacheColumn column;
+        std::memcpy(&column, cache.begin() + sizeof(header) + i * sizeof(column), sizeof(column));
+        if (std::strncmp(column.name, kTelemetryCacheColumnNames[i], kTelemetryCacheColumnNameLength) != 0
+            || column.type != kTelemetryCacheColumnTypes[i] || column.offset % kTelemetryCacheColumnAlignment != 0
+            || column.offset > cache.size() || (cache.size() - column.offset) / 8 < header.recordCount) return false;
+        columns[i] = cache.begin() + column.offset;
+    }
+    std::int64_t modifiedTime = fileModifiedTime(sourceFileName);
+    bool grown = header.sourceSize < source.size();
+    if (grown){
+        if (header.sourceHash != hashTelemetrySource(source.begin(), header.sourceSize)) return false; /// Not an append
+    }
+    else if (header.sourceModifiedTime != modifiedTime){
+        if (header.sourceHash != hashTelemetrySource(source.begin(), source.size())) return false; /// Edited
+        int fileDescriptor = ::open(telemetryCacheName(sourceFileName).c_str(), O_WRONLY);
+        if (fileDescriptor >= 0){ /// The source was only touched; storing its new time lets the next run skip the hash
+            pwrite(fileDescriptor, &modifiedTime, sizeof(modifiedTime), offsetof(TelemetryCacheHeader, sourceModifiedTime));
+            ::close(fileDescriptor);
+        }
+    }
+
+    std::size_t count = static_cast<std::size_t>(grown ? header.resumeRecordCount : header.recordCount);
+    resumeOffset = grown ? static_cast<std::size_t>(header.resumeOffset) : source.size();
+    std::vector<std::int64_t> *integerColumns[kTelemetryCacheUbxColumnCount] = {
+        &data.time, &data.timecode, &data.frame, &data.diffTime, nullptr, nullptr, nullptr, &data.fixType, &data.satellites, nullptr, nullptr};
+    std::vector<double> *doubleColumns[kTelemetryCacheUbxColumnCount] = {
+        nullptr, nullptr, nullptr, nullptr, &data.latitude, &data.longitude, &data.altitude, nullptr, nullptr,
+        &data.horizontalAccuracy, &data.verticalAccuracy};
+    for (std::uint32_t i = 0; i < kTelemetryCacheUbxColumnCount; ++i){ /// Columns start on a 64 byte boundary of a page aligned mapping
+        if (integerColumns[i] != nullptr){
+            const std::int64_t *values = reinterpret_cast<const std::int64_t *>(columns[i]);
+            if (i < header.columnCount) integerColumns[i]->assign(values, values + count);
+            else integerColumns[i]->assign(count, 0); /// Not stored for this source
+        }
+        else {
+            const double *values = reinterpret_cast<const double *>(columns[i]);
+            if (i < header.columnCount) doubleColumns[i]->assign(values, values + count);
+            else doubleColumns[i]->assign(count, 0);
+        }
+    }
+    data.heading.assign(count, 0); data.elevationAngle.assign(count, 0); data.slantDistance.assign(count, 0);
+    return true;
+}
+/**
+ *  Function:   readTelemetryCache
+ *              Fills the store from the cache of a source file if the cache exists and the file is unchanged or
+ *              has only been appended to
+ *
+ *  @param data - store that will be written with the cached columns (geometry columns are zero)
+ *  @param sourceFileName - name of the SRT File, CSV File, or UBX log the cache was built from
+ *  @param source - the same file, memory mapped; it is only read when its modification time or size has changed
+ *  @param kind - parser the columns must have come from
+ *  @param resumeOffset - written with the offset the source still has to be parsed from, which is the end of
+ *                        the file unless it has grown
+ *  @return false if there is no usable cache, in which case the source has to be parsed
+ */
+
+inline bool writeTelemetryCache(const TelemetryStore &data, const std::string &sourceFileName, const MappedFile &source,
+                                TelemetrySource kind, std::size_t resumeOffset, std::size_t resumeRecordCount){
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    return false;
+#endif
+    TelemetryCacheHeader header = {};
+    std::memcpy(header.magic, kTelemetryCacheMagic, sizeof(header.magic));
+    header.version = kTelemetryCacheVersion;
+    header.source = static_cast<std::uint32_t>(kind);
+    header.recordCount = data.size();
+    header.sourceSize = source.size();
+    header.sourceModifiedTime = fileModifiedTime(sourceFileName);
+    header.sourceHash = hashTelemetrySource(source.begin(), source.size());
+    header.resumeOffset = resumeOffset;
+    header.resumeRecordCount = resumeRecordCount;
+    header.columnCount = telemetryCacheColumnCount(kind);
+
+    std::string cacheFileName = telemetryCacheName(sourceFileName);
+    std::string temporaryFileName = cacheFileName + ".tmp"; /// Renamed into place, so a reader never sees half a cache
+    BufferedFileWriter outs;
+    outs.open(temporaryFileName);
+    if (outs.fail()) return false;
+    outs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::uint64_t offset = sizeof(header) + header.columnCount * sizeof(TelemetryCacheColumn);
+    std::uint64_t columnBytes = data.size() * 8;
+    for (std::uint32_t i = 0; i < header.columnCount; ++i){
+        offset = (offset + kTelemetryCacheColumnAlignment - 1) / kTelemetryCacheColumnAlignment * kTelemetryCacheColumnAlignment;
+        TelemetryCacheColumn column = {};
+        std::memcpy(column.name, kTelemetryCacheColumnNames[i], std::strlen(kTelemetryCacheColumnNames[i])); /// Zero padded, not terminated at 16
+        column.type = kTelemetryCacheColumnTypes[i];
+        column.offset = offset;
+        outs.write(reinterpret_cast<const char *>(&column), sizeof(column));
+        offset += columnBytes;
+    }
+    std::uint64_t written = sizeof(header) + header.columnCount * sizeof(TelemetryCacheColumn);
+    const char padding[kTelemetryCacheColumnAlignment] = {};
+    for (std::uint32_t i = 0; i < header.columnCount; ++i){
+        std::uint64_t start = (written + kTelemetryCacheColumnAlignment - 1) / kTelemetryCacheColumnAlignment * kTelemetryCacheColumnAlignment;
+        outs.write(padding, start - written);
+        outs.write(static_cast<const char *>(telemetryCacheColumn(data, i)), columnBytes);
+        written = start + columnBytes;
+    }
+    outs.close();
+    if (outs.fail() || std::rename(temporaryFileName.c_str(), cacheFileName.c_str()) != 0){
+        std::remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+/**
+ *  Function:   writeTelemetryCache
+ *              Writes the parsed columns of a source file to "<source>.cache"
+ *
+ *  @param data - store as the parser produced it, before any clock offset is applied
+ *  @param sourceFileName - name of the SRT File, CSV File, or UBX log that was parsed
+ *  @param source - the same file, memory mapped, for its size and content hash
+ *  @param kind - parser the columns came from
+ *  @param resumeOffset - end of the last complete record in the source
+ *  @param resumeRecordCount - number of records parsed from before resumeOffset
+ *  @return false if the cache could not be written, which only costs the next run a parse
+ */
+
+/// End of the last complete record in a source: after the blank line closing an SRT block, after a CSV line break, or
+/// after the last whole UBX frame
+inline std::size_t lastCompleteRecordEnd(TelemetrySource kind, const char *begin, std::size_t length){
+    if (kind == TelemetrySource::Srt) return lastSrtBlockBoundary(begin, length);
+    if (kind == TelemetrySource::Ubx) return lastUbxFrameEnd(begin, length);
+    while (length > 0 && begin[length - 1] != '\n') length--;
+    return length;
+}
+
+inline long long loadTelemetryRange(TelemetryStore &data, TelemetrySource kind, const char *fileBegin, const char *from,
+                                    const char *to, unsigned threadCount, long long &malformedRecords){
+    long long malformed = 0;
+    std::size_t before = data.size();
+    if (from == to) return 0;
+    if (kind == TelemetrySource::Srt){
+        if (threadCount > 1) loadSrtParallel(data, from, to, threadCount);
+        else loadSrt(data, from, to);
+    }
+    else if (kind == TelemetrySource::DroneCsv) loadDroneCsv(data, from, to, &malformed);
+    else if (kind == TelemetrySource::Ubx) loadUbx(data, from, to, &malformed);
+    else if (loadUbloxCsv(data, fileBegin, to, &malformed, from) < 0) return -1; /// Rows after from, columns from the header
+    malformedRecords += malformed;
+    return static_cast<long long>(data.size() - before);
+}
+/**
+ *  Function:   loadTelemetryRange
+ *              Appends the records of the source that start in [from, to) with the parser for its kind
+ *
+ *  @param fileBegin - first byte of the source, where the u-center CSV header is read from
+ *  @param threadCount - threads used for an SRT range (loadSrtParallel), 1 parses on the calling thread
+ *  @param malformedRecords - incremented by the rows of a CSV File that were skipped, or the corrupt frames of a UBX log
+ *  @return number of records appended, or -1 if a u-center CSV header is missing a required column
+ */
+
+inline std::size_t loadCompleteRecords(TelemetryStore &data, TelemetrySource kind, const char *fileBegin, const char *from,
+                                       const char *to, unsigned threadCount, long long &malformedRecords){
+    if (kind == TelemetrySource::Ubx){ /// Frames are found front to back, so the decoder finds the end of the last one as it goes
+        std::size_t completeLength = 0;
+        long long corrupt = 0;
+        loadUbx(data, from, to, &corrupt, false, &completeLength);
+        malformedRecords += corrupt;
+        return completeLength;
+    }
+    std::size_t completeLength = lastCompleteRecordEnd(kind, from, to - from);
+    loadTelemetryRange(data, kind, fileBegin, from, from + completeLength, threadCount, malformedRecords);
+    return completeLength;
+}
+/**
+ *  Function:   loadCompleteRecords
+ *              Appends the records of [from, to) up to the end of the last complete one, leaving a trailing record
+ *              that is still being written. Parameters are those of loadTelemetryRange.
+ *
+ *  @return bytes from from to the end of the last complete record
+ */
+
+/// Name of the run_metrics.h stage that parses a kind of source
+inline const char *telemetryParseStage(TelemetrySource kind){
+    if (kind == TelemetrySource::Srt) return "SRT parse";
+    if (kind == TelemetrySource::DroneCsv) return "drone CSV parse";
+    if (kind == TelemetrySource::Ubx) return "UBX parse";
+    return "u-center CSV parse";
+}
+
+inline long long loadDecodedTelemetry(TelemetryStore &data, const MappedFile &source, TelemetrySource kind,
+                                      unsigned threadCount, long long &malformedRecords){
+    const char *begin = source.streamBegin();
+    bool finished = false;
+    std::size_t available = source.waitForBytes(1, &finished);
+    if (kind == TelemetrySource::UbloxCsv){ /// The header line is read before any row
+        while (!finished && std::memchr(begin, '\n', available) == nullptr) available = source.waitForBytes(available + 1, &finished);
+        if (UbloxCsvReader(begin, begin + available).fail()) return -1;
+    }
+    std::size_t parsed = 0;
+    while (!finished){
+        available = source.waitForBytes(std::max(parsed + kStreamedParseBytes, available + 1), &finished);
+        if (!finished) parsed += loadCompleteRecords(data, kind, begin, begin + parsed, begin + available, threadCount, malformedRecords);
+    }
+    loadTelemetryRange(data, kind, begin, begin + parsed, begin + available, threadCount, malformedRecords);
+    return static_cast<long long>(data.size());
+}
+/**
+ *  Function:   loadDecodedTelemetry
+ *              Parses a compressed source while it is being decoded (compressed_input.h): each time another
+ *              kStreamedParseBytes have been decoded, the complete records among them are appended, and the rest is
+ *              parsed once the decoder has finished. Parameters are those of loadTelemetryRange.
+ *
+ *  @return number of records, or -1 if a u-center CSV header is missing a required column
+ */
+
+inline long long loadTelemetryFile(TelemetryStore &data, const std::string &sourceFileName, const MappedFile &source,
+                                   TelemetrySource kind, bool useCache, unsigned threadCount = 1,
+                                   long long *malformedRecords = nullptr){
+    long long malformed = 0;
+    std::size_t resumeOffset = 0;
+    data.clear();
+    if (source.compressed()){ /// An archive does not grow, and a cache would take the space its compression saved
+        ScopedStageTimer parseTimer(telemetryParseStage(kind));
+        long long recordCount = loadDecodedTelemetry(data, source, kind, threadCount, malformed);
+        if (recordCount < 0) return -1;
+        parseTimer.count(recordCount, source.size());
+        countRunMetric(kind == TelemetrySource::Ubx ? "corrupt UBX frames" : "malformed rows", malformed);
+        if (malformedRecords != nullptr) *malformedRecords = malformed;
+        return recordCount;
+    }
+    if (kind == TelemetrySource::UbloxCsv && UbloxCsvReader(source.begin(), source.end()).fail()) return -1;
+    bool cached = false;
+    if (useCache){
+        ScopedStageTimer timer("cache read");
+        cached = readTelemetryCache(data, sourceFileName, source, kind, resumeOffset);
+        if (cached) timer.count(data.size());
+    }
+    if (cached && resumeOffset == source.size()) return static_cast<long long>(data.size());
+    ScopedStageTimer parseTimer(telemetryParseStage(kind));
+    std::size_t cachedRecordCount = data.size();
+    std::size_t completeEnd = resumeOffset + loadCompleteRecords(data, kind, source.begin(), source.begin() + resumeOffset,
+                                                                 source.end(), threadCount, malformed);
+    std::size_t resumeRecordCount = data.size();
+    loadTelemetryRange(data, kind, source.begin(), source.begin() + completeEnd, source.end(), 1, malformed);
+    parseTimer.count(data.size() - cachedRecordCount, source.size() - resumeOffset);
+    countRunMetric(kind == TelemetrySource::Ubx ? "corrupt UBX frames" : "malformed rows", malformed);
+    if (malformedRecords != nullptr) *malformedRecords = malformed;
+    if (useCache){
+        ScopedStageTimer timer("cache write");
+        writeTelemetryCache(data, sourceFileName, source, kind, completeEnd, resumeRecordCount);
+        timer.count(data.size());
+    }
+    return static_cast<long long>(data.size());
+}
+/**
+ *  Function:   loadTelemetryFile
+ *              Loads a source through its cache: an unchanged file is read from the cache alone, a file that has
+ *              grown has only its new records parsed, and anything else is parsed in full. The cache is then
+ *              brought up to date. The trailing record that may still be incomplete in a growing file is parsed
+ *              but left after resumeOffset, so it is parsed again once the rest of it has been written.
+ *
+ *  @param data - store that will be written with the records, before any clock offset is applied
+ *  @param sourceFileName - name of the SRT File, CSV File, or UBX log
+ *  @param source - the same file, memory mapped
+ *  @param kind - parser for the file
+ *  @param useCache - false parses the whole file and neither reads nor writes a cache. A compressed source is
+ *                    parsed as it is decoded and never cached.
+ *  @param threadCount - threads used to parse an SRT File
+ *  @param malformedRecords - optional count of the rows that were skipped in the parsed part of a CSV File, or of
+ *                            the corrupt frames of a UBX log
+ *  @return number of records, or -1 if a u-center CSV header is missing a required column
+ */
+
+#endif
@@ -0,0 +1,269 @@
+/**
+ * @file: telemetry_store.h
+ * @date: 10/16/2026
+ * @brief: Columnar store of telemetry epochs shared by parse_srt.cc, parse_drone_csv.cc, and parse_ublox_csv.cc.
+ *         Every field is kept as a number in its own contiguous column (structure of arrays), so an epoch
+ *         costs about 110 bytes instead of a dozen heap allocated strings, and the geometry and the writers
+ *         walk plain arrays. Times are stored as microseconds since 1970-01-01 and are formatted back to
+ *         text only when a file is written.
+ */
+
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct TelemetryRecord{
+    std::int64_t time = 0;          /// Microseconds since 1970-01-01 of the clock written in the source file
+    std::int64_t timecode = 0;      /// Microseconds from the start of the video (drone only)
+    std::int64_t frame = 0;         /// Video frame number for the drone, row index for the Ublox receiver
+    std::int64_t diffTime = 0;      /// Milliseconds between video frames (drone only)
+    double latitude = 0;            /// Degrees
+    double longitude = 0;           /// Degrees
+    double altitude = 0;            /// Meters
+    std::int64_t fixType = 0;       /// GNSS fix type of a UBX NAV-PVT epoch (2 2D, 3 3D, 4 with dead reckoning), 0 otherwise
+    std::int64_t satellites = 0;    /// Satellites used in the fix (UBX only)
+    double horizontalAccuracy = 0;  /// Receiver's estimate in meters (UBX only)
+    double verticalAccuracy = 0;    /// Receiver's estimate in meters (UBX only)
+};
+
+struct TelemetryStore{
+    std::vector<std::int64_t> time;
+    std::vector<std::int64_t> timecode;
+    std::vector<std::int64_t> frame;
+    std::vector<std::int64_t> diffTime;
+    std::vector<double> latitude;
+    std::vector<double> longitude;
+    std::vector<double> altitude;
+    std::vector<std::int64_t> fixType;
+    std::vector<std::int64_t> satellites;
+    std::vector<double> horizontalAccuracy;
+    std::vector<double> verticalAccuracy;
+    std::vector<double> heading;        /// Heading where the Ublox GNSS is the origin in relation to the drone
+    std::vector<double> elevationAngle; /// Elevation angle from the Ublox GNSS to the drone
+    std::vector<double> slantDistance;  /// Distance between the Ublox GNSS and the drone in meters
+
+    std::size_t size() const { return time.size(); }
+    bool empty() const { return time.empty(); }
+
+    void reserve(std::size_t count){
+        time.reserve(count); timecode.reserve(count); frame.reserve(count); diffTime.reserve(count);
+        latitude.reserve(count); longitude.reserve(count); altitude.reserve(count);
+        fixType.reserve(count); satellites.reserve(count); horizontalAccuracy.reserve(count); verticalAccuracy.reserve(count);
+        heading.reserve(count); elevationAngle.reserve(count); slantDistance.reserve(count);
+    }
+
+    void clear(){
+        time.clear(); timecode.clear(); frame.clear(); diffTime.clear();
+        latitude.clear(); longitude.clear(); altitude.clear();
+        fixType.clear(); satellites.clear(); horizontalAccuracy.clear(); verticalAccuracy.clear();
+        heading.clear(); elevationAngle.clear(); slantDistance.clear();
+    }
+
+    void append(const TelemetryRecord &record){ /// Geometry columns start at zero until they are computed
+        time.push_back(record.time); timecode.push_back(record.timecode);
+        frame.push_back(record.frame); diffTime.push_back(record.diffTime);
+        latitude.push_back(record.latitude); longitude.push_back(record.longitude); altitude.push_back(record.altitude);
+        fixType.push_back(record.fixType); satellites.push_back(record.satellites);
+        horizontalAccuracy.push_back(record.horizontalAccuracy); verticalAccuracy.push_back(record.verticalAccuracy);
+        heading.push_back(0); elevationAngle.push_back(0); slantDistance.push_back(0);
+    }
+
+    void append(const TelemetryStore &source, std::size_t index){ /// Copies one epoch of another store
+        time.push_back(source.time[index]); timecode.push_back(source.timecode[index]);
+        frame.push_back(source.frame[index]); diffTime.push_back(source.diffTime[index]);
+        latitude.push_back(source.latitude[index]); longitude.push_back(source.longitude[index]);
+        altitude.push_back(source.altitude[index]); fixType.push_back(source.fixType[index]);
+        satellites.push_back(source.satellites[index]); horizontalAccuracy.push_back(source.horizontalAccuracy[index]);
+        verticalAccuracy.push_back(source.verticalAccuracy[index]); heading.push_back(source.heading[index]);
+        elevationAngle.push_back(source.elevationAngle[index]); slantDistance.push_back(source.slantDistance[index]);
+    }
+
+    void append(const TelemetryStore &source){ /// Copies every epoch of another store
+        appendColumn(time, source.time); appendColumn(timecode, source.timecode);
+        appendColumn(frame, source.frame); appendColumn(diffTime, source.diffTime);
+        appendColumn(latitude, source.latitude); appendColumn(longitude, source.longitude);
+        appendColumn(altitude, source.altitude); appendColumn(fixType, source.fixType);
+        appendColumn(satellites, source.satellites); appendColumn(horizontalAccuracy, source.horizontalAccuracy);
+        appendColumn(verticalAccuracy, source.verticalAccuracy); appendColumn(heading, source.heading);
+        appendColumn(elevationAngle, source.elevationAngle); appendColumn(slantDistance, source.slantDistance);
+    }
+
+    TelemetryRecord record(std::size_t index) const {
+        TelemetryRecord entry;
+        entry.time = time[index]; entry.timecode = timecode[index];
+        entry.frame = frame[index]; entry.diffTime = diffTime[index];
+        entry.latitude = latitude[index]; entry.longitude = longitude[index]; entry.altitude = altitude[index];
+        entry.fixType = fixType[index]; entry.satellites = satellites[index];
+        entry.horizontalAccuracy = horizontalAccuracy[index]; entry.verticalAccuracy = verticalAccuracy[index];
+        return entry;
+    }
+
+private:
+    template <class T>
+    static void appendColumn(std::vector<T> &column, const std::vector<T> &source){
+        column.insert(column.end(), source.begin(), source.end());
+    }
+};
+
+const std::int64_t kMicrosecondsPerSecond = 1000000;
+const std::int64_t kMicrosecondsPerDay = 86400 * kMicrosecondsPerSecond;
+
+inline std::int64_t daysFromCivil(int year, int month, int day){
+    year -= month <= 2;
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    std::int64_t yearOfEra = year - era * 400;
+    std::int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+/**
+ *  Function:   daysFromCivil
+ *              Number of days between 1970-01-01 and the given proleptic Gregorian date
+ */
+
+inline void civilFromDays(std::int64_t days, int &year, int &month, int &day){
+    days += 719468;
+    std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    std::int64_t dayOfEra = days - era * 146097;
+    std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    std::int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    year = static_cast<int>(yearOfEra + era * 400 + (month <= 2));
+}
+/**
+ *  Function:   civilFromDays
+ *              Inverse of daysFromCivil
+ */
+
+inline std::int64_t makeTimestamp(int year, int month, int day, int hour, int minute, int second, std::int64_t microsecond){
+    return daysFromCivil(year, month, day) * kMicrosecondsPerDay
+         + ((hour * 60 + minute) * 60 + second) * kMicrosecondsPerSecond + microsecond;
+}
+/**
+ *  Function:   makeTimestamp
+ *              Converts a calendar date and time of day into microseconds since 1970-01-01
+ */
+
+inline std::int64_t floorDivide(std::int64_t value, std::int64_t divisor){
+    return value / divisor - (value % divisor < 0);
+}
+
+inline int secondOfMinute(std::int64_t time){
+    return static_cast<int>(floorDivide(time, kMicrosecondsPerSecond) % 60 + 60) % 60;
+}
+
+inline char *writeDigits(char *buffer, std::int64_t value, int width){
+    for (int i = width - 1; i >= 0; --i){
+        buffer[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return buffer + width;
+}
+
+inline char *formatDate(std::int64_t time, char *buffer){
+    int year, month, day;
+    civilFromDays(floorDivide(time, kMicrosecondsPerDay), year, month, day);
+    buffer = writeDigits(buffer, year, 4); *buffer++ = '-';
+    buffer = writeDigits(buffer, month, 2); *buffer++ = '-';
+    return writeDigits(buffer, day, 2);
+}
+/**
+ *  Function:   formatDate
+ *              Writes the date of a timestamp as YYYY-MM-DD
+ *
+ *  @param time - microseconds since 1970-01-01
+ *  @param buffer - at least 10 characters
+ *  @return one past the last character written
+ */
+
+inline char *formatTimeOfDay(std::int64_t time, int decimals, char *buffer){
+    std::int64_t microsecondOfDay = time - floorDivide(time, kMicrosecondsPerDay) * kMicrosecondsPerDay;
+    std::int64_t secondOfDay = microsecondOfDay / kMicrosecondsPerSecond;
+    buffer = writeDigits(buffer, secondOfDay / 3600, 2); *buffer++ = ':';
+    buffer = writeDigits(buffer, secondOfDay / 60 % 60, 2); *buffer++ = ':';
+    buffer = writeDigits(buffer, secondOfDay % 60, 2);
+    if (decimals <= 0) return buffer;
+    *buffer++ = '.';
+    std::int64_t fraction = microsecondOfDay % kMicrosecondsPerSecond;
+    for (int i = decimals; i < 6; ++i) fraction /= 10;
+    return writeDigits(buffer, fraction, decimals > 6 ? 6 : decimals);
+}
+/**
+ *  Function:   formatTimeOfDay
+ *              Writes the time of day of a timestamp as hh:mm:ss.fff with the given number of decimals (up to 6)
+ *
+ *  @param time - microseconds since 1970-01-01, or since the start of a video for timecodes
+ *  @param decimals - number of fractional second digits, which are truncated rather than rounded
+ *  @param buffer - at least 15 characters
+ *  @return one past the last character written
+ */
+
+inline char *formatIsoTimestamp(std::int64_t time, int decimals, char *buffer){
+    buffer = formatDate(time, buffer);
+    *buffer++ = 'T';
+    buffer = formatTimeOfDay(time, decimals, buffer);
+    *buffer++ = 'Z';
+    return buffer;
+}
+/**
+ *  Function:   formatIsoTimestamp
+ *              Writes a timestamp as yyyy-mm-ddThh:mm:ss.xxxZ, the form used by KML <when>, <begin>, and <end>
+ *
+ *  @param time - microseconds since 1970-01-01
+ *  @param decimals - number of fractional second digits
+ *  @param buffer - at least 28 characters
+ *  @return one past the last character written
+ */
+
+inline bool parseTimeOfDay(std::string_view text, std::int64_t &microseconds){
+    if (text.size() < 8 || text[2] != ':' || text[5] != ':') return false;
+    std::int64_t value = 0;
+    const int digitPositions[] = {0, 1, 3, 4, 6, 7};
+    for (int position : digitPositions){
+        if (text[position] < '0' || text[position] > '9') return false;
+    }
+    value = (((text[0] - '0') * 10 + (text[1] - '0')) * 60 + ((text[3] - '0') * 10 + (text[4] - '0'))) * 60
+          + ((text[6] - '0') * 10 + (text[7] - '0'));
+    std::int64_t fraction = 0;
+    int fractionDigits = 0;
+    if (text.size() > 8){
+        if (text[8] != '.' && text[8] != ',') return false;
+        for (std::size_t i = 9; i < text.size(); ++i){
+            if (text[i] < '0' || text[i] > '9') return false;
+            if (fractionDigits < 6){
+                fraction = fraction * 10 + (text[i] - '0');
+                fractionDigits++;
+            }
+        }
+    }
+    for (; fractionDigits < 6; ++fractionDigits) fraction *= 10;
+    microseconds = value * kMicrosecondsPerSecond + fraction;
+    return true;
+}
+/**
+ *  Function:   parseTimeOfDay
+ *              Reads "hh:mm:ss" with an optional fraction of a second after a '.' or ','
+ *
+ *  @param text - field to read
+ *  @param microseconds - written with the microseconds since midnight
+ *  @return false if the field is not a time of day
+ */
+
+inline std::string formatNumber(double value, int decimals){
+    char buffer[32];
+    return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, decimals).ptr);
+}
+/**
+ *  Function:   formatNumber
+ *              Formats a value with a fixed number of decimals
+ */
+
+#endif
@@ -0,0 +1,242 @@
+/**
+ * @file: time_align.h
+ * @date: 10/16/2026
+ * @brief: Pairs drone and Ublox epochs by UTC time instead of by row number. The two time sorted streams are
+ *         merge-joined: every epoch of the primary stream is matched to the nearest epoch of the secondary
+ *         stream when the two are within a tolerance, and left unmatched otherwise, so a dropped epoch no
+ *         longer shifts the rest of the flight. Epochs are pushed in one at a time and only the few epochs
+ *         around the current time are held, so both streams can be read straight from their files.
+ *         The drone clock is local time; droneClockOffset converts it to UTC (the old "+ 4" hours for EDT,
+ *         adjusted by any leap seconds).
+ */
+
+#ifndef TIME_ALIGN_H
+#define TIME_ALIGN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <string>
+#include "geodesy.h"
+#include "telemetry_store.h"
+#include "run_metrics.h"
+
+struct AlignmentOptions{
+    std::int64_t tolerance = kMicrosecondsPerSecond / 2;        /// Largest time difference that still pairs two epochs
+    double utcOffsetHours = 4;                                  /// Hours the drone clock is behind UTC
+    double leapSeconds = 0;                                     /// Seconds subtracted from the UTC offset
+    std::int64_t droneClockOffset = 4 * 3600 * kMicrosecondsPerSecond; /// Added to drone times to get UTC, from the two above
+};
+
+inline bool parseAlignmentOption(int &argumentIndex, int argc, char *argv[], AlignmentOptions &options){
+    std::string argument = argv[argumentIndex];
+    if (argumentIndex + 1 >= argc) return false;
+    double value = std::atof(argv[argumentIndex + 1]);
+    if (argument == "--utc-offset") options.utcOffsetHours = value;
+    else if (argument == "--leap-seconds") options.leapSeconds = value;
+    else if (argument == "--tolerance") options.tolerance = static_cast<std::int64_t>(value * kMicrosecondsPerSecond);
+    else return false;
+    options.droneClockOffset = static_cast<std::int64_t>(options.utcOffsetHours * 3600 * kMicrosecondsPerSecond)
+                             - static_cast<std::int64_t>(options.leapSeconds * kMicrosecondsPerSecond);
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseAlignmentOption
+ *              Reads "--utc-offset hours", "--leap-seconds seconds", or "--tolerance seconds" from the command line
+ *
+ *              The offset and the leap seconds are kept apart and combined into droneClockOffset, so they can be
+ *              given in either order
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not an alignment option
+ */
+
+inline void applyClockOffset(TelemetryStore &data, std::int64_t offset){
+    for (std::size_t i = 0; i < data.size(); ++i) data.time[i] += offset;
+}
+
+template <class Epoch>
+class TimeAligner{
+public:
+    typedef std::function<void(const Epoch &primary, const Epoch *secondary)> MatchHandler;
+
+    TimeAligner(std::int64_t tolerance, MatchHandler handleMatch)
+        : tolerance(tolerance), handleMatch(handleMatch), lastPrimaryTime(INT64_MIN), matched(0), unmatched(0) {}
+
+    void addPrimary(const Epoch &epoch){
+        primaryQueue.push_back(epoch);
+        lastPrimaryTime = epoch.time;
+        resolve(false);
+    }
+
+    void addSecondary(const Epoch &epoch){
+        secondaryWindow.push_back(epoch);
+        resolve(false);
+    }
+
+    void finish(){ /// Called once both streams are exhausted
+        resolve(true);
+    }
+
+    void prune(std::int64_t nextPrimaryTime){ /// No primary epoch earlier than nextPrimaryTime is still to come
+        while (secondaryWindow.size() >= 2 && secondaryWindow[1].time <= nextPrimaryTime) secondaryWindow.pop_front();
+    }
+
+    long long matchedCount() const { return matched; }
+    long long unmatchedCount() const { return unmatched; }
+    std::size_t bufferedEpochs() const { return primaryQueue.size() + secondaryWindow.size(); }
+
+private:
+    void resolve(bool finished){
+        while (!primaryQueue.empty()){
+            const Epoch &primary = primaryQueue.front();
+            while (secondaryWindow.size() >= 2 && secondaryWindow[1].time <= primary.time) secondaryWindow.pop_front();
+            /// The nearest secondary epoch is only known once one at or after the primary epoch has arrived
+            if (!finished && (secondaryWindow.empty() || secondaryWindow.back().time < primary.time)) return;
+            const Epoch *nearest = nullptr;
+            std::int64_t nearestDifference = tolerance;
+            for (std::size_t i = 0; i < secondaryWindow.size() && i < 2; ++i){
+                std::int64_t difference = std::llabs(secondaryWindow[i].time - primary.time);
+                if (difference <= nearestDifference){
+                    nearest = &secondaryWindow[i];
+                    nearestDifference = difference;
+                }
+            }
+            handleMatch(primary, nearest);
+            if (nearest != nullptr) matched++;
+            else unmatched++;
+            primaryQueue.pop_front();
+        }
+        /// Later primary epochs are no earlier than the last one, so older secondary epochs can never match again
+        while (secondaryWindow.size() >= 2 && secondaryWindow[1].time <= lastPrimaryTime) secondaryWindow.pop_front();
+    }
+
+    std::int64_t tolerance;
+    MatchHandler handleMatch;
+    std::deque<Epoch> primaryQueue;
+    std::deque<Epoch> secondaryWindow;
+    std::int64_t lastPrimaryTime;
+    long long matched;
+    long long unmatched;
+};
+/**
+ *  Class:      TimeAligner
+ *              Streaming nearest-time merge-join. Epoch is any type with an int64 "time" member. Primary and
+ *              secondary epochs must each arrive in time order; handleMatch is called once per primary epoch,
+ *              in order, with the nearest secondary epoch or nullptr when none is within the tolerance. A driver
+ *              that knows the time of the next primary epoch calls prune, so the secondary epochs before the first
+ *              primary one are not all held.
+ */
+
+template <class Epoch, class PrimarySource, class SecondarySource>
+void mergeJoinByTime(PrimarySource nextPrimary, SecondarySource nextSecondary, TimeAligner<Epoch> &aligner){
+    Epoch primary, secondary;
+    bool havePrimary = nextPrimary(primary);
+    bool haveSecondary = nextSecondary(secondary);
+    while (havePrimary || haveSecondary){
+        if (haveSecondary && (!havePrimary || secondary.time <= primary.time)){
+            aligner.addSecondary(secondary);
+            if (havePrimary) aligner.prune(primary.time); /// The primary epoch being held is the earliest still to come
+            haveSecondary = nextSecondary(secondary);
+        }
+        else {
+            aligner.addPrimary(primary);
+            havePrimary = nextPrimary(primary);
+        }
+    }
+    aligner.finish();
+}
+/**
+ *  Function:   mergeJoinByTime
+ *              Pulls epochs from two sources in time order and feeds them to the aligner, which keeps memory
+ *              bounded by the epochs within the tolerance of the current time
+ *
+ *  @param nextPrimary - callable bool(Epoch &) that writes the next primary epoch, or returns false at the end
+ *  @param nextSecondary - callable bool(Epoch &) that writes the next secondary epoch, or returns false at the end
+ *  @param aligner - aligner that receives the epochs
+ */
+
+struct AlignedEpoch{
+    std::int64_t time;
+    std::size_t index;      /// Row in the primary store, unused for secondary epochs
+    double latitude;
+    double longitude;
+    double altitude;
+};
+
+template <class SecondarySource>
+long long alignLookAngles(TelemetryStore &primary, SecondarySource nextSecondary, bool primaryIsDrone, std::int64_t tolerance){
+    ScopedStageTimer timer("alignment");
+    double primaryLatitude[kGeodesyBatchSize], primaryLongitude[kGeodesyBatchSize], primaryAltitude[kGeodesyBatchSize];
+    double secondaryLatitude[kGeodesyBatchSize], secondaryLongitude[kGeodesyBatchSize], secondaryAltitude[kGeodesyBatchSize];
+    double heading[kGeodesyBatchSize], elevation[kGeodesyBatchSize], slantDistance[kGeodesyBatchSize];
+    std::size_t rows[kGeodesyBatchSize];
+    std::size_t pending = 0;
+    auto flush = [&](){ /// The receiver is always the origin of the look angles
+        if (primaryIsDrone) computeLookAngles(secondaryLatitude, secondaryLongitude, secondaryAltitude,
+                                              primaryLatitude, primaryLongitude, primaryAltitude, heading, elevation, slantDistance, pending);
+        else computeLookAngles(primaryLatitude, primaryLongitude, primaryAltitude,
+                               secondaryLatitude, secondaryLongitude, secondaryAltitude, heading, elevation, slantDistance, pending);
+        for (std::size_t i = 0; i < pending; ++i){
+            primary.heading[rows[i]] = heading[i];
+            primary.elevationAngle[rows[i]] = elevation[i];
+            primary.slantDistance[rows[i]] = slantDistance[i];
+        }
+        pending = 0;
+    };
+    TimeAligner<AlignedEpoch> aligner(tolerance, [&](const AlignedEpoch &epoch, const AlignedEpoch *match){
+        if (match == nullptr) return;
+        rows[pending] = epoch.index;
+        primaryLatitude[pending] = epoch.latitude;
+        primaryLongitude[pending] = epoch.longitude;
+        primaryAltitude[pending] = epoch.altitude;
+        secondaryLatitude[pending] = match->latitude;
+        secondaryLongitude[pending] = match->longitude;
+        secondaryAltitude[pending] = match->altitude;
+        if (++pending == kGeodesyBatchSize) flush();
+    });
+    std::size_t nextPrimaryIndex = 0;
+    TelemetryRecord entry;
+    mergeJoinByTime<AlignedEpoch>(
+        [&](AlignedEpoch &epoch){
+            if (nextPrimaryIndex == primary.size()) return false;
+            epoch.time = primary.time[nextPrimaryIndex];
+            epoch.index = nextPrimaryIndex;
+            epoch.latitude = primary.latitude[nextPrimaryIndex];
+            epoch.longitude = primary.longitude[nextPrimaryIndex];
+            epoch.altitude = primary.altitude[nextPrimaryIndex];
+            nextPrimaryIndex++;
+            return true;
+        },
+        [&](AlignedEpoch &epoch){
+            if (!nextSecondary(entry)) return false;
+            epoch.time = entry.time;
+            epoch.index = 0;
+            epoch.latitude = entry.latitude;
+            epoch.longitude = entry.longitude;
+            epoch.altitude = entry.altitude;
+            return true;
+        }, aligner);
+    flush();
+    timer.count(primary.size());
+    countRunMetric("unmatched epochs", aligner.unmatchedCount());
+    return aligner.unmatchedCount();
+}
+/**
+ *  Function:   alignLookAngles
+ *              Matches every epoch of a store to the nearest epoch in time of the other platform and fills the
+ *              store's heading, elevation angle, and slant distance. The other platform is streamed, so only
+ *              the store has to be held in memory. Unmatched epochs keep zeros.
+ *
+ *  @param primary - store whose geometry columns are written, with UTC times
+ *  @param nextSecondary - callable bool(TelemetryRecord &) that writes the next epoch of the other platform in
+ *                         UTC, or returns false at the end
+ *  @param primaryIsDrone - true when primary holds the drone and the secondary stream the Ublox receiver
+ *  @param tolerance - largest time difference in microseconds that still pairs two epochs
+ *  @return number of primary epochs without a match
+ */
+
+#endif
@@ -0,0 +1,316 @@
+/**
+ * @file: track_export.h
+ * @date: 10/16/2026
+ * @brief: Writes one track to every output format that was asked for in a single pass, so producing another
+ *         deliverable does not cost another parse. TelemetryExporter opens one sink per format chosen at run time
+ *         with --export and hands each batch of epochs to all of them; every sink formats into its own buffered
+ *         writer. The formats are CSV (the parse_srt.cc columns plus the look angles), GeoJSON (one Point Feature
+ *         per epoch), GPX (one track segment), and KML (kml_writer.h and track_lod.h). The KML sink is the only one
+ *         that keeps its epochs until it is closed, because its LookAt spans the whole track and simplification
+ *         and tiling need every epoch.
+ */
+
+#ifndef TRACK_EXPORT_H
+#define TRACK_EXPORT_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "telemetry_store.h"
+#include "pipeline.h"
+#include "drone_csv.h"
+#include "kml_writer.h"
+#include "track_lod.h"
+#include "run_metrics.h"
+
+enum ExportFormat : unsigned { kExportCsv = 1, kExportGeoJson = 2, kExportGpx = 4, kExportKml = 8 };
+
+const std::size_t kExportBatchSize = 4096;
+const std::size_t kExportRowMaxLength = 384;    /// Longest row, Feature, or trkpt of any format
+
+struct ExportOptions{
+    unsigned formats = kExportKml;  /// Bitwise or of ExportFormat; the tools wrote only KML before --export
+};
+
+inline bool parseExportOption(int &argumentIndex, int argc, char *argv[], ExportOptions &options){
+    if (std::string(argv[argumentIndex]) != "--export" || argumentIndex + 1 >= argc) return false;
+    std::string_view list = argv[argumentIndex + 1];
+    unsigned formats = 0;
+    while (!list.empty()){
+        std::size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        if (name == "csv") formats |= kExportCsv;
+        else if (name == "geojson") formats |= kExportGeoJson;
+        else if (name == "gpx") formats |= kExportGpx;
+        else if (name == "kml") formats |= kExportKml;
+        else if (name == "all") formats |= kExportCsv | kExportGeoJson | kExportGpx | kExportKml;
+        else return false;
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    if (formats == 0) return false;
+    options.formats = formats;
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseExportOption
+ *              Reads "--export csv,geojson,gpx,kml" (or "--export all") from the command line
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not a valid export option
+ */
+
+class TelemetrySink{
+public:
+    explicit TelemetrySink(const std::string &fileName) : name(fileName) {}
+    virtual ~TelemetrySink() {}
+    TelemetrySink(const TelemetrySink &) = delete;
+    TelemetrySink &operator=(const TelemetrySink &) = delete;
+
+    virtual bool fail() const = 0;
+    virtual void write(const TelemetryStore &data, std::size_t first, std::size_t last) = 0;
+    virtual bool close() = 0;
+
+    const std::string &fileName() const { return name; }
+
+private:
+    std::string name;
+};
+/**
+ *  Class:      TelemetrySink
+ *              One output file of an export. write receives epochs [first, last) of a store with UTC times and
+ *              computed geometry, in time order, and close completes the file and returns false if any of it
+ *              could not be written.
+ */
+
+/// Formats a value with a fixed number of decimals straight into a buffer
+inline char *writeFixed(char *buffer, double value, int decimals){
+    return std::to_chars(buffer, buffer + 40, value, std::chars_format::fixed, decimals).ptr;
+}
+
+inline char *writeText(char *buffer, std::string_view text){
+    std::memcpy(buffer, text.data(), text.size());
+    return buffer + text.size();
+}
+
+class CsvTelemetrySink : public TelemetrySink{
+public:
+    explicit CsvTelemetrySink(const std::string &fileName) : TelemetrySink(fileName) {
+        outs.open(fileName);
+        outs.write("TimeCode, Frame, DiffTime, Date, Time, Latitude, Longitude, Altitude, Heading, Elevation Angle, Slant Distance\n");
+    }
+
+    bool fail() const override { return outs.fail(); }
+
+    void write(const TelemetryStore &data, std::size_t first, std::size_t last) override {
+        for (std::size_t i = first; i < last; ++i){
+            char *row = outs.reserve(kExportRowMaxLength);
+            char *rowEnd = formatDroneCsvRow(data.record(i), row) - 1; /// Drops the line break to add the look angles
+            const double angles[] = {data.heading[i], data.elevationAngle[i], data.slantDistance[i]};
+            for (double value : angles) rowEnd = writeFixed(writeText(rowEnd, ", "), value, 6);
+            *rowEnd++ = '\n';
+            outs.commit(rowEnd);
+        }
+    }
+
+    bool close() override {
+        outs.close();
+        return !outs.fail();
+    }
+
+private:
+    BufferedFileWriter outs;
+};
+/**
+ *  Class:      CsvTelemetrySink
+ *              The parse_srt.cc CSV columns followed by Heading, Elevation Angle, and Slant Distance
+ */
+
+class GeoJsonTelemetrySink : public TelemetrySink{
+public:
+    explicit GeoJsonTelemetrySink(const std::string &fileName) : TelemetrySink(fileName), firstFeature(true) {
+        outs.open(fileName);
+        outs.write("{\"type\": \"FeatureCollection\", \"features\": [");
+    }
+
+    bool fail() const override { return outs.fail(); }
+
+    void write(const TelemetryStore &data, std::size_t first, std::size_t last) override {
+        for (std::size_t i = first; i < last; ++i){
+            char *feature = outs.reserve(kExportRowMaxLength);
+            char *position = writeText(feature, firstFeature ? "\n" : ",\n");
+            firstFeature = false;
+            position = writeText(position, "{\"type\": \"Feature\", \"geometry\": {\"type\": \"Point\", \"coordinates\": [");
+            position = writeFixed(position, data.longitude[i], 8);
+            position = writeFixed(writeText(position, ", "), data.latitude[i], 8);
+            position = writeFixed(writeText(position, ", "), data.altitude[i], 3);
+            position = writeText(position, "]}, \"properties\": {\"time\": \"");
+            position = formatIsoTimestamp(data.time[i], 6, position);
+            position = writeText(position, "\", \"frame\": ");
+            position = std::to_chars(position, position + 24, data.frame[i]).ptr;
+            position = writeFixed(writeText(position, ", \"heading\": "), data.heading[i], 6);
+            position = writeFixed(writeText(position, ", \"elevationAngle\": "), data.elevationAngle[i], 6);
+            position = writeFixed(writeText(position, ", \"slantDistance\": "), data.slantDistance[i], 3);
+            outs.commit(writeText(position, "}}"));
+        }
+    }
+
+    bool close() override {
+        outs.write("\n]}\n");
+        outs.close();
+        return !outs.fail();
+    }
+
+private:
+    BufferedFileWriter outs;
+    bool firstFeature;
+};
+/**
+ *  Class:      GeoJsonTelemetrySink
+ *              A FeatureCollection with one Point Feature per epoch, its time, frame, and look angles as properties
+ */
+
+class GpxTelemetrySink : public TelemetrySink{
+public:
+    GpxTelemetrySink(const std::string &fileName, const char *trackName) : TelemetrySink(fileName) {
+        outs.open(fileName);
+        outs.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<gpx version=\"1.1\" creator=\"OU-JUP-UAV-GNSS\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+                   "    <trk>\n        <name>");
+        outs.write(trackName);
+        outs.write("</name>\n        <trkseg>\n");
+    }
+
+    bool fail() const override { return outs.fail(); }
+
+    void write(const TelemetryStore &data, std::size_t first, std::size_t last) override {
+        for (std::size_t i = first; i < last; ++i){
+            char *point = outs.reserve(kExportRowMaxLength);
+            char *position = writeFixed(writeText(point, "            <trkpt lat=\""), data.latitude[i], 8);
+            position = writeFixed(writeText(position, "\" lon=\""), data.longitude[i], 8);
+            position = writeFixed(writeText(position, "\"><ele>"), data.altitude[i], 3);
+            position = formatIsoTimestamp(data.time[i], 6, writeText(position, "</ele><time>"));
+            outs.commit(writeText(position, "</time></trkpt>\n"));
+        }
+    }
+
+    bool close() override {
+        outs.write("        </trkseg>\n    </trk>\n</gpx>\n");
+        outs.close();
+        return !outs.fail();
+    }
+
+private:
+    BufferedFileWriter outs;
+};
+/**
+ *  Class:      GpxTelemetrySink
+ *              A GPX 1.1 track with one trkpt per epoch
+ */
+
+class KmlTelemetrySink : public TelemetrySink{
+public:
+    KmlTelemetrySink(const std::string &fileBase, const KmlTrackFormat &format, const KmlOutputOptions &options)
+        : TelemetrySink(fileBase + (options.kmz ? ".kmz" : ".kml")), fileBase(fileBase), format(format), options(options) {}
+
+    bool fail() const override { return false; }
+
+    void write(const TelemetryStore &data, std::size_t first, std::size_t last) override {
+        for (std::size_t i = first; i < last; ++i) track.append(data, i);
+    }
+
+    bool close() override { return writeTrackKml(fileBase, track, format, options); }
+
+private:
+    std::string fileBase;
+    const KmlTrackFormat &format;
+    KmlOutputOptions options;
+    TelemetryStore track;
+};
+/**
+ *  Class:      KmlTelemetrySink
+ *              Collects the epochs and writes them with writeTrackKml when closed
+ */
+
+/// Output file in the same folder as the input file, e.g. "dir/GPX File for name.gpx" for "dir/name"
+inline std::string exportFileName(const std::string &inputFileName, const char *prefix, const char *suffix){
+    std::size_t nameStart = inputFileName.find_last_of('/') + 1; /// Zero when there is no folder
+    return inputFileName.substr(0, nameStart) + prefix + inputFileName.substr(nameStart) + suffix;
+}
+
+class TelemetryExporter{
+public:
+    TelemetryExporter(const std::string &inputFileName, const KmlTrackFormat &format, const KmlOutputOptions &kmlOptions,
+                      const ExportOptions &options){
+        if (options.formats & kExportCsv) sinks.emplace_back(new CsvTelemetrySink(exportFileName(inputFileName, "CSV File for ", ".csv")));
+        if (options.formats & kExportGeoJson)
+            sinks.emplace_back(new GeoJsonTelemetrySink(exportFileName(inputFileName, "GeoJSON File for ", ".geojson")));
+        if (options.formats & kExportGpx)
+            sinks.emplace_back(new GpxTelemetrySink(exportFileName(inputFileName, "GPX File for ", ".gpx"), format.name));
+        if (options.formats & kExportKml)
+            sinks.emplace_back(new KmlTelemetrySink(exportFileName(inputFileName, "KML File for ", ""), format, kmlOptions));
+    }
+
+    bool fail() const {
+        for (const std::unique_ptr<TelemetrySink> &sink : sinks){
+            if (sink->fail()) return true;
+        }
+        return false;
+    }
+
+    void write(const TelemetryStore &data, std::size_t first, std::size_t last){
+        for (std::size_t start = first; start < last; start += kExportBatchSize){ /// A batch stays in cache for every sink
+            std::size_t end = last - start < kExportBatchSize ? last : start + kExportBatchSize;
+            for (const std::unique_ptr<TelemetrySink> &sink : sinks) sink->write(data, start, end);
+        }
+    }
+
+    bool close(){
+        bool closed = true;
+        for (const std::unique_ptr<TelemetrySink> &sink : sinks) closed = sink->close() && closed;
+        return closed;
+    }
+
+    std::vector<std::string> fileNames() const {
+        std::vector<std::string> names;
+        for (const std::unique_ptr<TelemetrySink> &sink : sinks) names.push_back(sink->fileName());
+        return names;
+    }
+
+private:
+    std::vector<std::unique_ptr<TelemetrySink>> sinks;
+};
+/**
+ *  Class:      TelemetryExporter
+ *              Fans one stream of epochs out to a sink per chosen format. The files are named after the input and
+ *              written beside it: "CSV File for <input>.csv", "GeoJSON File for <input>.geojson", "GPX File for <input>.gpx", and
+ *              "KML File for <input>.kml" (or .kmz, or tiles, as the KML options ask).
+ */
+
+inline bool exportTrack(const std::string &inputFileName, const TelemetryStore &data, const KmlTrackFormat &format,
+                        const KmlOutputOptions &kmlOptions, const ExportOptions &options, std::vector<std::string> *fileNames = nullptr){
+    if (data.empty()) return false;
+    ScopedStageTimer timer("export");
+    timer.count(data.size());
+    TelemetryExporter exporter(inputFileName, format, kmlOptions, options);
+    if (fileNames != nullptr) *fileNames = exporter.fileNames();
+    if (exporter.fail()) return false;
+    exporter.write(data, 0, data.size());
+    return exporter.close();
+}
+/**
+ *  Function:   exportTrack
+ *              Writes a whole track to every format in options in one pass over the store
+ *
+ *  @param inputFileName - file the track was read from, which the outputs are named after
+ *  @param data - epochs with UTC times and computed geometry
+ *  @param format - kDroneTrackFormat or kUbloxTrackFormat, for the KML File and the GPX track name
+ *  @param fileNames - optional list that will be written with the main file of each format
+ *  @return false if the track is empty or any file could not be written
+ */
+
+#endif
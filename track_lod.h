@@ -0,0 +1,287 @@
+/**
+ * @file: track_lod.h
+ * @date: 10/16/2026
+ * @brief: Level of detail for the KML tracks, so Google Earth stays interactive on hour long full rate flights.
+ *         simplifyTrack drops the epochs that a time-aware Douglas-Peucker pass on the East, North, Up track shows
+ *         to be within a tolerance of the track through the epochs that are kept: an epoch is measured against the
+ *         position interpolated at its own time, so hovering and changes of speed are kept along with turns.
+ *         writeRegionatedKml splits a long track into tiles bounded in time and in space. Each tile is its own
+ *         KML File behind a NetworkLink with a Region, so Google Earth only loads the tiles on screen, and the
+ *         main file draws a coarse overview of the flight that hides once the viewer zooms in.
+ */
+
+#ifndef TRACK_LOD_H
+#define TRACK_LOD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include "geodesy.h"
+#include "telemetry_store.h"
+#include "kml_writer.h"
+#include "run_metrics.h"
+
+const double kKmlTileMaxExtent = 1000.0;        /// Largest east or north extent of a tile in meters
+const double kKmlOverviewTolerance = 5.0;       /// Smallest simplification tolerance of the overview in meters
+const double kKmlRegionPadding = 0.0001;        /// Degrees added around a tile, so a hovering tile still has an area
+const int kKmlTileMinLodPixels = 256;           /// A tile loads once its Region covers this many pixels
+const int kKmlOverviewMaxLodPixels = 1024;      /// The overview hides once the whole flight covers this many pixels
+
+struct KmlOutputOptions{
+    bool kmz = false;               /// Writes compressed KMZ instead of KML Files
+    double simplifyTolerance = 0;   /// Meters an epoch may be from the simplified track, 0 keeps every epoch
+    double tileSeconds = 0;         /// Longest tile of a regionated track, 0 writes a single document
+};
+
+inline bool parseKmlOutputOption(int &argumentIndex, int argc, char *argv[], KmlOutputOptions &options){
+    std::string argument = argv[argumentIndex];
+    if (argument == "--kmz"){
+        options.kmz = true;
+        return true;
+    }
+    if (argumentIndex + 1 >= argc) return false;
+    double value = std::atof(argv[argumentIndex + 1]);
+    if (argument == "--simplify") options.simplifyTolerance = value;
+    else if (argument == "--tiles") options.tileSeconds = value;
+    else return false;
+    argumentIndex++;
+    return true;
+}
+/**
+ *  Function:   parseKmlOutputOption
+ *              Reads "--kmz", "--simplify meters", or "--tiles seconds" from the command line
+ *
+ *  @param argumentIndex - index of the option, moved past its value when the option is recognized
+ *  @return false if argv[argumentIndex] is not a KML output option
+ */
+
+inline void trackToEnu(const TelemetryStore &data, std::vector<double> &east, std::vector<double> &north, std::vector<double> &up){
+    std::size_t count = data.size();
+    east.resize(count); north.resize(count); up.resize(count);
+    if (count == 0) return;
+    double originX, originY, originZ;
+    llhToEcef(&data.latitude[0], &data.longitude[0], &data.altitude[0], &originX, &originY, &originZ, 1);
+    double x[kGeodesyBatchSize], y[kGeodesyBatchSize], z[kGeodesyBatchSize];
+    double batchX[kGeodesyBatchSize], batchY[kGeodesyBatchSize], batchZ[kGeodesyBatchSize];
+    double batchLatitude[kGeodesyBatchSize], batchLongitude[kGeodesyBatchSize];
+    std::fill(batchX, batchX + kGeodesyBatchSize, originX);
+    std::fill(batchY, batchY + kGeodesyBatchSize, originY);
+    std::fill(batchZ, batchZ + kGeodesyBatchSize, originZ);
+    std::fill(batchLatitude, batchLatitude + kGeodesyBatchSize, data.latitude[0]);
+    std::fill(batchLongitude, batchLongitude + kGeodesyBatchSize, data.longitude[0]);
+    for (std::size_t first = 0; first < count; first += kGeodesyBatchSize){
+        std::size_t batch = std::min(kGeodesyBatchSize, count - first);
+        llhToEcef(&data.latitude[first], &data.longitude[first], &data.altitude[first], x, y, z, batch);
+        ecefToEnu(batchX, batchY, batchZ, batchLatitude, batchLongitude, x, y, z,
+                  &east[first], &north[first], &up[first], batch);
+    }
+}
+/**
+ *  Function:   trackToEnu
+ *              Converts every epoch of a track to East, North, Up meters from its first epoch
+ */
+
+inline void simplifyTrack(const TelemetryStore &data, const std::vector<double> &east, const std::vector<double> &north,
+                          const std::vector<double> &up, double tolerance, std::vector<std::size_t> &kept){
+    std::size_t count = data.size();
+    kept.clear();
+    std::vector<char> keep(count, tolerance <= 0);
+    if (count > 0) keep[0] = keep[count - 1] = 1;
+    std::vector<std::pair<std::size_t, std::size_t>> segments;
+    if (count > 2 && tolerance > 0) segments.push_back(std::make_pair(0, count - 1));
+    double toleranceSquared = tolerance * tolerance;
+    while (!segments.empty()){ /// A stack instead of recursion, so a long flight cannot overflow the call stack
+        std::size_t first = segments.back().first, last = segments.back().second;
+        segments.pop_back();
+        double span = static_cast<double>(data.time[last] - data.time[first]);
+        double farthest = 0;
+        std::size_t farthestIndex = first;
+        for (std::size_t i = first + 1; i < last; ++i){
+            double fraction = span > 0 ? (data.time[i] - data.time[first]) / span : 0.5;
+            double dEast = east[i] - (east[first] + fraction * (east[last] - east[first]));
+            double dNorth = north[i] - (north[first] + fraction * (north[last] - north[first]));
+            double dUp = up[i] - (up[first] + fraction * (up[last] - up[first]));
+            double distanceSquared = dEast * dEast + dNorth * dNorth + dUp * dUp;
+            if (distanceSquared > farthest){
+                farthest = distanceSquared;
+                farthestIndex = i;
+            }
+        }
+        if (farthest <= toleranceSquared) continue;
+        keep[farthestIndex] = 1;
+        if (farthestIndex - first > 1) segments.push_back(std::make_pair(first, farthestIndex));
+        if (last - farthestIndex > 1) segments.push_back(std::make_pair(farthestIndex, last));
+    }
+    for (std::size_t i = 0; i < count; ++i){
+        if (keep[i]) kept.push_back(i);
+    }
+}
+/**
+ *  Function:   simplifyTrack
+ *              Time-aware Douglas-Peucker: keeps the first and last epochs, then repeatedly keeps the epoch farthest
+ *              from where the track between two kept epochs would be at its time, until every dropped epoch is
+ *              within the tolerance
+ *
+ *  @param east, north, up - the track in meters, from trackToEnu
+ *  @param tolerance - largest distance in meters of a dropped epoch, 0 or less keeps every epoch
+ *  @param kept - vector that will be written with the indices of the kept epochs in time order
+ */
+
+/// Writes the latitude and longitude bounds of epochs [first, last) as a Region shown between two Lod sizes
+inline void writeKmlRegion(KmlWriter &outs, const TelemetryStore &data, std::size_t first, std::size_t last,
+                           const KmlTrackFormat &format, int minLodPixels, int maxLodPixels, const char *indent){
+    double north = data.latitude[first], south = north, east = data.longitude[first], west = east;
+    for (std::size_t i = first + 1; i < last; ++i){
+        north = std::max(north, data.latitude[i]); south = std::min(south, data.latitude[i]);
+        east = std::max(east, data.longitude[i]); west = std::min(west, data.longitude[i]);
+    }
+    const char *names[4] = {"north", "south", "east", "west"};
+    double bounds[4] = {north + kKmlRegionPadding, south - kKmlRegionPadding, east + kKmlRegionPadding, west - kKmlRegionPadding};
+    outs.write(indent); outs.write("<Region>\n");
+    outs.write(indent); outs.write("    <LatLonAltBox>");
+    for (int i = 0; i < 4; ++i){
+        outs.write("<"); outs.write(names[i]); outs.write(">");
+        outs.writeFixed(bounds[i], format.coordinateDecimals);
+        outs.write("</"); outs.write(names[i]); outs.write(">");
+    }
+    outs.write("</LatLonAltBox>\n");
+    outs.write(indent); outs.write("    <Lod><minLodPixels>");
+    outs.writeFixed(minLodPixels, 0);
+    outs.write("</minLodPixels><maxLodPixels>");
+    outs.writeFixed(maxLodPixels, 0);
+    outs.write("</maxLodPixels></Lod>\n");
+    outs.write(indent); outs.write("</Region>\n");
+}
+
+/// Relative link from the main file to a tile, with the spaces of "KML File for ..." escaped
+inline std::string kmlLink(const std::filesystem::path &tileFile){
+    return kmlHref(tileFile.parent_path().filename().string() + "/" + tileFile.filename().string());
+}
+
+inline bool writeRegionatedKml(const std::string &fileBase, const TelemetryStore &data, const std::vector<double> &east,
+                               const std::vector<double> &north, const std::vector<double> &up,
+                               const KmlTrackFormat &format, const KmlOutputOptions &options){
+    const char *extension = options.kmz ? ".kmz" : ".kml";
+    std::filesystem::path tileFolder = fileBase + " tiles";
+    std::error_code error;
+    std::filesystem::create_directories(tileFolder, error);
+    if (error) return false;
+
+    std::vector<std::size_t> tileStarts; /// A tile runs to the start of the next one, inclusive, so the tiles join up
+    std::int64_t tileLength = static_cast<std::int64_t>(options.tileSeconds * kMicrosecondsPerSecond);
+    for (std::size_t first = 0; first + 1 < data.size() || tileStarts.empty(); ){
+        tileStarts.push_back(first);
+        double minimumEast = east[first], maximumEast = east[first], minimumNorth = north[first], maximumNorth = north[first];
+        std::size_t last = first + 1;
+        for (; last + 1 < data.size(); ++last){
+            minimumEast = std::min(minimumEast, east[last]); maximumEast = std::max(maximumEast, east[last]);
+            minimumNorth = std::min(minimumNorth, north[last]); maximumNorth = std::max(maximumNorth, north[last]);
+            if (data.time[last] - data.time[first] >= tileLength || maximumEast - minimumEast >= kKmlTileMaxExtent
+                || maximumNorth - minimumNorth >= kKmlTileMaxExtent) break;
+        }
+        first = last;
+    }
+    tileStarts.push_back(data.size() - 1);
+
+    KmlWriter outs;
+    for (std::size_t tile = 0; tile + 1 < tileStarts.size(); ++tile){
+        std::size_t first = tileStarts[tile], last = std::min(tileStarts[tile + 1] + 1, data.size());
+        outs.open((tileFolder / (std::to_string(tile) + extension)).string(), options.kmz);
+        if (outs.fail()) return false;
+        outs.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<kml xmlns= \"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+                   "<Document>\n");
+        outs.write(format.styles);
+        outs.write(format.placemarkOpen);
+        writeKmlTrack(outs, data, first, last, format);
+        outs.write("        </Placemark>\n</Document>\n</kml>");
+        if (!outs.close()) return false;
+    }
+
+    std::vector<std::size_t> overview;
+    simplifyTrack(data, east, north, up, std::max(kKmlOverviewTolerance, 10 * options.simplifyTolerance), overview);
+    TelemetryStore overviewData;
+    overviewData.reserve(overview.size());
+    for (std::size_t i = 0; i < overview.size(); ++i) overviewData.append(data, overview[i]);
+
+    outs.open(fileBase + extension, options.kmz);
+    if (outs.fail()) return false;
+    writeKmlLookAt(outs, data, format);
+    outs.write("<Document>\n");
+    outs.write(format.styles);
+    outs.write(format.placemarkOpen);
+    writeKmlRegion(outs, data, 0, data.size(), format, 0, kKmlOverviewMaxLodPixels, "        ");
+    writeKmlTrack(outs, overviewData, 0, overviewData.size(), format);
+    outs.write("        </Placemark>\n");
+    for (std::size_t tile = 0; tile + 1 < tileStarts.size(); ++tile){
+        std::size_t first = tileStarts[tile], last = std::min(tileStarts[tile + 1] + 1, data.size());
+        outs.write("    <NetworkLink>\n        <name>");
+        outs.write(format.name);
+        outs.write(" ");
+        outs.writeTimestamp(data.time[first], 0);
+        outs.write("</name>\n        <TimeSpan><begin>");
+        outs.writeTimestamp(data.time[first], format.timeDecimals);
+        outs.write("</begin><end>");
+        outs.writeTimestamp(data.time[last - 1], format.timeDecimals);
+        outs.write("</end></TimeSpan>\n");
+        writeKmlRegion(outs, data, first, last, format, kKmlTileMinLodPixels, -1, "        ");
+        outs.write("        <Link><href>");
+        outs.write(kmlLink(tileFolder / (std::to_string(tile) + extension)));
+        outs.write("</href><viewRefreshMode>onRegion</viewRefreshMode></Link>\n    </NetworkLink>\n");
+    }
+    outs.write("</Document>\n</kml>");
+    return outs.close();
+}
+/**
+ *  Function:   writeRegionatedKml
+ *              Writes fileBase.kml (or .kmz) with the overview and one NetworkLink per tile, and the tiles as
+ *              "fileBase tiles/0.kml", "fileBase tiles/1.kml", ... A tile ends when it spans tileSeconds or
+ *              kKmlTileMaxExtent meters east or north, whichever comes first.
+ *
+ *  @param fileBase - output file name without the extension
+ *  @param data - epochs with UTC times and computed geometry, already simplified
+ *  @param east, north, up - the track in meters, from trackToEnu
+ *  @return false if any file could not be written
+ */
+
+inline bool writeTrackKml(const std::string &fileBase, const TelemetryStore &data, const KmlTrackFormat &format,
+                          const KmlOutputOptions &options){
+    if (data.empty()) return false;
+    ScopedStageTimer timer("KML write");
+    timer.count(data.size());
+    std::vector<double> east, north, up;
+    const TelemetryStore *output = &data;
+    TelemetryStore simplified;
+    if (options.simplifyTolerance > 0 || options.tileSeconds > 0) trackToEnu(data, east, north, up);
+    if (options.simplifyTolerance > 0){
+        std::vector<std::size_t> kept;
+        simplifyTrack(data, east, north, up, options.simplifyTolerance, kept);
+        simplified.reserve(kept.size());
+        for (std::size_t i = 0; i < kept.size(); ++i){
+            simplified.append(data, kept[i]);
+            east[i] = east[kept[i]]; north[i] = north[kept[i]]; up[i] = up[kept[i]];
+        }
+        east.resize(kept.size()); north.resize(kept.size()); up.resize(kept.size());
+        output = &simplified;
+    }
+    if (options.tileSeconds > 0) return writeRegionatedKml(fileBase, *output, east, north, up, format, options);
+    KmlWriter outs;
+    outs.open(fileBase + (options.kmz ? ".kmz" : ".kml"), options.kmz);
+    if (outs.fail()) return false;
+    return writeKmlDocument(*output, outs, format);
+}
+/**
+ *  Function:   writeTrackKml
+ *              Writes a track as KML or KMZ, simplified and regionated as the options ask
+ *
+ *  @param fileBase - output file name without the extension, e.g. "KML File for Ublox GPS PVT Data.csv"
+ *  @param data - epochs with UTC times and computed geometry
+ *  @param format - kDroneTrackFormat or kUbloxTrackFormat
+ *  @return false if the track is empty or any file could not be written
+ */
+
+#endif
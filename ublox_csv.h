@@ -0,0 +1,257 @@
+/**
+ * @file: ublox_csv.h
+ * @date: 10/16/2026
+ * @brief: Tokenizer for the PVT CSV File exported by u-center ("Index,UTC,Lat,Lon,Alt (MSL)" plus any extra
+ *         columns u-center was told to export). Columns are mapped by their names in the header line, so the
+ *         row length and the column order do not matter. Delimiters are found 16 bytes at a time with SSE2
+ *         compares (a scalar loop is used on other targets) and numbers are decoded with from_chars straight
+ *         from the input buffer, so no std::string is built per row.
+ */
+
+#ifndef UBLOX_CSV_H
+#define UBLOX_CSV_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "telemetry_store.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const int kUbloxCsvMaxColumns = 64;
+
+struct UbloxCsvRecord{
+    long long index;
+    std::string_view time;  /// UTC time of day, "hh:mm:ss.sss"
+    std::string_view date;  /// UTC date, "mm/dd/yyyy"
+    std::int64_t utc;       /// Date and time as microseconds since 1970-01-01
+    double latitude;        /// Degrees
+    double longitude;       /// Degrees
+    double altitude;        /// Meters above mean sea level
+};
+
+struct UbloxCsvLayout{
+    int indexColumn = -1;
+    int utcColumn = -1;
+    int latitudeColumn = -1;
+    int longitudeColumn = -1;
+    int altitudeColumn = -1;
+    int columnsNeeded = 0;  /// One more than the highest mapped column
+};
+
+/// Strips spaces, quotes, and a trailing carriage return from a field
+inline std::string_view trimUbloxCsvField(const char *fieldBegin, const char *fieldEnd){
+    while (fieldBegin < fieldEnd && (*fieldBegin == ' ' || *fieldBegin == '"')) fieldBegin++;
+    while (fieldEnd > fieldBegin && (fieldEnd[-1] == ' ' || fieldEnd[-1] == '"' || fieldEnd[-1] == '\r')) fieldEnd--;
+    return std::string_view(fieldBegin, fieldEnd - fieldBegin);
+}
+
+inline bool mapUbloxCsvHeader(std::string_view headerLine, UbloxCsvLayout &layout){
+    int column = 0;
+    std::size_t fieldStart = 0;
+    for (std::size_t i = 0; i <= headerLine.size() && column < kUbloxCsvMaxColumns; ++i){
+        if (i < headerLine.size() && headerLine[i] != ',') continue;
+        std::string_view name = trimUbloxCsvField(headerLine.data() + fieldStart, headerLine.data() + i);
+        if (name == "Index") layout.indexColumn = column;
+        else if (name == "UTC") layout.utcColumn = column;
+        else if (name == "Lat") layout.latitudeColumn = column;
+        else if (name == "Lon") layout.longitudeColumn = column;
+        else if (name == "Alt (MSL)") layout.altitudeColumn = column;
+        column++;
+        fieldStart = i + 1;
+    }
+    int columns[] = {layout.indexColumn, layout.utcColumn, layout.latitudeColumn, layout.longitudeColumn, layout.altitudeColumn};
+    layout.columnsNeeded = 0;
+    for (int mapped : columns){
+        if (mapped < 0) return false;
+        if (mapped + 1 > layout.columnsNeeded) layout.columnsNeeded = mapped + 1;
+    }
+    return true;
+}
+/**
+ *  Function:   mapUbloxCsvHeader
+ *              Finds the Index, UTC, Lat, Lon, and Alt (MSL) columns in the header line. Alt (HAE) does not
+ *              stand in for Alt (MSL): the drone's altitudes are above mean sea level, and the ellipsoid height
+ *              differs by the geoid separation, tens of meters.
+ *
+ *  @param headerLine - first line of the CSV File
+ *  @param layout - column numbers that will be written for each field
+ *  @return false if one of the required columns is missing
+ */
+
+inline bool decodeUbloxCsvRecord(const std::string_view *fields, const UbloxCsvLayout &layout, UbloxCsvRecord &record){
+    std::string_view index = fields[layout.indexColumn];
+    if (std::from_chars(index.data(), index.data() + index.size(), record.index).ec != std::errc()) return false;
+    std::string_view utc = fields[layout.utcColumn];
+    std::size_t space = utc.find(' ');
+    if (space == std::string_view::npos) return false;
+    record.time = utc.substr(0, space);
+    record.date = trimUbloxCsvField(utc.data() + space, utc.data() + utc.size());
+    std::int64_t timeOfDay;
+    std::string_view date = record.date;
+    if (!parseTimeOfDay(record.time, timeOfDay) || date.size() != 10 || date[2] != '/' || date[5] != '/') return false;
+    int dateFields[3];
+    for (int i = 0; i < 3; ++i){
+        std::size_t start = i * 3, length = i == 2 ? 4 : 2;
+        if (std::from_chars(date.data() + start, date.data() + start + length, dateFields[i]).ptr != date.data() + start + length) return false;
+    }
+    record.utc = daysFromCivil(dateFields[2], dateFields[0], dateFields[1]) * kMicrosecondsPerDay + timeOfDay;
+    double *values[] = {&record.latitude, &record.longitude, &record.altitude};
+    int columns[] = {layout.latitudeColumn, layout.longitudeColumn, layout.altitudeColumn};
+    for (int i = 0; i < 3; ++i){
+        std::string_view field = fields[columns[i]];
+        const char *numberBegin = field.data() + (!field.empty() && field[0] == '+');
+        std::from_chars_result result = std::from_chars(numberBegin, field.data() + field.size(), *values[i]);
+        if (result.ec != std::errc() || result.ptr != field.data() + field.size()) return false;
+    }
+    return true;
+}
+/**
+ *  Function:   decodeUbloxCsvRecord
+ *              Converts the mapped fields of one row into a record
+ *
+ *  @param fields - trimmed fields of the row, indexed by column
+ *  @param layout - column numbers from mapUbloxCsvHeader
+ *  @param record - record that will be written with the row's values
+ *  @return false if a field could not be decoded
+ */
+
+template <class RecordHandler>
+long long parseUbloxCsv(const char *begin, const char *end, RecordHandler handleRecord, long long *malformedRecords = nullptr,
+                        const char *rowsBegin = nullptr){
+    const char *headerEnd = begin;
+    while (headerEnd < end && *headerEnd != '\n') headerEnd++;
+    UbloxCsvLayout layout;
+    if (!mapUbloxCsvHeader(std::string_view(begin, headerEnd - begin), layout)) return -1;
+
+    std::string_view fields[kUbloxCsvMaxColumns];
+    UbloxCsvRecord record;
+    long long recordCount = 0, malformedCount = 0;
+    int column = 0;
+    const char *fieldStart = std::max(headerEnd + (headerEnd < end), rowsBegin == nullptr ? begin : rowsBegin);
+    auto handleDelimiter = [&](const char *delimiter, bool endOfRow){
+        if (column < kUbloxCsvMaxColumns) fields[column] = trimUbloxCsvField(fieldStart, delimiter);
+        column++;
+        fieldStart = delimiter + 1;
+        if (!endOfRow) return;
+        if (column >= layout.columnsNeeded && decodeUbloxCsvRecord(fields, layout, record)){
+            handleRecord(record);
+            recordCount++;
+        }
+        else if (column > 1 || !fields[0].empty()) malformedCount++; /// Blank lines are not counted as malformed
+        column = 0;
+    };
+
+    const char *position = fieldStart;
+#if defined(__SSE2__)
+    const __m128i commas = _mm_set1_epi8(',');
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; position + 16 <= end; position += 16){
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, commas), _mm_cmpeq_epi8(chunk, newlines)));
+        while (mask != 0){
+            const char *delimiter = position + __builtin_ctz(mask);
+            handleDelimiter(delimiter, *delimiter == '\n');
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; position < end; ++position){
+        if (*position == ',' || *position == '\n') handleDelimiter(position, *position == '\n');
+    }
+    if (fieldStart < end) handleDelimiter(end, true); /// The last row may not end with a line break
+    if (malformedRecords != nullptr) *malformedRecords = malformedCount;
+    return recordCount;
+}
+/**
+ *  Function:   parseUbloxCsv
+ *              Tokenizes a u-center PVT CSV File held in memory and calls handleRecord for every complete row
+ *
+ *  @param begin - first byte of the file, which must be the header line
+ *  @param end - one past the last byte of the file
+ *  @param handleRecord - callable that takes a const UbloxCsvRecord &
+ *  @param malformedRecords - optional count of rows that were skipped because a field could not be decoded
+ *  @param rowsBegin - optional start of a line after the header; rows before it are not read, so a file that has
+ *                     grown can be parsed from where the last parse stopped
+ *  @return number of records handled, or -1 if the header is missing a required column
+ */
+
+inline long long loadUbloxCsv(TelemetryStore &store, const char *begin, const char *end, long long *malformedRecords = nullptr,
+                              const char *rowsBegin = nullptr){
+    TelemetryRecord entry;
+    store.reserve(store.size() + (end - (rowsBegin == nullptr ? begin : rowsBegin)) / 64); /// A u-center PVT row is about 60 characters long
+    return parseUbloxCsv(begin, end, [&](const UbloxCsvRecord &record){
+        entry.time = record.utc;
+        entry.frame = record.index;
+        entry.latitude = record.latitude;
+        entry.longitude = record.longitude;
+        entry.altitude = record.altitude;
+        store.append(entry);
+    }, malformedRecords, rowsBegin);
+}
+/**
+ *  Function:   loadUbloxCsv
+ *              Appends every row of a u-center PVT CSV File to a telemetry store. The Index column is kept as the frame.
+ *
+ *  @param store - store that will be appended to
+ *  @param begin - first byte of the file, which must be the header line
+ *  @param end - one past the last byte of the file
+ *  @param malformedRecords - optional count of rows that were skipped
+ *  @param rowsBegin - optional start of the first row to read, as for parseUbloxCsv
+ *  @return number of rows appended, or -1 if the header is missing a required column
+ */
+
+class UbloxCsvReader{
+public:
+    UbloxCsvReader(const char *begin, const char *end) : position(begin), end(end), malformedCount(0) {
+        const char *headerEnd = lineEnd(begin);
+        valid = mapUbloxCsvHeader(std::string_view(begin, headerEnd - begin), layout);
+        position = headerEnd + (headerEnd < end);
+    }
+
+    bool fail() const { return !valid; }
+
+    bool next(UbloxCsvRecord &record){
+        std::string_view fields[kUbloxCsvMaxColumns];
+        while (valid && position < end){
+            const char *rowEnd = lineEnd(position);
+            int column = 0;
+            const char *fieldStart = position;
+            for (const char *delimiter = position; column < kUbloxCsvMaxColumns; ++delimiter){
+                if (delimiter < rowEnd && *delimiter != ',') continue;
+                fields[column++] = trimUbloxCsvField(fieldStart, delimiter);
+                fieldStart = delimiter + 1;
+                if (delimiter == rowEnd) break;
+            }
+            position = rowEnd + (rowEnd < end);
+            if (column >= layout.columnsNeeded && decodeUbloxCsvRecord(fields, layout, record)) return true;
+            if (column > 1 || !fields[0].empty()) malformedCount++; /// Blank lines are not counted as malformed
+        }
+        return false;
+    }
+
+    long long malformedRecords() const { return malformedCount; }
+
+private:
+    const char *lineEnd(const char *from) const {
+        const char *found = static_cast<const char *>(std::memchr(from, '\n', end - from));
+        return found == nullptr ? end : found;
+    }
+
+    UbloxCsvLayout layout;
+    const char *position;
+    const char *end;
+    bool valid;
+    long long malformedCount;
+};
+/**
+ *  Class:      UbloxCsvReader
+ *              Reads a u-center PVT CSV File held in memory one row at a time. parseUbloxCsv is faster for
+ *              loading a whole file; this is for callers that merge the rows with another stream as they go.
+ */
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * @file: ubx_parser.h
+ * @date: 10/16/2026
+ * @brief: Decoder for raw UBX log files recorded from the Ublox receiver, so the PVT solution can be read without
+ *         exporting a CSV File from u-center first. Frames are found by their 0xB5 0x62 sync bytes, and a frame is
+ *         used only if its 8-bit Fletcher checksum matches. This skips the NMEA sentences and other messages that
+ *         a u-center log interleaves with UBX, as well as any corrupt bytes. Only NAV-PVT (class 0x01, id 0x07) is
+ *         decoded. It carries UTC time to the nanosecond, latitude and longitude to 1e-7 degrees, height in
+ *         millimeters, and the fix type, satellite count, and accuracy estimates that the CSV export leaves out.
+ *         Fields are read from the mapped bytes in place.
+ */
+
+#ifndef UBX_PARSER_H
+#define UBX_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "telemetry_store.h"
+
+const unsigned char kUbxSync1 = 0xB5;
+const unsigned char kUbxSync2 = 0x62;
+const unsigned char kUbxClassNav = 0x01;
+const unsigned char kUbxIdNavPvt = 0x07;
+const std::size_t kUbxFrameOverhead = 8;            /// Sync, class, id, and length before the payload, checksum after
+const std::size_t kUbxMaxPayloadLength = 8192;      /// Longer lengths are taken as a false sync
+const std::size_t kUbxNavPvtMinLength = 84;         /// NAV-PVT is 92 bytes; protocol 14 receivers send 84
+
+struct UbxPvtRecord{
+    std::uint32_t timeOfWeek;   /// GPS time of week in milliseconds
+    std::int64_t utc;           /// Microseconds since 1970-01-01
+    int fixType;                /// 0 no fix, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS and dead reckoning, 5 time only
+    int satellites;             /// Satellites used in the solution
+    double latitude;            /// Degrees
+    double longitude;           /// Degrees
+    double altitude;            /// Meters above mean sea level
+    double ellipsoidHeight;     /// Meters above the WGS-84 ellipsoid
+    double horizontalAccuracy;  /// Meters
+    double verticalAccuracy;    /// Meters
+};
+
+struct UbxFrame{
+    unsigned char messageClass;
+    unsigned char messageId;
+    const unsigned char *payload;
+    std::size_t length;
+};
+
+/// Little-endian fields of a payload, assembled byte by byte so the decoder does not depend on the host's byte order
+inline std::uint32_t ubxU2(const unsigned char *field){ return field[0] | field[1] << 8; }
+inline std::uint32_t ubxU4(const unsigned char *field){
+    return static_cast<std::uint32_t>(field[0]) | static_cast<std::uint32_t>(field[1]) << 8
+         | static_cast<std::uint32_t>(field[2]) << 16 | static_cast<std::uint32_t>(field[3]) << 24;
+}
+inline std::int32_t ubxI4(const unsigned char *field){ return static_cast<std::int32_t>(ubxU4(field)); }
+
+/// True if the file is named .ubx or starts with a UBX frame; u-center CSV Files start with their header line
+inline bool isUbxFile(const std::string &fileName, const char *begin, std::size_t length){
+    std::size_t dot = fileName.find_last_of('.');
+    if (dot != std::string::npos && fileName.size() - dot == 4){
+        const char *extension = fileName.c_str() + dot + 1;
+        if ((extension[0] | 0x20) == 'u' && (extension[1] | 0x20) == 'b' && (extension[2] | 0x20) == 'x') return true;
+    }
+    return length >= 2 && static_cast<unsigned char>(begin[0]) == kUbxSync1 && static_cast<unsigned char>(begin[1]) == kUbxSync2;
+}
+
+inline bool nextUbxFrame(const char *&position, const char *end, bool endOfData, UbxFrame &frame, long long &corruptFrames){
+    while (position < end){
+        const char *sync = static_cast<const char *>(std::memchr(position, kUbxSync1, end - position));
+        if (sync == nullptr){
+            position = end;
+            return false;
+        }
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(sync);
+        std::size_t available = end - sync;
+        if (available >= 2 && bytes[1] != kUbxSync2){
+            position = sync + 1;
+            continue;
+        }
+        std::size_t length = available >= 6 ? ubxU2(bytes + 4) : 0;
+        if (available < 6 || (length <= kUbxMaxPayloadLength && available < length + kUbxFrameOverhead)){
+            position = sync + endOfData; /// Not all here yet; at the end of the data it was a false sync
+            if (!endOfData) return false;
+            continue;
+        }
+        if (length > kUbxMaxPayloadLength){
+            position = sync + 1;
+            continue;
+        }
+        unsigned checksumA = 0, checksumB = 0;
+        for (std::size_t i = 2; i < length + 6; ++i){ /// Class, id, length, and payload
+            checksumA += bytes[i];
+            checksumB += checksumA;
+        }
+        if ((checksumA & 0xff) != bytes[length + 6] || (checksumB & 0xff) != bytes[length + 7]){
+            corruptFrames++;
+            position = sync + 1;
+            continue;
+        }
+        frame.messageClass = bytes[2];
+        frame.messageId = bytes[3];
+        frame.payload = bytes + 6;
+        frame.length = length;
+        position = sync + length + kUbxFrameOverhead;
+        return true;
+    }
+    return false;
+}
+/**
+ *  Function:   nextUbxFrame
+ *              Finds the next frame with a valid checksum at or after position
+ *
+ *  @param position - where the search starts; moved past the frame that is returned, or to the end of the data.
+ *                    If the data stops part way through a frame and endOfData is false, it is left on that
+ *                    frame's first sync byte, so the rest of the frame can be appended and the search resumed.
+ *  @param endOfData - true if no more bytes will follow end
+ *  @param frame - frame that will be written with the message class, id, and payload
+ *  @param corruptFrames - incremented for each frame whose checksum does not match
+ *  @return false once no complete frame is left
+ */
+
+inline bool decodeUbxNavPvt(const UbxFrame &frame, UbxPvtRecord &record){
+    if (frame.messageClass != kUbxClassNav || frame.messageId != kUbxIdNavPvt || frame.length < kUbxNavPvtMinLength) return false;
+    const unsigned char *payload = frame.payload;
+    unsigned validity = payload[11], flags = payload[21];
+    if ((validity & 0x03) != 0x03 || (flags & 0x01) == 0) return false; /// validDate and validTime, then gnssFixOK
+    record.timeOfWeek = ubxU4(payload);
+    int year = static_cast<int>(ubxU2(payload + 4)), month = payload[6], day = payload[7];
+    std::int64_t nanoseconds = ubxI4(payload + 16); /// Signed: the seconds field is rounded and nano corrects it
+    record.utc = makeTimestamp(year, month, day, payload[8], payload[9], payload[10], 0) + nanoseconds / 1000;
+    record.fixType = payload[20];
+    record.satellites = payload[23];
+    record.longitude = ubxI4(payload + 24) * 1e-7;
+    record.latitude = ubxI4(payload + 28) * 1e-7;
+    record.ellipsoidHeight = ubxI4(payload + 32) * 1e-3;
+    record.altitude = ubxI4(payload + 36) * 1e-3;
+    record.horizontalAccuracy = ubxU4(payload + 40) * 1e-3;
+    record.verticalAccuracy = ubxU4(payload + 44) * 1e-3;
+    return true;
+}
+/**
+ *  Function:   decodeUbxNavPvt
+ *              Decodes a NAV-PVT frame
+ *
+ *  @param frame - frame from nextUbxFrame
+ *  @param record - record that will be written with the solution
+ *  @return false if the frame is not NAV-PVT or the epoch has no valid UTC date and time or no valid fix
+ */
+
+template <class RecordHandler>
+long long parseUbxNavPvt(const char *begin, const char *end, RecordHandler handleRecord, long long *corruptFrames = nullptr,
+                         bool endOfData = true, std::size_t *completeLength = nullptr){
+    const char *position = begin;
+    long long recordCount = 0, corruptCount = 0;
+    UbxFrame frame;
+    UbxPvtRecord record;
+    while (nextUbxFrame(position, end, endOfData, frame, corruptCount)){
+        if (!decodeUbxNavPvt(frame, record)) continue;
+        handleRecord(record);
+        recordCount++;
+    }
+    if (corruptFrames != nullptr) *corruptFrames = corruptCount;
+    if (completeLength != nullptr) *completeLength = position - begin;
+    return recordCount;
+}
+/**
+ *  Function:   parseUbxNavPvt
+ *              Scans a UBX log held in memory and calls handleRecord for every NAV-PVT epoch with a valid fix
+ *
+ *  @param begin - first byte of the log, or of any part of it
+ *  @param end - one past the last byte
+ *  @param handleRecord - callable that takes a const UbxPvtRecord &
+ *  @param corruptFrames - optional count of frames that failed their checksum
+ *  @param endOfData - false if the log is still being written, so a frame cut off at end is left for later
+ *  @param completeLength - optional bytes up to the end of the last complete frame, where a later parse resumes
+ *  @return number of records handled
+ */
+
+inline long long loadUbx(TelemetryStore &store, const char *begin, const char *end, long long *corruptFrames = nullptr,
+                         bool endOfData = true, std::size_t *completeLength = nullptr){
+    TelemetryRecord entry;
+    store.reserve(store.size() + (end - begin) / 100); /// A NAV-PVT frame is 100 bytes; other messages only make this generous
+    return parseUbxNavPvt(begin, end, [&](const UbxPvtRecord &record){
+        entry.time = record.utc;
+        entry.frame = static_cast<std::int64_t>(store.size()) + 1; /// Counted like the Index of the CSV export
+        entry.latitude = record.latitude;
+        entry.longitude = record.longitude;
+        entry.altitude = record.altitude;
+        entry.fixType = record.fixType;
+        entry.satellites = record.satellites;
+        entry.horizontalAccuracy = record.horizontalAccuracy;
+        entry.verticalAccuracy = record.verticalAccuracy;
+        store.append(entry);
+    }, corruptFrames, endOfData, completeLength);
+}
+/**
+ *  Function:   loadUbx
+ *              Appends every NAV-PVT epoch of a UBX log to a telemetry store, with the same columns as the CSV
+ *              export plus the fix type, satellite count, and accuracies. Parameters are those of parseUbxNavPvt.
+ *
+ *  @return number of epochs appended
+ */
+
+/// End of the last complete frame of a log that is still being written
+inline std::size_t lastUbxFrameEnd(const char *begin, std::size_t length){
+    std::size_t completeLength = 0;
+    parseUbxNavPvt(begin, begin + length, [](const UbxPvtRecord &){}, nullptr, false, &completeLength);
+    return completeLength;
+}
+
+class UbxPvtReader{
+public:
+    UbxPvtReader(const char *begin, const char *end) : position(begin), end(end), corruptCount(0) {}
+
+    bool next(UbxPvtRecord &record){
+        UbxFrame frame;
+        while (nextUbxFrame(position, end, true, frame, corruptCount)){
+            if (decodeUbxNavPvt(frame, record)) return true;
+        }
+        return false;
+    }
+
+    long long corruptFrames() const { return corruptCount; }
+
+private:
+    const char *position;
+    const char *end;
+    long long corruptCount;
+};
+/**
+ *  Class:      UbxPvtReader
+ *              Reads the NAV-PVT epochs of a UBX log held in memory one at a time, for callers that merge them
+ *              with another stream as they go
+ */
+
+#endif
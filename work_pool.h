@@ -0,0 +1,68 @@
+/**
+ * @file: work_pool.h
+ * @date: 10/16/2026
+ * @brief: Work-stealing thread pool for running many independent jobs of very different lengths, such as the
+ *         flights of a test campaign. Every worker has its own deque of jobs; a worker that runs out takes the
+ *         front job of another worker's deque, so one long flight does not leave the other cores idle behind it.
+ */
+
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool{
+public:
+    explicit WorkStealingPool(unsigned threadCount) : queues(threadCount > 0 ? threadCount : 1) {}
+
+    void add(std::function<void()> job){ /// Jobs are dealt to the workers in turn
+        queues[nextQueue].jobs.push_back(std::move(job));
+        nextQueue = (nextQueue + 1) % queues.size();
+    }
+
+    void run(){
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < queues.size(); ++i) workers.emplace_back(&WorkStealingPool::work, this, i);
+        work(0); /// The calling thread is the first worker
+        for (std::size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    }
+
+private:
+    struct JobQueue{
+        std::mutex lock;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    bool takeJob(std::size_t queue, std::function<void()> &job){
+        std::lock_guard<std::mutex> guard(queues[queue].lock);
+        if (queues[queue].jobs.empty()) return false;
+        job = std::move(queues[queue].jobs.front());
+        queues[queue].jobs.pop_front();
+        return true;
+    }
+
+    void work(std::size_t self){
+        std::function<void()> job;
+        while (true){
+            bool found = takeJob(self, job);
+            for (std::size_t i = 1; !found && i < queues.size(); ++i) found = takeJob((self + i) % queues.size(), job);
+            if (!found) return; /// No job is added once run starts, so every deque being empty means the work is done
+            job();
+        }
+    }
+
+    std::vector<JobQueue> queues;
+    std::size_t nextQueue = 0;
+};
+/**
+ *  Class:      WorkStealingPool
+ *              Runs every added job once on threadCount threads. Add the longest jobs first: each worker starts
+ *              with its longest job and a thief also takes the longest job left in the deque it robs.
+ */
+
+#endif